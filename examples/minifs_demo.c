@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "minifs.h"
+
+// Exemplo da libminifs: cria, grava, relê e lista arquivos sem passar pela shell.
+// Uso: examples/minifs_demo [imagem]
+int main(int argc, char** argv){
+    int err = mfs_mount(argc > 1 ? argv[1] : NULL);
+    if (err){
+        printf("mfs_mount: %s\n", strerror(-err));
+        return 1;
+    }
+
+    mfs_mkdir("/docs");
+
+    int fd = mfs_open("/docs/notas.txt", MFS_O_WRONLY | MFS_O_CREAT | MFS_O_TRUNC);
+    if (fd < 0){
+        printf("mfs_open: %s\n", strerror(-fd));
+        mfs_unmount();
+        return 1;
+    }
+    const char* parts[] = { "primeira linha\n", "segunda linha\n", "terceira linha\n" };
+    for (int i = 0; i < 3; i++){
+        ssize_t n = mfs_write(fd, parts[i], strlen(parts[i]));
+        if (n < 0) printf("mfs_write: %s\n", strerror((int)-n));
+    }
+    mfs_close(fd);
+
+    // Leitura sequencial em pedaços pequenos e uma leitura posicional
+    char buf[64];
+    fd = mfs_open("/docs/notas.txt", MFS_O_RDONLY);
+    ssize_t n;
+    printf("conteudo:\n");
+    while ((n = mfs_read(fd, buf, 10)) > 0){
+        fwrite(buf, 1, (size_t)n, stdout);
+    }
+    n = mfs_pread(fd, buf, 13, 15);
+    if (n > 0) printf("pread(15): %.*s\n", (int)n, buf);
+
+    MfsStat st;
+    if (mfs_fstat(fd, &st) == 0){
+        printf("tamanho %zu, %d blocos, inode %d, permissoes %o\n",
+               st.size, st.blocks, st.inode, st.permissions);
+    }
+    mfs_close(fd);
+
+    // Erros voltam como -errno
+    printf("abrir inexistente: %s\n", strerror(-mfs_open("/docs/nada", MFS_O_RDONLY)));
+    printf("gravar em diretorio: %s\n", strerror(-mfs_open("/docs", MFS_O_WRONLY)));
+
+    fd = mfs_open("/docs", MFS_O_RDONLY);
+    MfsDirent entry;
+    while (mfs_readdir(fd, &entry) > 0){
+        printf("%s %s (%zu bytes)\n", entry.is_dir ? "d" : "-", entry.name, entry.size);
+    }
+    mfs_close(fd);
+
+    mfs_unmount();
+    return 0;
+}
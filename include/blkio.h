@@ -0,0 +1,47 @@
+#ifndef BLKIO_H
+#define BLKIO_H
+
+#include <stddef.h>
+
+// E/S de blocos do disco simulado em um arquivo de imagem do host.
+//
+// Cada pedido recebe uma lista de índices de blocos; blocos consecutivos viram
+// uma única requisição e todas as requisições do lote são submetidas juntas
+// (até a profundidade da fila por vez) e concluídas antes do retorno.
+// O bloco i fica no deslocamento i * FS_BLOCK_SIZE tanto na imagem quanto na memória.
+
+#define BLKIO_DEFAULT_QUEUE_DEPTH 32
+#define BLKIO_MAX_THREADS         8    // Threads do modo pread/pwrite
+
+typedef struct {
+    long batches;    // Lotes submetidos
+    long requests;   // Requisições (faixas contíguas de blocos)
+    long blocks;     // Blocos transferidos
+    long syscalls;   // Chamadas io_uring_enter ou pread/pwrite
+    long errors;
+} BlkioStats;
+
+// Abre (ou cria) a imagem. use_uring = 0 força o modo pread/pwrite.
+// *existing_blocks recebe quantos blocos a imagem já tinha. Retorna 0 em sucesso.
+int  blkio_open(const char* path, int queue_depth, int use_uring, int* existing_blocks);
+int  blkio_is_open(void);
+void blkio_close(void);
+
+const char* blkio_path(void);
+const char* blkio_backend_name(void);
+int  blkio_queue_depth(void);
+
+// Ajusta o tamanho da imagem (blocos novos leem como zero)
+int  blkio_resize(int total_blocks);
+
+// Lê/grava os blocos da lista entre a imagem e disk. Retorna 0 ou -1 (errno definido)
+int  blkio_read(char* disk, const int* indices, int count);
+int  blkio_write(const char* disk, const int* indices, int count);
+// Como blkio_write, com os blocos da lista um atrás do outro em buffer
+int  blkio_write_packed(const char* buffer, const int* indices, int count);
+// Garante na mídia o que já foi gravado na imagem (fdatasync)
+int  blkio_sync(void);
+
+void blkio_get_stats(BlkioStats* stats);
+
+#endif
@@ -1,18 +1,141 @@
-#ifndef BLOCKS_H
-#define BLOCKS_H
-
-#include <stddef.h>
-#include "fs.h"
-
-#define FS_BLOCK_SIZE 16
-#define FS_MAX_BLOCKS 256
-
-void blocks_init(void);
-void blocks_shutdown(void);
-
-int  blocks_alloc_for_file(FCB* fcb, const char* data, size_t len);
-void blocks_free_for_file(FCB* fcb);
-void blocks_dump_file(const FCB* fcb);
-void blocks_stats(int* total_blocks, int* used_blocks, int* free_blocks);
-
-#endif
+#ifndef BLOCKS_H
+#define BLOCKS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "fs.h"
+
+#define FS_BLOCK_SIZE 16
+#define FS_MAX_BLOCKS 256   // Tamanho padrão do disco (pode crescer com blocks_resize)
+#define FS_BLOCK_HOLE (-1)  // Entrada do mapa sem bloco (buraco): lê como zeros
+
+void blocks_init(void);
+void blocks_shutdown(void);
+
+// Aumenta o disco para total_blocks (nunca diminui). Retorna 0 em sucesso
+int  blocks_resize(int total_blocks);
+int  blocks_total(void);
+
+// Acesso direto a um bloco do disco e à sua contagem de referências
+char* blocks_data(int block_index);
+int   blocks_refcount(int block_index);
+// Corrige a contagem de referências de um bloco (usado pelo fsck)
+void  blocks_set_refcount(int block_index, int refcount);
+
+// Arquivos de até blocks_inline_threshold() bytes ficam dentro do FCB (inline_data), sem blocos
+void   blocks_set_inline_threshold(size_t max_bytes);
+size_t blocks_inline_threshold(void);
+int    blocks_inline_fits(size_t len);
+
+// Aloca blocos para len bytes sem gravar dados (o chamador preenche os blocos).
+// Arquivos pequenos passam a ser inline e o chamador preenche inline_data.
+int  blocks_reserve_for_file(FCB* fcb, size_t len);
+int  blocks_alloc_for_file(FCB* fcb, const char* data, size_t len);
+
+// Compressão transparente (LZ) em clusters de FS_CLUSTER_SIZE bytes para as próximas gravações
+// (arquivos de até FCB_MAX_CLUSTERS clusters; os maiores ficam crus)
+void   blocks_set_compression(int enabled);
+int    blocks_compression_enabled(void);
+// Maior arquivo aceito por blocks_alloc_for_file (FS_MAX_FILE_BLOCKS blocos)
+size_t blocks_max_file_size(void);
+// Bytes ocupados nos blocos (igual a size para arquivos não comprimidos e sem buracos)
+size_t blocks_physical_size(const FCB* fcb);
+
+// Arquivos esparsos: blocos só de zeros não são gravados e ficam como buracos no mapa
+// (FS_BLOCK_HOLE). Blocos de fato alocados ao arquivo (buracos não contam)
+int  blocks_allocated(const FCB* fcb);
+// Blocos de len bytes com algum byte diferente de zero (os que uma gravação ocuparia)
+int  blocks_count_data(const char* data, size_t len);
+// Muda o tamanho do arquivo: solta os blocos depois do novo fim ou estende com um
+// buraco, mexendo só nas entradas afetadas do mapa. Retorna 0 ou -1 (sem espaço ou
+// maior que blocks_max_file_size)
+int  blocks_truncate_file(FCB* fcb, size_t size);
+
+// Lê len bytes do arquivo a partir de offset, descomprimindo só os clusters necessários.
+// Retorna os bytes lidos ou -1 em erro.
+ssize_t blocks_read_file(const FCB* fcb, size_t offset, char* buf, size_t len);
+
+// Copia os blocos de src para blocos novos de dst (com deduplicação ligada, apenas compartilha)
+int  blocks_copy_file(FCB* dst, const FCB* src);
+// Solta a referência do arquivo aos seus blocos (o bloco fica livre ao chegar a zero)
+void blocks_free_for_file(FCB* fcb);
+
+// Acrescenta uma referência a cada bloco do FCB (blocos compartilhados)
+void blocks_retain_file(const FCB* fcb);
+void blocks_dump_file(const FCB* fcb);
+
+// Troca blocos do arquivo por blocos idênticos já existentes (usado depois de leituras diretas)
+void blocks_dedup_file(FCB* fcb);
+// Solta os blocos só de zeros do arquivo, que viram buracos (também depois de leituras diretas)
+void blocks_punch_holes(FCB* fcb);
+// Preenche iov com as faixas do disco que formam o arquivo (blocos vizinhos são unidos).
+// Retorna a quantidade de entradas usadas ou -1 se os blocos não cobrem o arquivo
+// (ou se o arquivo está comprimido).
+int  blocks_file_iov(const FCB* fcb, struct iovec* iov, int max_iov);
+
+// Escreve o arquivo direto do disco simulado em fd com um único writev (ou um a cada 1024
+// faixas), seguido opcionalmente de trailer. Retorna bytes escritos ou -1 em erro.
+ssize_t blocks_writev_file(const FCB* fcb, int fd, const char* trailer, size_t trailer_len);
+
+void blocks_stats(int* total_blocks, int* used_blocks, int* free_blocks);
+// Como blocks_stats, somando também as referências (blocos lógicos) aos blocos usados
+void blocks_stats_refs(int* total_blocks, int* used_blocks, int* free_blocks, long* references);
+
+// Reserva uma faixa contígua de count blocos. Retorna o primeiro índice ou -1
+int  blocks_reserve_run(int count);
+
+// Associa ao FCB os blocos de uma faixa já reservada, a partir de first_block
+int  blocks_assign_run(FCB* fcb, int first_block, size_t len);
+
+// Grava len bytes crus em uma faixa contígua nova (blocos soltos se o disco estiver
+// fragmentado). Usado pela alocação adiada na descarga. Retorna 0 ou -1
+int  blocks_place_file(FCB* fcb, const char* data, size_t len);
+
+// Capacidade prometida sem escolher blocos (alocação adiada): as alocações comuns
+// só usam os blocos livres que sobram. Retorna 0 ou -1 se não houver espaço
+int  blocks_reserve_capacity(int count);
+void blocks_unreserve_capacity(int count);
+int  blocks_reserved(void);
+
+// Lê de fd direto para os blocos do arquivo (readv). Retorna bytes lidos ou -1
+ssize_t blocks_readv_file(FCB* fcb, int fd);
+
+// Lê count blocos de fd (a partir de offset) direto para a faixa já reservada em
+// first_block (restauração de checkpoint). *crc recebe o CRC32C da área lida inteira.
+// Retorna 0 ou -1 (errno definido; EIO se fd terminar antes)
+int  blocks_load_run(int first_block, int count, int fd, off_t offset, uint32_t* crc);
+
+// Checksums por bloco (CRC32C). Gravar só invalida o CRC do bloco; ele é recalculado
+// quando o bloco vai para a imagem ou pelo scrub. O CRC é conferido quando o bloco volta
+// da imagem (não nas leituras da memória): leituras de blocos corrompidos falham com EIO.
+int  blocks_verify_block(int block_index);   // 0 = íntegro, 1 = selado agora, -1 = CRC não confere
+long blocks_checksum_errors(void);           // Erros de CRC encontrados desde o início
+void blocks_set_checksums(int enabled);      // Usado pelo bench para medir o custo
+int  blocks_checksums_enabled(void);
+
+// Trava de quem muda blocos. A shell a segura durante cada comando e o scrub em
+// segundo plano a cada fatia de blocos que confere
+void blocks_lock(void);
+void blocks_unlock(void);
+
+// Arquivo de imagem no host por trás do disco simulado (--image). A memória passa a
+// ser um cache de escrita adiada: gravações só marcam os blocos como sujos e uma thread
+// de descarga os leva para a imagem em lotes ordenados (blkio); blocos fora da memória
+// são lidos dela, em lote, no primeiro acesso.
+int  blocks_attach_image(const char* path, int queue_depth, int use_uring); // 0 = sucesso
+// Descarta a cópia em memória dos blocos limpos. Retorna quantos saíram ou -1 sem imagem
+int  blocks_drop_cache(void);
+// Grava todos os blocos sujos e espera a imagem chegar à mídia. Retorna 0 ou -1
+int  blocks_sync(void);
+// Blocos sujos agora, descargas feitas e blocos gravados por elas
+void blocks_writeback_stats(int* dirty, long* rounds, long* written);
+// Garante na memória os blocos [first_block, first_block + count) (usado pelo scrub)
+void blocks_fetch_range(int first_block, int count);
+long blocks_image_errors(void);
+// Leitura antecipada: blocos pedidos à frente, os que foram lidos depois (acertos)
+// e os descartados ou regravados sem terem sido lidos (desperdício)
+void blocks_readahead_stats(long* issued, long* hits, long* waste);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stddef.h>
+#include "fs.h"
+
+// Checkpoint binário do namespace inteiro: árvore, FCBs, mapa de blocos e dados.
+//
+// Formato (inteiros do cabeçalho em little-endian):
+//   cabeçalho fixo   -> assinatura, contagens, cotas por usuário e os CRCs das duas áreas
+//   tabela           -> tamanho de cada fatia de CHECKPOINT_CHUNK_NODES nós; os nós em
+//                       pré-ordem (distância até o pai, nome e metadados em varints);
+//                       e o mapa de blocos (referências de cada bloco)
+//   área de blocos   -> os blocos crus, compactados: só os usados pela árvore, na ordem
+//                       em que aparecem nos FCBs
+// Snapshots, opções e o cache em memória não entram. Os blocos dos arquivos com
+// alocação adiada são alocados antes da gravação.
+//
+// A restauração reserva uma única faixa do disco para todos os blocos e a lê direto
+// do arquivo enquanto um pool de threads recria os nós, uma fatia da tabela por tarefa.
+
+#define CHECKPOINT_CHUNK_NODES 4096
+
+typedef struct {
+    long   dirs;          // Diretórios (sem contar a raíz)
+    long   files;
+    long   blocks;        // Blocos na área de dados
+    size_t bytes;         // Tamanho do checkpoint
+    double seconds;
+} CheckpointStats;
+
+// Grava o namespace em path. Retorna 0 ou -1 (errno definido; ENOSPC se os arquivos
+// com alocação adiada não couberem no disco)
+int checkpoint_save(const char* path, CheckpointStats* stats);
+
+// Recria o namespace de path dentro da raíz, que deve estar vazia. threads <= 0 usa
+// o padrão do pool. Retorna 0 ou -1 (errno definido; EBADMSG para checkpoint inválido
+// ou corrompido, ENOTEMPTY se a raíz já tiver filhos)
+int checkpoint_restore(const char* path, int threads, CheckpointStats* stats);
+
+#endif
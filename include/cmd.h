@@ -1,8 +1,11 @@
-#ifndef CMD_H
-#define CMD_H
-
-void cmd_handle(int argc, char** argv);
-
-void cmd_help(void);
-
-#endif
+#ifndef CMD_H
+#define CMD_H
+
+void cmd_handle(int argc, char** argv);
+
+void cmd_help(void);
+
+// Resultados de jobs em segundo plano (scrub) que terminaram; a shell chama antes do prompt
+void cmd_report_background(void);
+
+#endif
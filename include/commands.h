@@ -1,20 +1,46 @@
-#ifndef COMMANDS_H
-#define COMMANDS_H
-
-void cmd_pwd();
-void cmd_mkdir(int argc, char** argv);
-void cmd_ls(int argc, char** argv);
-void cmd_cd(int argc, char** argv);
-void cmd_touch(int argc, char** argv);
-void cmd_write(int argc, char** argv);
-void cmd_cat(int argc, char** argv);
-void cmd_cp(int argc, char** argv);
-void cmd_mv(int argc, char** argv);
-void cmd_rm(int argc, char** argv);
-void cmd_chmod(int argc, char** argv);
-void cmd_user(int argc, char** argv);
-void cmd_whoami();
-void cmd_stat(int argc, char** argv);
-void cmd_df();
-
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include "fs.h"
+
+void cmd_pwd();
+void cmd_mkdir(int argc, char** argv);
+void cmd_ls(int argc, char** argv);
+void cmd_cd(int argc, char** argv);
+void cmd_touch(int argc, char** argv);
+void cmd_write(int argc, char** argv);
+void cmd_truncate(int argc, char** argv);
+void cmd_cat(int argc, char** argv);
+void cmd_cp(int argc, char** argv);
+void cmd_mv(int argc, char** argv);
+void cmd_rm(int argc, char** argv);
+void cmd_chmod(int argc, char** argv);
+void cmd_user(int argc, char** argv);
+void cmd_whoami();
+void cmd_stat(int argc, char** argv);
+void cmd_df();
+void cmd_du(int argc, char** argv);
+void cmd_quota(int argc, char** argv);
+void cmd_dedup(int argc, char** argv);
+void cmd_compress(int argc, char** argv);
+void cmd_inline(int argc, char** argv);
+void cmd_scrub(int argc, char** argv);
+void cmd_scrub_notify(void);
+void cmd_bench(int argc, char** argv);
+void cmd_fsck(int argc, char** argv);
+void cmd_meminfo();
+void cmd_trace(int argc, char** argv);
+void cmd_find(int argc, char** argv);
+void cmd_import(int argc, char** argv);
+void cmd_export(int argc, char** argv);
+void cmd_dropcache();
+void cmd_sync();
+void cmd_checkpoint(int argc, char** argv);
+void cmd_snapshot(int argc, char** argv);
+void cmd_rollback(int argc, char** argv);
+void cmd_snapshot_rm(int argc, char** argv);
+
+// Mensagem de cota excedida (over = diretório estourado; NULL = cota do usuário)
+void cmd_report_quota(const char* cmd, const FsNode* over);
+
 #endif
\ No newline at end of file
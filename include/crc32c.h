@@ -0,0 +1,26 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC32C (polinômio de Castagnoli, o mesmo da instrução crc32 do SSE4.2).
+// Usa a instrução de hardware quando a CPU oferece e uma tabela caso contrário.
+
+// Escolhe a implementação e monta a tabela. Deve ser chamada antes do primeiro uso
+void crc32c_init(void);
+
+// Continua um CRC a partir de crc (use 0 para começar)
+uint32_t crc32c(uint32_t crc, const void* data, size_t len);
+
+// Calcula o CRC de vários blocos do mesmo tamanho de uma vez: out[i] = crc32c(base + indices[i] * block_size).
+// Uma única chamada por arquivo evita o custo de despacho por bloco.
+void crc32c_blocks(const char* base, size_t block_size, const int* indices, int count, uint32_t* out);
+
+// Versão por tabela, sempre disponível (usada também para comparação no bench)
+uint32_t crc32c_sw(uint32_t crc, const void* data, size_t len);
+
+// 1 se a instrução de hardware está em uso
+int crc32c_hw_enabled(void);
+
+#endif
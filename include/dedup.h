@@ -0,0 +1,41 @@
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Deduplicação de blocos em linha.
+// Cada bloco gravado recebe uma impressão digital (hash rápido não criptográfico);
+// um índice impressão -> bloco permite reaproveitar blocos com conteúdo idêntico.
+// Toda coincidência de hash é confirmada byte a byte antes do compartilhamento.
+
+int  dedup_enabled(void);
+
+// Liga a deduplicação, indexando os blocos já usados. Retorna 0 em sucesso
+int  dedup_enable(void);
+void dedup_disable(void);
+
+// Ajusta o índice ao novo tamanho do disco
+int  dedup_resize(int total_blocks);
+
+uint64_t dedup_fingerprint(const char* data, size_t len);
+
+// Procura um bloco com exatamente o conteúdo indicado (FS_BLOCK_SIZE bytes). Retorna o índice ou -1
+int  dedup_lookup(const char* block_data);
+
+// Adiciona/remove um bloco do índice
+void dedup_insert(int block_index);
+void dedup_forget(int block_index);
+
+// Quantos blocos deixaram de ser gravados por já existirem no disco
+long dedup_hits(void);
+
+// Referências que a deduplicação criou: uma a mais em um bloco existente, e a contagem
+// do bloco depois de soltar uma referência. Blocos economizados agora (a soma delas)
+void dedup_note_share(int block_index);
+void dedup_note_release(int block_index, int refcount);
+long dedup_saved_blocks(void);
+
+void dedup_shutdown(void);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef DELALLOC_H
+#define DELALLOC_H
+
+#include <stddef.h>
+#include "fs.h"
+
+// Alocação adiada de blocos.
+// Uma gravação só reserva capacidade (o df continua correto) e os dados ficam na cópia
+// em memória do FCB (fcb->content). Os blocos de verdade são escolhidos na descarga,
+// em uma faixa contígua do tamanho final do arquivo. Arquivos temporários apagados
+// antes da descarga nunca chegam ao alocador.
+
+// Pendências mais antigas que isto são descarregadas no próximo comando
+#define DELALLOC_EXPIRE_MS 1000
+// Descarrega tudo quando as reservas passam desta fração do disco (%)
+#define DELALLOC_RESERVE_RATIO 25
+
+// Grava fcb->content (fcb->size bytes). Arquivos inline, comprimidos ou com deduplicação
+// ligada são alocados na hora; os demais só reservam capacidade. Retorna 0 ou -1 (disco cheio)
+int  delalloc_write(FCB* fcb);
+
+// Reserva capacidade para len bytes de fcb, soltando os blocos atuais. Os dados
+// precisam estar em fcb->content antes da descarga. Retorna 0 ou -1 (disco cheio)
+int  delalloc_defer(FCB* fcb, size_t len);
+
+// Aumenta para len bytes a reserva de um arquivo que cresce no lugar (o chamador estende
+// fcb->content). Um arquivo pendente reserva só os blocos que faltam; um arquivo com blocos
+// passa a pendente. Retorna 0, 1 se o arquivo não pode ficar pendente (inline, compressão,
+// deduplicação: o chamador regrava tudo com delalloc_write) ou -1 (disco cheio; um arquivo
+// que não estava pendente fica sem os blocos antigos)
+int  delalloc_grow(FCB* fcb, size_t len);
+
+// Solta a reserva de um arquivo pendente sem alocar nada (arquivo apagado ou regravado)
+void delalloc_cancel(FCB* fcb);
+
+// Aloca agora os blocos de um arquivo pendente. Retorna 0 (ou se nada estava pendente) ou -1
+int  delalloc_commit(FCB* fcb);
+
+// Aloca os blocos de todos os arquivos pendentes. Retorna quantos foram descarregados
+int  delalloc_flush(void);
+
+// Chamado a cada comando: descarrega se a pendência mais antiga expirou ou as reservas
+// passaram de DELALLOC_RESERVE_RATIO % do disco
+void delalloc_tick(void);
+
+// Arquivos pendentes e blocos reservados por eles; descargas feitas e arquivos
+// cancelados antes de chegar ao alocador
+void delalloc_stats(int* pending, int* reserved, long* flushed, long* cancelled);
+
+void delalloc_shutdown(void);
+
+#endif
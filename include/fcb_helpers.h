@@ -1,12 +1,35 @@
-#ifndef FCB_HELPERS_H
-#define FCB_HELPERS_H
-
-#include "fs.h"
-
-// Cria um novo FCB com valores padrão
-FCB* create_fcb(const char* name, FileType type);
-
-// Libera memória de um FCB (incluindo conteúdo)
-void free_fcb(FCB* fcb);
-
-#endif
+#ifndef FCB_HELPERS_H
+#define FCB_HELPERS_H
+
+#include "fs.h"
+
+// Cria um novo FCB com valores padrão
+FCB* create_fcb(const char* name, FileType type);
+// O mesmo para um nome já internado (ex.: node->name), sem procurar na tabela de nomes
+FCB* create_fcb_interned(const char* name, FileType type);
+
+// Libera memória de um FCB (incluindo conteúdo)
+void free_fcb(FCB* fcb);
+
+// Mapa de blocos do arquivo: direct_blocks ou, acima de FCB_MAX_BLOCKS, o block_map
+int* fcb_blocks(const FCB* fcb);
+// Entradas que cabem no mapa atual
+int  fcb_map_capacity(const FCB* fcb);
+
+// Garante espaço no mapa para count blocos (as entradas novas valem -1), levando o mapa
+// para fora do FCB quando passa de FCB_MAX_BLOCKS. Retorna 0 ou -1 (grande demais ou sem memória)
+int  fcb_map_reserve(FCB* fcb, int count);
+
+// Volta ao mapa dentro do FCB (todas as entradas -1), liberando o block_map
+void fcb_map_release(FCB* fcb);
+
+// Maior número de inode já entregue
+int  fcb_inode_high_water(void);
+
+// Reserva um número de inode novo (usado pelo fsck para desfazer duplicatas)
+int  fcb_next_inode(void);
+
+// Os próximos inodes passam a vir depois de high_water (restauração de checkpoint)
+void fcb_reserve_inodes(int high_water);
+
+#endif
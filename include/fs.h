@@ -1,75 +1,106 @@
-#ifndef FS_H
-#define FS_H
-
-#include <stddef.h>
-#include <time.h>
-
-#define MAX_NAME_LEN 64
-#define PATH_MAX_LEN 1024
-#define MAX_TOKENS 32
-#define FCB_MAX_BLOCKS 32
-
-typedef enum {
-    NODE_DIR,
-    NODE_FILE
-} NodeType;
-
-typedef enum {
-    FILETYPE_TEXT,
-    FILETYPE_NUMERIC,
-    FILETYPE_BINARY,
-    FILETYPE_PROGRAM
-} FileType;
-
-// Usuários
-typedef enum {
-    USER_OWNER,
-    USER_GROUP,
-    USER_OTHER
-} UserClass;
-
-typedef struct FCB {
-    char name[MAX_NAME_LEN];
-    size_t  size;
-    FileType type;
-
-    time_t created_at;          // data/hora de criação
-    time_t modified_at;         // data/hora de modificação
-    time_t accessed_at;         // data/hora de último acesso
-
-    int inode;                  // Identificador único do nó no sistema de arquivos
-    unsigned int permissions;   // Permissões de acesso
-    UserClass owner;            // Classe do usuário proprietário
-
-    int blocks[FCB_MAX_BLOCKS]; // Blocos alocados para o arquivo
-    int block_count;            // Número de blocos alocados
-
-    char* content;              // Ponteiro para o conteúdo do arquivo na memória
-} FCB;
-
-typedef struct FsNode {
-    char name[MAX_NAME_LEN];
-    NodeType type;
-
-    struct FsNode* parent;       // Ponteiro para o nó pai
-    struct FsNode* first_child;  // Ponteiro para o primeiro filho (se for diretório)
-    struct FsNode* next_sibling; // Ponteiro para o próximo irmão
-        
-    FCB* fcb;                    // Ponteiro para o FCB (se for arquivo)
-} FsNode;
-
-
-extern FsNode* fs_root;
-extern FsNode* fs_current_dir;
-extern UserClass fs_current_user_class;
-
-// Inicializa o sistema de arquivos em memória
-void fs_init(void);
-
-// Libera recursos
-void fs_shutdown(void);
-
-// Loop principal da "shell" do mini FS
-void fs_shell_loop(void);
-
-#endif
+#ifndef FS_H
+#define FS_H
+
+#include <stddef.h>
+#include <time.h>
+
+#define MAX_NAME_LEN 64         // Limite de um nome, contando o '\0'
+#define PATH_MAX_LEN 1024
+#define MAX_TOKENS 32
+#define FCB_MAX_BLOCKS 32       // Entradas do mapa de blocos guardadas no próprio FCB
+#define FS_MAX_FILE_BLOCKS 4096 // Maior arquivo: 64 KB crus (o mapa passa para fora do FCB)
+#define FS_CLUSTER_SIZE 256     // Unidade de compressão (bytes lógicos por cluster)
+#define FCB_MAX_CLUSTERS 8      // Tamanho lógico máximo de um arquivo comprimido: 2 KB
+#define FCB_INLINE_MAX (FCB_MAX_BLOCKS * (int)sizeof(int)) // Espaço de blocks[] reaproveitado para dados inline
+
+typedef enum {
+    NODE_DIR,
+    NODE_FILE
+} NodeType;
+
+typedef enum {
+    FILETYPE_TEXT,
+    FILETYPE_NUMERIC,
+    FILETYPE_BINARY,
+    FILETYPE_PROGRAM
+} FileType;
+
+// Usuários
+typedef enum {
+    USER_OWNER,
+    USER_GROUP,
+    USER_OTHER
+} UserClass;
+
+typedef struct FCB {
+    const char* name;           // Nome internado, o mesmo registro do nó (fs_name.h)
+    size_t  size;
+    FileType type;
+
+    time_t created_at;          // data/hora de criação
+    time_t modified_at;         // data/hora de modificação
+    time_t accessed_at;         // data/hora de último acesso
+
+    int inode;                  // Identificador único do nó no sistema de arquivos
+    unsigned int permissions;   // Permissões de acesso
+    UserClass owner;            // Classe do usuário proprietário
+
+    union {
+        int  direct_blocks[FCB_MAX_BLOCKS]; // Mapa de blocos de arquivos pequenos (use fcb_blocks)
+        char inline_data[FCB_INLINE_MAX];   // Conteúdo de arquivos pequenos, guardado no próprio FCB
+    };
+    int* block_map;             // Mapa inteiro quando passa de FCB_MAX_BLOCKS (NULL = direct_blocks)
+    int block_count;            // Número de blocos alocados
+    int inlined;                // 1 = conteúdo em inline_data (nenhum bloco usado)
+
+    int compressed;                                 // 1 = os blocos guardam clusters comprimidos
+    unsigned short cluster_bytes[FCB_MAX_CLUSTERS]; // Bytes físicos de cada cluster (= lógico: cluster cru)
+    int delalloc;               // Posição + 1 na lista de alocação adiada (0 = blocos já definidos)
+
+    long usage_bytes;           // Quanto o arquivo já soma nos totais dos diretórios acima (fs_usage.h)
+    long usage_blocks;          // (FS_USAGE_DETACHED: fora da árvore)
+
+    char* content;              // Ponteiro para o conteúdo do arquivo na memória
+} FCB;
+
+// Totais de uma subárvore e cota, guardados em cada diretório (fs_usage.h)
+typedef struct FsUsage {
+    long bytes;                 // Tamanho lógico dos arquivos abaixo do diretório
+    long blocks;                // Blocos usados (ou reservados) por eles
+    long inodes;                // Arquivos e diretórios abaixo, sem contar o próprio
+    long max_blocks;            // Cota (0 = sem limite)
+    long max_inodes;
+} FsUsage;
+
+typedef struct FsNode {
+    const char* name;            // Nome internado (fs_name.h): tamanho e hash guardados junto
+    NodeType type;
+
+    struct FsNode* parent;       // Ponteiro para o nó pai
+    struct FsNode* first_child;  // Ponteiro para o primeiro filho (se for diretório)
+    struct FsNode* next_sibling; // Ponteiro para o próximo irmão
+        
+    FCB* fcb;                    // Ponteiro para o FCB (se for arquivo)
+    FsUsage* usage;              // Totais da subárvore (só diretórios; NULL em arquivos)
+
+    unsigned int born_epoch;     // Época de snapshot em que o nó foi criado
+    unsigned int snap_epoch;     // Última época em que o nó foi copiado por um snapshot
+
+    time_t lazy_atime;           // Acesso ainda não gravado no FCB (lazytime; 0 = nenhum)
+} FsNode;
+
+
+extern FsNode* fs_root;
+extern FsNode* fs_current_dir;
+extern UserClass fs_current_user_class;
+
+// Inicializa o sistema de arquivos em memória
+void fs_init(void);
+
+// Libera recursos
+void fs_shutdown(void);
+
+// Loop principal da "shell" do mini FS
+void fs_shell_loop(void);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef FS_BUILD_H
+#define FS_BUILD_H
+
+#include <stddef.h>
+#include "fs.h"
+
+// Resultado da construção em lote
+typedef struct {
+    int    dirs;          // Diretórios criados
+    int    files;         // Arquivos criados
+    int    skipped;       // Entradas ignoradas (tipo especial, nome/arquivo grande demais, erro)
+    int    blocks;        // Blocos atribuídos
+    size_t bytes;         // Bytes copiados do host
+    double seconds;       // Tempo total
+} FsBuildStats;
+
+// Constrói a árvore a partir de um diretório do host dentro de target (que deve estar vazio).
+// A varredura e a leitura dos arquivos rodam em um pool de threads; os blocos de
+// todos os arquivos são reservados de uma vez em uma faixa contígua.
+// Retorna 0 em sucesso ou -1 em erro.
+int fs_build_from_host(const char* host_dir, FsNode* target, int threads, FsBuildStats* stats);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef FS_GLOB_H
+#define FS_GLOB_H
+
+#include <stddef.h>
+#include "fs.h"
+
+// Estratégia escolhida na compilação do padrão
+typedef enum {
+    GLOB_LITERAL,        // "nome"        -> comparação direta
+    GLOB_ANY,            // "*"           -> qualquer nome
+    GLOB_PREFIX,         // "log*"        -> só compara o prefixo
+    GLOB_SUFFIX,         // "*.txt"       -> só compara o sufixo
+    GLOB_PREFIX_SUFFIX,  // "log*.txt"    -> prefixo + sufixo
+    GLOB_CONTAINS,       // "*tmp*"       -> busca de substring
+    GLOB_GENERIC         // Qualquer outro caso ('?', '[a-z]', vários '*')
+} GlobKind;
+
+// Padrão glob pré-compilado (*, ? e [a-z])
+typedef struct {
+    GlobKind kind;
+    char   text[MAX_NAME_LEN];   // Padrão original
+    size_t text_len;
+    char   literal[MAX_NAME_LEN]; // Parte literal usada pelos caminhos rápidos
+    size_t prefix_len;
+    size_t suffix_len;           // O sufixo fica em literal + prefix_len
+} FsGlob;
+
+// Conjunto de padrões avaliados juntos em uma única passada pelo diretório
+typedef struct {
+    FsGlob* globs;
+    int*    hits;                // Quantos nós cada padrão casou
+    int     count;
+} FsGlobSet;
+
+// Retorna 1 se o texto contém algum caractere especial de glob
+int fs_glob_has_magic(const char* text);
+
+// Compila um padrão. Retorna 0 em sucesso ou -1 se o padrão for inválido
+int fs_glob_compile(FsGlob* glob, const char* pattern);
+
+// Retorna 1 se o nome casa com o padrão
+int fs_glob_match(const FsGlob* glob, const char* name);
+
+// Compila vários padrões de uma vez. Retorna 0 em sucesso
+int  fs_globset_compile(FsGlobSet* set, char** patterns, int count);
+
+// Retorna o índice do primeiro padrão que casa com o nome, ou -1
+int  fs_globset_match(FsGlobSet* set, const char* name);
+
+void fs_globset_free(FsGlobSet* set);
+
+#endif
@@ -1,30 +1,39 @@
-#ifndef FS_HELPERS_H
-#define FS_HELPERS_H
-
-#include <stddef.h>
-#include "fs.h"
-
-void fcb_free(FCB* fcb);
-
-// Cria um novo nó
-FsNode* fs_create_node(const char* name, NodeType type, FsNode* parent);
-
-// Procura filho por nome
-FsNode* fs_find_child(FsNode* dir, const char* name);
-
-// Adiciona filho a um diretório
-void fs_add_child(FsNode* dir, FsNode* child);
-
-// Remove filho específico (e libera memória)
-void fs_remove_child(FsNode* dir, FsNode* child);
-
-// Libera árvore inteira
-void fs_free_tree(FsNode* node);
-
-// Monta o caminho absoluto de um nó em um buffer
-void fs_get_path(FsNode* node, char* buffer, size_t size);
-
-// Move um nó para um novo diretório pai
-void fs_move_node(FsNode* node, FsNode* new_parent);
-
+#ifndef FS_HELPERS_H
+#define FS_HELPERS_H
+
+#include <stddef.h>
+#include "fs.h"
+
+void fcb_free(FCB* fcb);
+
+// Cria um novo nó
+FsNode* fs_create_node(const char* name, NodeType type, FsNode* parent);
+
+// Procura filho por nome
+FsNode* fs_find_child(FsNode* dir, const char* name);
+
+// Adiciona filho a um diretório
+void fs_add_child(FsNode* dir, FsNode* child);
+
+// Remove filho específico (e libera memória)
+void fs_remove_child(FsNode* dir, FsNode* child);
+
+// Remove um filho cujo irmão anterior já é conhecido (NULL se for o primeiro)
+void fs_remove_child_after(FsNode* dir, FsNode* prev, FsNode* child);
+
+// Libera um único nó e seu FCB (sem os filhos)
+void fs_free_node(FsNode* node);
+
+// Libera árvore inteira
+void fs_free_tree(FsNode* node);
+
+// Monta o caminho absoluto de um nó em um buffer
+void fs_get_path(FsNode* node, char* buffer, size_t size);
+
+// Troca o nome do nó (e do seu FCB) por um nome internado
+void fs_rename_node(FsNode* node, const char* new_name);
+
+// Move um nó para um novo diretório pai
+void fs_move_node(FsNode* node, FsNode* new_parent);
+
 #endif
\ No newline at end of file
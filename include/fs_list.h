@@ -0,0 +1,35 @@
+#ifndef FS_LIST_H
+#define FS_LIST_H
+
+#include <stddef.h>
+#include "fs.h"
+
+// Motor de listagem do ls.
+// As linhas são montadas à mão em um buffer grande e saem com write() quando ele
+// enche, sem printf por entrada; as permissões vêm de uma tabela pronta com os 512
+// modos. A ordenação (-S, -t) ordena um vetor de índices (chave + nó) com radix sort,
+// sem mexer na lista de filhos. Sem ordenação as entradas saem direto da lista.
+
+typedef enum {
+    FS_LIST_SORT_NONE,      // Ordem do diretório
+    FS_LIST_SORT_SIZE,      // Maior primeiro (-S)
+    FS_LIST_SORT_TIME       // Modificado mais recentemente primeiro (-t)
+} FsListSort;
+
+typedef struct {
+    int        long_format; // -l: permissões, dono e tamanho
+    FsListSort sort;
+    size_t     offset;      // Entradas puladas antes da primeira listada (--offset)
+    size_t     limit;       // Máximo de entradas listadas (--limit; 0 = todas)
+} FsListOptions;
+
+// Filtro opcional: 1 = a entrada entra na listagem
+typedef int (*FsListFilter)(const FsNode* node, void* arg);
+
+// Lista os filhos de dir em fd. Retorna as entradas escritas ou -1 em erro
+long fs_list_dir(const FsNode* dir, const FsListOptions* opt, FsListFilter filter, void* arg, int fd);
+
+// Lista uma única entrada (ls de um arquivo). Retorna 0 ou -1
+int  fs_list_node(const FsNode* node, int long_format, int fd);
+
+#endif
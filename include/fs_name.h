@@ -0,0 +1,41 @@
+#ifndef FS_NAME_H
+#define FS_NAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Nomes internados.
+// Cada nome distinto é guardado uma única vez em uma arena, com o tamanho e o hash
+// calculados na criação, e compartilhado (com contagem de referências) pelos nós e
+// FCBs que o usam: um "index.txt" repetido em mil diretórios ocupa um registro só.
+// O ponteiro entregue aponta para o texto terminado em '\0', então node->name e
+// fcb->name continuam servindo como string comum; tamanho e hash ficam logo antes dele.
+
+// Devolve o nome internado (mais uma referência), truncado em MAX_NAME_LEN - 1 bytes.
+// Encerra o programa se faltar memória, como fs_create_node
+const char* fs_name_intern(const char* text);
+const char* fs_name_intern_len(const char* text, size_t len);
+
+// Dimensiona a tabela para mais count nomes de uma vez (restauração de checkpoint)
+void fs_name_reserve(long count);
+
+// Mais uma referência / uma a menos (o registro volta para a arena ao chegar a zero)
+const char* fs_name_retain(const char* name);
+void        fs_name_release(const char* name);
+
+// Tamanho e hash guardados no registro (sem strlen)
+size_t   fs_name_len(const char* name);
+uint32_t fs_name_hash(const char* name);
+
+// Hash usado pelos registros, para comparar um texto qualquer com nomes internados
+uint32_t fs_name_hash_text(const char* text, size_t len);
+
+// Compara primeiro o hash e o tamanho; só confere os bytes quando os dois batem
+int  fs_name_equals(const char* name, const char* text, size_t len, uint32_t hash);
+
+// Nomes distintos vivos, referências a eles e bytes ocupados na arena pelos registros vivos
+void fs_name_stats(long* distinct, long* references, long* bytes);
+
+void fs_name_shutdown(void);
+
+#endif
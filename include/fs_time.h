@@ -0,0 +1,49 @@
+#ifndef FS_TIME_H
+#define FS_TIME_H
+
+#include <time.h>
+#include "fs.h"
+
+// Política de atualização do horário de acesso (como as opções de montagem do Linux)
+typedef enum {
+    ATIME_STRICT,    // strictatime: toda leitura grava o acesso
+    ATIME_RELATIME,  // relatime: só grava se o acesso for anterior à modificação ou tiver mais de 24h
+    ATIME_NOATIME    // noatime: leituras nunca gravam o acesso
+} AtimeMode;
+
+#define FS_LAZYTIME_BATCH 64        // Acessos pendentes antes da gravação em lote
+#define FS_RELATIME_WINDOW (24 * 60 * 60)
+
+// Aplica opções separadas por vírgula (strictatime, relatime, noatime, lazytime).
+// Retorna 0 em sucesso ou -1 se alguma opção for desconhecida.
+int  fs_time_set_options(const char* options);
+
+// Descreve as opções atuais (ex.: "relatime,lazytime")
+void fs_time_describe(char* buffer, size_t size);
+
+// Relógio grosso em cache: atualizado uma vez por comando, lido sem chamada de sistema
+void   fs_clock_tick(void);
+time_t fs_clock_now(void);
+
+// Registra uma leitura do arquivo, conforme a política de acesso
+void fs_time_access(FsNode* node);
+
+// Registra uma modificação (grava modificação e acesso)
+void fs_time_modify(FCB* fcb);
+
+// Horário de acesso visto pelo usuário (inclui o pendente do lazytime)
+time_t fs_time_accessed(const FsNode* node);
+
+// Grava no FCB o acesso pendente de um nó (lazytime)
+void fs_time_flush_node(FsNode* node);
+
+// Grava todos os acessos pendentes. Retorna quantos foram gravados
+int  fs_time_flush(void);
+
+// Descarta o acesso pendente de um nó que vai ser liberado
+void fs_time_forget(FsNode* node);
+
+// Quantos acessos aguardam gravação
+int  fs_time_pending(void);
+
+#endif
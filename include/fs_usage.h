@@ -0,0 +1,53 @@
+#ifndef FS_USAGE_H
+#define FS_USAGE_H
+
+#include "fs.h"
+
+// Totais de uso por diretório e cotas.
+// Cada diretório guarda bytes, blocos e inodes da sua subárvore (node->usage). Toda
+// mudança sobe pela cadeia de pais, então o du só lê o total pronto e uma cota é
+// conferida em O(profundidade), sem percorrer a árvore. Cada FCB lembra quanto já
+// foi somado acima dele (usage_bytes/usage_blocks): basta aplicar a diferença.
+
+#define FS_USAGE_DETACHED (-1L)          // usage_blocks de um arquivo que saiu da árvore
+#define FS_USAGE_NO_OWNER ((UserClass)-1) // Diretórios: só as cotas dos diretórios valem
+
+// Blocos de um arquivo como entram nos totais (reservas da alocação adiada contam)
+long fs_usage_file_blocks(const FCB* fcb);
+
+// Blocos que len bytes devem ocupar (estimativa para conferir cotas antes de gravar)
+long fs_usage_estimate_blocks(size_t len);
+
+// Blocos a mais que mudar o tamanho do arquivo para size pode ocupar
+long fs_usage_truncate_blocks(const FCB* fcb, size_t size);
+
+// O nó acabou de entrar na lista de filhos do pai: soma a contribuição nos ancestrais
+void fs_usage_attach(FsNode* node);
+// O nó vai sair do pai (removing = 1: a subárvore deixa de existir, não é um mv)
+void fs_usage_detach(FsNode* node, int removing);
+
+// O arquivo (já na árvore) mudou de tamanho ou de blocos: aplica a diferença
+void fs_usage_refresh(FsNode* node);
+
+// Recalcula a subárvore inteira (construção em lote, rollback, reparos do fsck)
+void fs_usage_rebuild(FsNode* dir);
+
+// Confere se blocks/inodes a mais cabem nas cotas do proprietário (FS_USAGE_NO_OWNER
+// para diretórios) e de dir e seus ancestrais. Retorna 0 ou -1; *over recebe o
+// diretório estourado (NULL = cota do usuário)
+int  fs_usage_check(const FsNode* dir, UserClass owner, long blocks, long inodes, const FsNode** over);
+// O mesmo para mover node para new_parent (só os ancestrais novos ganham algo)
+int  fs_usage_check_move(FsNode* node, FsNode* new_parent, const FsNode** over);
+
+// Totais de um nó (um arquivo responde por si: o próprio tamanho e 1 inode)
+void fs_usage_get(const FsNode* node, FsUsage* out);
+
+// Cotas (0 = sem limite)
+void fs_usage_set_quota(FsNode* dir, long max_blocks, long max_inodes);
+void fs_usage_set_user_quota(UserClass owner, long max_blocks, long max_inodes);
+// Arquivos do proprietário na árvore e sua cota
+void fs_usage_user(UserClass owner, FsUsage* out);
+
+void fs_usage_shutdown(void);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef FS_WALK_H
+#define FS_WALK_H
+
+#include "fs.h"
+
+typedef enum {
+    FS_WALK_PREORDER,   // Pai antes dos filhos
+    FS_WALK_POSTORDER   // Filhos antes do pai (permite liberar o nó entregue)
+} FsWalkOrder;
+
+// Iterador de árvore sem recursão.
+// A "pilha" explícita é a própria cadeia de ponteiros parent dos nós,
+// então o percurso usa memória constante independente da profundidade.
+typedef struct {
+    FsNode* root;        // Raíz do percurso (não sobe acima dela)
+    FsNode* current;     // Último nó entregue
+    FsNode* next;        // Próximo nó (pré-calculado no pós-ordem)
+    FsWalkOrder order;
+    int depth;           // Profundidade do current em relação à raíz
+    int next_depth;
+    int prune;           // Pedido de poda dos filhos do current
+    int started;
+} FsWalk;
+
+// Inicia um percurso a partir de root
+void fs_walk_begin(FsWalk* walk, FsNode* root, FsWalkOrder order);
+
+// Retorna o próximo nó do percurso ou NULL ao terminar
+FsNode* fs_walk_next(FsWalk* walk);
+
+// Não desce nos filhos do último nó entregue (apenas pré-ordem)
+void fs_walk_prune(FsWalk* walk);
+
+// Profundidade do último nó entregue (raíz = 0)
+int fs_walk_depth(const FsWalk* walk);
+
+#endif
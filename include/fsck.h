@@ -0,0 +1,31 @@
+#ifndef FSCK_H
+#define FSCK_H
+
+#include "fs.h"
+
+// Resultado da verificação de consistência
+typedef struct {
+    long nodes;              // Nós percorridos na árvore
+    long dirs;
+    long files;
+    long blocks;             // Blocos do disco comparados
+
+    long leaked_blocks;      // Marcados como usados, mas sem nenhum dono
+    long unmarked_blocks;    // Com dono, mas marcados como livres
+    long refcount_mismatch;  // Contagem diferente do número de donos
+    long bad_block_refs;     // Índices de bloco fora do disco
+    long short_files;        // Blocos não cobrem o tamanho do arquivo
+    long duplicate_inodes;
+    long bad_inodes;         // Números de inode fora da faixa entregue
+    long bad_links;          // Ponteiros pai/filho inconsistentes
+
+    long repaired;
+    int  threads;
+    double seconds;
+} FsckReport;
+
+// Verifica (e com repair != 0, corrige) a árvore e o mapa de blocos.
+// Retorna o número de problemas encontrados ou -1 em erro.
+long fsck_run(FsNode* root, int threads, int repair, FsckReport* report);
+
+#endif
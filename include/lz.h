@@ -0,0 +1,18 @@
+#ifndef LZ_H
+#define LZ_H
+
+#include <stddef.h>
+
+// Compressor LZ77 simples (formato no estilo LZ4), sem dependências externas.
+// Sequências: token (4 bits de literais | 4 bits de match), literais,
+// deslocamento de 2 bytes e extensões de comprimento com bytes 255.
+
+#define LZ_MIN_MATCH 4
+
+// Comprime len bytes de src em dst. Retorna o tamanho comprimido ou 0 se não couber em cap
+size_t lz_compress(const char* src, size_t len, char* dst, size_t cap);
+
+// Descomprime src em dst. Retorna os bytes produzidos ou -1 se os dados estiverem corrompidos
+long   lz_decompress(const char* src, size_t len, char* dst, size_t cap);
+
+#endif
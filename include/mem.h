@@ -0,0 +1,43 @@
+#ifndef MEM_H
+#define MEM_H
+
+#include <stddef.h>
+
+// Categorias de memória contabilizadas pelo meminfo
+typedef enum {
+    MEM_NODE,       // FsNode
+    MEM_FCB,        // FCBs (inclusive as cópias dos snapshots)
+    MEM_CONTENT,    // Cópias do conteúdo em memória
+    MEM_DISK,       // Disco simulado, mapa de ocupação e CRCs
+    MEM_INDEX,      // Índice de deduplicação
+    MEM_SNAPSHOT,   // Registros dos snapshots
+    MEM_TRACE,      // Buffers do rastreamento de eventos
+    MEM_NAME,       // Arena e tabela dos nomes internados
+    MEM_USAGE,      // Totais e cotas dos diretórios (fs_usage.h)
+    MEM_TAG_COUNT
+} MemTag;
+
+typedef struct {
+    long bytes;     // Bytes vivos (tamanho real do bloco entregue pelo malloc)
+    long count;     // Alocações vivas
+} MemTagStats;
+
+// Cabeçalho que o malloc guarda antes de cada bloco (metadados do alocador)
+#define MEM_CHUNK_OVERHEAD sizeof(size_t)
+
+// Substitutos de malloc/calloc/realloc/free que contabilizam por categoria.
+// O free precisa receber a mesma categoria da alocação.
+void* mem_alloc(MemTag tag, size_t size);
+void* mem_calloc(MemTag tag, size_t count, size_t size);
+void* mem_realloc(MemTag tag, void* ptr, size_t size);
+void  mem_free(MemTag tag, void* ptr);
+
+// Bytes que cabem no bloco de fato entregue pelo malloc (>= o tamanho pedido)
+size_t mem_capacity(const void* ptr);
+
+const char* mem_tag_name(MemTag tag);
+
+// Retrato dos contadores; peak é o maior total já visto
+void mem_stats(MemTagStats stats[MEM_TAG_COUNT], long* total, long* peak);
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef MINIFS_H
+#define MINIFS_H
+
+#include <stddef.h>
+#include <time.h>
+#include <sys/types.h>
+
+// libminifs: o sistema de arquivos simulado embutido no processo, sem shell.
+// Os descritores guardam o nó já resolvido, o FCB (com o mapa de blocos) e o
+// deslocamento atual, então ler e gravar não procuram o arquivo pelo nome de novo.
+// Erros voltam como -errno (-ENOENT, -EACCES, -EBADF, -ENOSPC, -EDQUOT, ...).
+// As chamadas não são seguras entre threads: uma por vez, como os comandos da shell.
+// Caminhos que começam com '/' partem da raiz; os demais, do diretório atual.
+
+#define MFS_MAX_OPEN 1024           // Descritores abertos ao mesmo tempo
+
+// Modo de abertura (um dos três) combinado com os demais bits
+#define MFS_O_RDONLY 0x00
+#define MFS_O_WRONLY 0x01
+#define MFS_O_RDWR   0x02
+#define MFS_O_ACCMODE 0x03
+#define MFS_O_CREAT  0x04           // Cria o arquivo se não existir
+#define MFS_O_TRUNC  0x08           // Esvazia o arquivo (precisa de escrita)
+#define MFS_O_APPEND 0x10           // Toda gravação vai para o fim
+
+typedef struct {
+    size_t size;                    // Tamanho lógico
+    size_t physical;                // Bytes ocupados nos blocos (0 inline ou com alocação adiada)
+    int    blocks;                  // Blocos alocados (buracos não contam)
+    int    inode;                   // 0 para diretórios
+    int    is_dir;
+    unsigned int permissions;       // Bits rwx (ex.: 0644)
+    int    owner;                   // UserClass do proprietário
+    time_t created_at;
+    time_t modified_at;
+    time_t accessed_at;
+} MfsStat;
+
+typedef struct {
+    const char* name;               // Nome internado: vale enquanto a entrada existir
+    int    is_dir;
+    size_t size;
+    int    inode;
+} MfsDirent;
+
+// Monta o sistema de arquivos vazio. Com image != NULL os blocos ficam nesse arquivo
+// do host (como --image). Retorna 0 ou -errno
+int  mfs_mount(const char* image);
+// Fecha todos os descritores e desmonta (grava o que estiver pendente na imagem)
+void mfs_unmount(void);
+
+// Abre um arquivo (ou um diretório, só leitura, para mfs_readdir). Retorna o descritor ou -errno
+int  mfs_open(const char* path, int flags);
+int  mfs_close(int fd);
+
+// Lê/grava a partir do deslocamento do descritor e o avança. Retornam os bytes ou -errno
+ssize_t mfs_read(int fd, void* buf, size_t len);
+ssize_t mfs_write(int fd, const void* buf, size_t len);
+// Lê em um deslocamento qualquer, sem mexer no do descritor
+ssize_t mfs_pread(int fd, void* buf, size_t len, size_t offset);
+// Muda o tamanho do arquivo: corta ou estende com um buraco (lê como zeros, sem blocos)
+int  mfs_ftruncate(int fd, size_t size);
+
+int  mfs_stat(const char* path, MfsStat* st);
+int  mfs_fstat(int fd, MfsStat* st);
+
+// Próxima entrada de um diretório aberto: 1 = entrada preenchida, 0 = fim, ou -errno
+int  mfs_readdir(int fd, MfsDirent* entry);
+
+int  mfs_mkdir(const char* path);
+int  mfs_unlink(const char* path);
+
+// Ganchos do núcleo (fs_helpers.c), não fazem parte da API: mantêm os descritores
+// válidos quando um nó sai da lista do diretório ou é liberado
+void mfs_node_unlinked(const void* node);
+void mfs_node_freed(const void* node);
+
+#endif
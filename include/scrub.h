@@ -0,0 +1,43 @@
+#ifndef SCRUB_H
+#define SCRUB_H
+
+#define SCRUB_MAX_REPORTED 8   // Blocos corrompidos listados no resultado
+
+typedef struct {
+    int    running;            // 1 enquanto o job está em andamento
+    int    cancelled;
+    long   total;              // Blocos do disco a percorrer
+    long   scanned;            // Blocos percorridos até agora
+    long   checked;            // Blocos alocados verificados
+    long   sealed;             // Blocos que ainda não tinham CRC e foram selados agora
+    long   errors;             // Blocos com CRC divergente
+    int    bad_blocks[SCRUB_MAX_REPORTED];
+    int    threads;
+    double seconds;
+} ScrubStats;
+
+// Verifica o CRC de todos os blocos alocados em segundo plano, como um job em um pool
+// de threads. Cada thread reserva fatias de 64 blocos e confere cada fatia segurando
+// blocks_lock(): quem muda blocos enquanto o scrub roda precisa segurar a mesma trava
+// (a shell faz isso a cada comando). rate_limit limita a vazão em blocos por segundo
+// (0 = sem limite) e as pausas acontecem fora da trava.
+// Retorna 0 ou -1 (checksums desligados, outro scrub em andamento ou sem threads)
+int  scrub_start(int threads, long rate_limit);
+
+// Progresso do job atual ou resultado do último. Retorna -1 se nenhum foi iniciado
+int  scrub_status(ScrubStats* stats);
+
+// Espera o job atual terminar e devolve o resultado (-1 se nenhum foi iniciado)
+int  scrub_wait(ScrubStats* stats);
+
+// Pede às threads que parem na próxima fatia
+void scrub_cancel(void);
+
+// Devolve uma única vez o resultado de um job que terminou e ainda não foi mostrado.
+// Retorna 1 se havia resultado novo
+int  scrub_poll(ScrubStats* stats);
+
+// Cancela o job em andamento e libera o pool (antes de desligar os blocos)
+void scrub_shutdown(void);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "fs.h"
+
+// Snapshots do namespace com cópia antes da escrita (copy-on-write).
+//
+// Tirar um snapshot é O(1): apenas abre um novo "registro" vazio.
+// Na primeira modificação de um nó depois do snapshot, snap_touch guarda uma
+// cópia do nó e do seu FCB nesse registro; os blocos são compartilhados por
+// contagem de referências, não copiados. O rollback reaplica as cópias.
+
+// Época atual (usada para marcar nós recém-criados)
+unsigned int snap_current_epoch(void);
+
+// Deve ser chamada antes de qualquer modificação em um nó ou em seu FCB
+void snap_touch(FsNode* node);
+
+// Registra um nó recém-inserido na árvore
+void snap_node_created(FsNode* node);
+
+// Chamado ao remover um nó da árvore. Retorna 1 se um snapshot ficou com o nó
+// (o chamador não deve liberá-lo) ou 0 se o nó pode ser liberado.
+int  snap_retire(FsNode* node);
+
+// Comandos
+int  snap_create(const char* name);
+int  snap_rollback(const char* name);
+int  snap_remove(const char* name);
+void snap_list(void);
+
+// Visita cada FCB guardado pelos snapshots (cópias e nós removidos), para o fsck
+void snap_for_each_fcb(void (*fn)(const FCB* fcb, void* arg), void* arg);
+
+// Libera todos os snapshots (desligamento)
+void snap_shutdown(void);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Tarefa executada por uma thread do pool
+typedef void (*TpTaskFn)(void* arg);
+
+typedef struct ThreadPool ThreadPool;
+
+// Número de threads padrão (processadores online)
+int tp_default_threads(void);
+
+// Cria um pool com o número de threads indicado (<= 0 usa o padrão)
+ThreadPool* tp_create(int threads);
+
+// Enfileira uma tarefa. Pode ser chamada de dentro de outra tarefa.
+int  tp_submit(ThreadPool* pool, TpTaskFn fn, void* arg);
+
+// Espera até a fila esvaziar e todas as tarefas terminarem
+void tp_wait(ThreadPool* pool);
+
+// Número de threads do pool
+int  tp_size(const ThreadPool* pool);
+
+// Encerra as threads e libera o pool (espera as tarefas pendentes)
+void tp_destroy(ThreadPool* pool);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdatomic.h>
+
+// Eventos registrados pelo rastreamento
+typedef enum {
+    TRACE_CMD,           // Duração de um comando (início/fim)
+    TRACE_BLOCK_ALLOC,   // Bloco marcado como usado
+    TRACE_BLOCK_RUN,     // Faixa contígua reservada de uma vez (--build)
+    TRACE_BLOCK_FREE,    // Bloco voltou a ficar livre
+    TRACE_NODE_CREATE,
+    TRACE_NODE_MOVE,
+    TRACE_NODE_FREE,
+    TRACE_KIND_COUNT
+} TraceKind;
+
+#define TRACE_RING_EVENTS 16384   // Eventos por thread (potência de 2)
+#define TRACE_MAX_LANES   64      // Threads com buffer próprio ao mesmo tempo
+
+// Ligado/desligado. Lido sem trava antes de cada registro: desligado custa só um teste
+extern atomic_int trace_on;
+
+void trace_record(TraceKind kind, char phase, const char* label, long a, long b);
+
+#define TRACE_EVENT(kind, label, a, b) do { \
+    if (atomic_load_explicit(&trace_on, memory_order_relaxed)) trace_record((kind), 'i', (label), (a), (b)); \
+} while (0)
+
+// Liga o rastreamento, descartando os eventos anteriores
+void trace_start(void);
+void trace_stop(void);
+
+// Escreve os eventos no formato JSON do Chrome (chrome://tracing, Perfetto).
+// Retorna o número de eventos escritos ou -1 em erro.
+long trace_dump(const char* path);
+
+// Eventos guardados e eventos perdidos (buffer cheio ou sem buffer livre)
+void trace_counts(long* recorded, long* dropped);
+
+void trace_shutdown(void);
+
+#endif
@@ -1,638 +1,1579 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <time.h>
-
-#include "fs.h"
-#include "fs_helpers.h"
-#include "fcb_helpers.h"
-#include "commands.h"
-#include "permissions.h"
-#include "blocks.h"
-
-
-// Diretório atual 
-void cmd_pwd(){
-    char path[PATH_MAX_LEN];
-    fs_get_path(fs_current_dir, path, sizeof(path));
-    printf("%s\n", path);
-}
-
-// Criar diretório
-void cmd_mkdir(int argc, char** argv){
-    if (argc < 2){
-        printf("Uso: mkdir <nome_diretorio>\n");
-        return;
-    }
-
-    // Nome do novo diretório
-    const char* name = argv[1];
-
-    if (strlen(name) == 0 || strcmp(name, ".") == 0 || strcmp(name, "..") == 0){
-        printf("mkdir: Nome de diretório invalido\n");
-        return;
-    }
-
-    if (strchr(name, '/')){
-        printf("mkdir: Nome de diretório nao pode conter '/'\n");
-        return;
-    }
-
-    if (fs_find_child(fs_current_dir, name)){
-        printf("mkdir: Diretorio ou arquivo com esse nome ja existe\n");
-        return;
-    }
-
-    FsNode* new_dir = fs_create_node(name, NODE_DIR, fs_current_dir); // Cria novo diretório
-    fs_add_child(fs_current_dir, new_dir); // Adiciona ao diretório atual
-}
-
-void cmd_ls(int argc, char** argv){
-    FsNode* target = fs_current_dir;
-
-    int long_format = 0;
-    int arg_index   = 1;
-
-    if (argc >= 2 && strcmp(argv[1], "-l") == 0){
-        long_format = 1;
-        arg_index   = 2;
-    }
-
-    // Se um nome for fornecido, tenta encontrar esse diretório
-    if (argc > arg_index){
-        const char* name = argv[arg_index];
-
-        if (strcmp(name, ".") == 0){
-            // Já está no diretório atual
-        } else if (strcmp(name, "..") == 0) { // Sair para pasta pai
-            if (fs_current_dir->parent){
-                target = fs_current_dir->parent;
-            }
-        } else {
-            FsNode* child = fs_find_child(fs_current_dir, name);
-            if (!child){
-                printf("ls: Diretorio ou arquivo '%s' nao encontrado\n", name);
-                return;
-            }
-            target = child;
-        }
-    }
-
-    if (target->type == NODE_FILE){
-        // Se for um arquivo e tiver formato longo, mostra permissões e tamanho
-        if(long_format && target->fcb){
-            char perms[10];
-            perms_to_string(target->fcb->permissions, perms, sizeof(perms));
-            
-            const char* owner_name = "unknown";
-            switch (target->fcb->owner) {
-                case USER_OWNER: owner_name = "owner"; break;
-                case USER_GROUP: owner_name = "group"; break;
-                case USER_OTHER: owner_name = "other"; break;
-            }
-
-            printf("%s %s %zu %s\n", perms, owner_name, target->fcb->size, target->name);
-        }
-        else {
-            // Mostra somente o nome
-            printf("%s\n", target->name);
-        }
-        return;
-    }
-
-    // Lista os filhos do diretório
-    FsNode* child = target->first_child;
-    while(child){
-        if(long_format && child->fcb){
-            char perms[10];
-            perms_to_string(child->fcb->permissions, perms, sizeof(perms));
-            
-            const char* owner_name = "unknown";
-            switch (child->fcb->owner) {
-                case USER_OWNER: owner_name = "owner"; break;
-                case USER_GROUP: owner_name = "group"; break;
-                case USER_OTHER: owner_name = "other"; break;
-            }
-            printf("%s %s %zu %s\n", perms, owner_name, child->fcb->size, child->name);
-        } else {
-            if (child->type == NODE_DIR){
-                printf("%s/\n", child->name); // Ganha uma barra para identificar como diretório
-            } else {
-                printf("%s\n", child->name); // Arquivo normal
-            }
-        }
-        child = child->next_sibling;
-    }
-}
-
-// Mudar diretório 
-void cmd_cd(int argc, char** argv){
-    if (argc < 2){
-        // Sem argumento, volta para a raíz
-        fs_current_dir = fs_root;
-        return;
-    }
-
-    // Pega o caminho fornecido
-    const char* path = argv[1];
-
-    if (strcmp(path, "/") == 0){
-        fs_current_dir = fs_root; // Vai para raíz
-        return;
-    } else if (strcmp(path, ".") == 0){
-        // Fica no diretório atual
-    } else if (strcmp(path, "..") == 0){
-        if (fs_current_dir->parent){
-            fs_current_dir  = fs_current_dir->parent; // Sobe para o pai
-        }
-        return;
-    } else {
-        FsNode* child = fs_find_child(fs_current_dir, path);
-        if(!child || child->type != NODE_DIR){ 
-            printf("cd: Diretorio '%s' nao encontrado\n", path);
-            return;
-        }
-        fs_current_dir  = child; // Muda para o diretório encontrado
-    }
-}
-
-void cmd_touch(int argc, char** argv){
-    if (argc < 2){
-        printf("Uso: touch <nome_arquivo>\n");
-        return;
-    }
-
-    for (int i = 1; i < argc; i++){
-        const char* name = argv[i];
-
-        if (strlen(name) == 0 || strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
-            printf("touch: Nome de arquivo inválido '%s'\n", name);
-            continue;
-        }
-
-        if (strchr(name, '/')){
-            printf("touch: Nome de arquivo nao pode conter '/': '%s'\n", name);
-            continue;
-        }
-        FsNode* existing = fs_find_child(fs_current_dir, name);
-        if (existing){
-            if (existing->type == NODE_DIR){
-                printf("touch: Já existe um diretório com esse nome: '%s'\n", name);
-                continue;
-            } 
-            // arquivo já existe -> atualiza timestamps
-            if (existing->fcb) {
-                time_t now = time(NULL);
-                existing->fcb->accessed_at = now;
-                existing->fcb->modified_at = now;
-            }
-        } else {
-            // Cria novo arquivo
-            FsNode* new_file = fs_create_node(name, NODE_FILE, fs_current_dir);
-            new_file->fcb = create_fcb(name, FILETYPE_TEXT); // Por enquanto, todos são arquivos de texto
-            fs_add_child(fs_current_dir, new_file);
-        }
-    }
-
-}
-
-void cmd_write(int argc, char** argv){
-    if (argc < 3){
-       printf("Uso: write <nome_arquivo> <texto>\n");
-       return;
-    }
-
-    const char* file_name = argv[1];
-
-    if(strchr(file_name, '/')){
-        printf("write: Nome de arquivo nao pode conter '/': '%s'\n", file_name);
-        return;
-    }
-
-    // Monta o texto a partir do argv
-    size_t total_len = 0;
-    for (int i = 2; i < argc; i++){
-        total_len += strlen(argv[i]);
-        if (i < argc -1){
-            total_len += 1; // espaço
-        }
-    }
-
-    char* buffer = (char*)malloc(total_len +1);
-    if(!buffer){
-        fprintf(stderr, "Erro ao alocar memoria para conteudo do arquivo\n");
-        return;
-    } 
-
-    buffer[0] = '\0';
-    for (int i = 2; i < argc; i++){
-        strcat(buffer, argv[i]);
-        if (i < argc -1){
-            strcat(buffer, " ");
-        }
-    }
-
-    // Verificar se o arquivo já existe
-    FsNode* node = fs_find_child(fs_current_dir, file_name);
-
-    if(!node){
-        // Cria novo arquivo
-        node = fs_create_node(file_name, NODE_FILE, fs_current_dir);
-        node->fcb = create_fcb(file_name, FILETYPE_TEXT);
-        fs_add_child(fs_current_dir, node);
-    } else {
-        if (node->type == NODE_DIR){
-            printf("write: '%s' nao e um arquivo\n", file_name);
-            free(buffer);
-            return;
-        }  
-        if (!node->fcb){
-            node->fcb = create_fcb(file_name, FILETYPE_TEXT);
-        } else {
-            // Verifica se há permissão de escrita  
-            if(!perms_can_write(node->fcb)){
-                printf("write: Permissão negada para escrever no arquivo '%s'\n", file_name);
-                free(buffer);
-                return;
-            }
-        }
-    }
-
-    // Sobrescrever arquivo
-    if(node->fcb->content){
-        free(node->fcb->content);
-    }
-
-    node->fcb->content = buffer;
-    node->fcb->size = total_len;
-
-    if (blocks_alloc_for_file(node->fcb, node->fcb->content, node->fcb->size) != 0) {
-        printf("write: Falha ao alocar blocos para '%s' (disco cheio ou arquivo muito grande)\n", file_name);
-    }
-
-    time_t now = time(NULL);
-    node->fcb->modified_at = now;
-    node->fcb->accessed_at = now;
-}
-
-
-// Imprime o conteúdo do arquivo
-void cmd_cat(int argc, char** argv){
-    if (argc < 2){
-        printf("Uso: cat <nome_arquivo>\n");
-        return;
-    }
-
-    const char* file_name = argv[1];
-
-    FsNode* node = fs_find_child(fs_current_dir, file_name);
-    if(!node){
-        printf("cat: Arquivo '%s' nao encontrado\n", file_name);
-        return;
-    }
-
-    if(node->type == NODE_DIR){
-        printf("cat: '%s' não é um arquivo\n", file_name);
-        return;
-    }
-
-    if(!node->fcb){
-        printf("cat: Arquivo '%s' não possui FCB\n", file_name);
-        return;
-    }
-
-    if(!perms_can_read(node->fcb)){
-        printf("cat: Permissão negada para ler o arquivo '%s'\n", file_name);
-        return;
-    }
-    if(!node->fcb->content){
-         // Arquivo vazio
-        node->fcb->accessed_at = time(NULL);
-        return;
-    }
-
-    printf("%s\n", node->fcb->content);
-    node->fcb->accessed_at = time(NULL);
-}
-
-void cmd_cp(int argc, char** argv){
-    if(argc < 3){
-        printf("Uso: cp <src> <dst>\n");
-        return;
-    }
-
-    const char* src_name = argv[1];
-    const char* dst_name = argv[2];
-
-    if(strchr(src_name, '/')){
-        printf("cp: Nomes de arquivo nao podem conter '/'\n");
-        return;
-    }
-
-    // Procura o arquivo de origem
-    FsNode* src = fs_find_child(fs_current_dir, src_name);
-    if(!src){
-        printf("cp: Arquivo de origem '%s' nao encontrado\n", src_name);
-        return;
-    }
-
-    if(src->type == NODE_DIR){
-        printf("cp: '%s' nao e um arquivo\n", src_name);
-        return;
-    }
-
-    if(!src->fcb){
-        printf("cp: Arquivo de origem '%s' nao possui FCB\n", src_name);
-        return;
-    }
-
-    if(!perms_can_read(src->fcb)){
-        printf("cp: Permissão negada para ler o arquivo '%s'\n", src_name);
-        return;
-    }
-
-    if(fs_find_child(fs_current_dir, dst_name)){
-        printf("cp: Não foi possível criar arquivo. Arquivo de destino '%s' ja existe\n", dst_name);
-        return;
-    }
-
-    // Cria o novo arquivo
-    FsNode* dst = fs_create_node(dst_name, NODE_FILE, fs_current_dir);
-    dst->fcb = create_fcb(dst_name, src->fcb->type);
-
-
-    // Copia o conteúdo, se existir
-    if (src->fcb->content && src->fcb->size > 0) {
-        dst->fcb->content = (char*)malloc(src->fcb->size + 1);
-        if(!dst->fcb->content){
-            fprintf(stderr, "Erro ao alocar memoria para conteudo do arquivo\n");
-            free(dst->fcb);
-            free(dst);
-            return;
-        }
-        memcpy(dst->fcb->content, src->fcb->content, src->fcb->size);
-        dst->fcb->content[src->fcb->size] = '\0';
-
-        dst->fcb->size = src->fcb->size;
-    } else {
-        dst->fcb->content = NULL;
-        dst->fcb->size = 0;
-    }
-
-    if (blocks_alloc_for_file(dst->fcb, dst->fcb->content, dst->fcb->size) != 0) {
-        printf("cp: Falha ao alocar blocos para '%s'\n", dst_name);
-    }
-
-    // timestamp do dst
-    time_t now = time(NULL);
-    dst->fcb->created_at = now;
-    dst->fcb->modified_at = now;
-    dst->fcb->accessed_at = now;
-
-    fs_add_child(fs_current_dir, dst);
-}
-    
-void cmd_mv(int argc, char** argv){
-    if(argc < 3){
-        printf("Uso: mv <old> <new>\n");
-        return;
-    }
-
-    const char* old_name = argv[1];
-    const char* new_name = argv[2];
-
-    FsNode* node = fs_find_child(fs_current_dir, old_name);
-    if(!node){
-        printf("mv: Arquivo '%s' nao encontrado\n", old_name);
-        return;
-    }
-
-    // Mover para o diretório pai
-    if (strcmp(new_name, "..") == 0){
-        if(!fs_current_dir->parent){
-            printf("mv: Direttório pai não existe\n");
-            return;
-        }
-        
-        FsNode* parent = fs_current_dir->parent;
-
-        if(fs_find_child(parent, node->name)){
-            printf("mv: Não foi possível mover. Arquivo '%s' ja existe em '%s'\n", node->name, parent->name);
-            return;
-        }
-
-        fs_move_node(node, parent);
-        return;
-    }
-
-    // Primeiro tenta interpretar new_name como como diretorio de destino
-    FsNode* maybe_dir = fs_find_child(fs_current_dir, new_name);
-    if(maybe_dir && maybe_dir->type == NODE_DIR){
-        if(fs_find_child(maybe_dir, node->name)){
-            printf("mv: Não foi possível mover. Arquivo '%s' ja existe em '%s'\n", node->name, new_name);
-            return;
-        }
-        fs_move_node(node, maybe_dir);
-        return;
-    }
-
-    // Se não for diretório, tenta renomear
-    if(strchr(new_name, '/')){
-        printf("mv: Nomes de arquivo nao podem conter '/'\n");
-        return;
-    }
-
-    if(fs_find_child(fs_current_dir, new_name)){
-        printf("mv: Não foi possível renomear. Arquivo '%s' ja existe\n", new_name);
-        return;
-    }
-
-    if(node->fcb && !perms_can_write(node->fcb)){
-        printf("mv: Permissão negada para renomear o arquivo '%s'\n", old_name);
-        return;
-    }
-
-    // Renomeia
-    strncpy(node->name, new_name, MAX_NAME_LEN -1);
-    node->name[MAX_NAME_LEN -1] = '\0';
-
-    // Se for arquivo, renomeia no FCB também
-    if(node->fcb){
-        strncpy(node->fcb->name, new_name, MAX_NAME_LEN -1);
-        node->fcb->name[MAX_NAME_LEN -1] = '\0';
-    }
-
-}
-
-// Remove um arquivo
-void cmd_rm(int argc, char** argv){
-    if(argc < 2){
-        printf("Uso: rm <nome_arquivo>\n");
-        return;
-    }
-
-    const char* file_name = argv[1];
-
-    FsNode* node = fs_find_child(fs_current_dir, file_name);
-    if(!node){
-        printf("rm: Arquivo '%s' nao encontrado\n", file_name);
-        return;
-    }
-
-    if(node->type == NODE_DIR){
-        printf("rm: '%s' nao e um arquivo\n", file_name);
-        return;
-    }
-
-    if (node->fcb && !perms_can_write(node->fcb)) {
-        printf("rm: Permissao negada para excluir '%s'\n", file_name);
-        return;
-    }
-
-    // Remove o nó do diretório atual
-    fs_remove_child(fs_current_dir, node);
-}
-
-void cmd_whoami(){
-    const char* name = "unknown";
-
-    switch (fs_current_user_class){
-        case USER_OWNER:
-            name = "owner";
-            break;
-        case USER_GROUP:
-            name = "group";
-            break;
-        case USER_OTHER:
-            name = "other";
-            break;
-        default:
-            break;
-    }
-
-    printf("%s\n", name);    
-}
-
-void cmd_user(int argc, char** argv){
-    if (argc < 2){
-        printf("Uso: user <owner|group|other>\n");
-        return;
-    }
-
-    const char* role = argv[1];
-
-    if (strcmp(role, "owner") == 0){
-        fs_current_user_class = USER_OWNER;
-    } else if (strcmp(role, "group") == 0){
-        fs_current_user_class = USER_GROUP;
-    } else if (strcmp(role, "other") == 0){
-        fs_current_user_class = USER_OTHER;
-    } else {
-        printf("user: Usuario desconhecido '%s'\n", role);
-    }
-}
-
-void cmd_chmod(int argc, char** argv){
-    if (argc < 3){
-        printf("Uso: chmod <perms> <file>\n");
-        return;
-    }
-
-    const char* perm_text = argv[1];
-    const char* file_name = argv[2];
-
-    int ok = 0;
-
-    unsigned int perms = perms_parse_numeric(perm_text, &ok);
-
-    if(!ok){
-        printf("chmod: Permissoes invalidas: '%s'\n", perm_text);
-        return;
-    }
-
-    FsNode* node = fs_find_child(fs_current_dir, file_name);
-    if(!node){
-        printf("chmod: Arquivo '%s' nao encontrado\n", file_name);
-        return;
-    }
-
-    if(node->type == NODE_DIR){
-        printf("chmod: '%s' nao e um arquivo\n", file_name);
-        return;
-    }
-
-    if(!node->fcb){
-        printf("chmod: Arquivo '%s' nao possui FCB\n", file_name);
-        return;
-    }
-
-    node->fcb->permissions = perms;
-
-    char perm_str[10];
-    perms_to_string(perms, perm_str, sizeof(perm_str));
-    printf("Permissoes de '%s' alteradas para %s \n", file_name, perm_str);
-}
-
-void cmd_stat(int argc, char** argv){
-    if(argc < 2){
-        printf("Uso: stat <nome_arquivo>\n");
-        return;
-    }
-
-    const char* file_name = argv[1];
-
-    FsNode* node = fs_find_child(fs_current_dir, file_name);
-    if(!node){
-        printf("stat: Arquivo '%s' nao encontrado\n", file_name);
-        return;
-    }
-    if (node->type == NODE_DIR){
-        printf("stat: '%s' nao e um arquivo\n", file_name);
-        return;
-    }
-
-    if(!node->fcb){
-        printf("stat: Arquivo '%s' nao possui FCB\n", file_name);
-        return;
-    }
-
-    FCB* fcb = node->fcb;
-
-    char perms[10];
-    perms_to_string(fcb->permissions, perms, sizeof(perms));
-
-    const char* owner_name = "unknown";
-    switch (fcb->owner){
-        case USER_OWNER: owner_name = "owner"; break;
-        case USER_GROUP: owner_name = "group"; break;
-        case USER_OTHER: owner_name = "other"; break;
-    }
-
-    printf("  Estatisticas de '%s':\n", file_name);
-    printf("  Tamanho: %zu bytes\n", fcb->size);
-    printf("  Permissoes: %s\n", perms);
-    printf("  Proprietario: %s\n", owner_name);
-    printf("  Inode: %d\n", fcb->inode);
-    printf("  Criado em: %s", ctime(&fcb->created_at));
-    printf("  Modificado em: %s", ctime(&fcb->modified_at));
-    printf("  Ultimo acesso em: %s", ctime(&fcb->accessed_at));
-    printf("  Blocos alocados (%d): ", fcb->block_count);
-
-    blocks_dump_file(fcb);
-}
-
-void cmd_df(){
-    int total_blocks = 0;
-    int used_blocks  = 0;
-    int free_blocks  = 0;
-
-    blocks_stats(&total_blocks, &used_blocks, &free_blocks);
-
-    size_t capacity_bytes = (size_t)total_blocks * FS_BLOCK_SIZE;
-
-    printf("  Blocos totais: %d\n", total_blocks);
-    printf("  Blocos usados: %d\n", used_blocks);
-    printf("  Blocos livres: %d\n", free_blocks);
-    printf("  Tamanho de bloco: %d bytes\n", FS_BLOCK_SIZE);
-    printf("  Capacidade total aproximada: %zu bytes\n", capacity_bytes);
-}
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "fs.h"
+#include "fs_helpers.h"
+#include "fcb_helpers.h"
+#include "commands.h"
+#include "permissions.h"
+#include "blocks.h"
+#include "fs_walk.h"
+#include "fs_glob.h"
+#include "fs_list.h"
+#include "snapshot.h"
+#include "dedup.h"
+#include "delalloc.h"
+#include "fs_time.h"
+#include "fs_name.h"
+#include "fs_usage.h"
+#include "mem.h"
+#include "trace.h"
+#include "blkio.h"
+
+
+// Compila os operandos (nomes ou padrões glob) de um comando
+static int compile_operands(const char* cmd, FsGlobSet* set, char** args, int count){
+    if (fs_globset_compile(set, args, count) != 0){
+        printf("%s: Padrao invalido\n", cmd);
+        return -1;
+    }
+    return 0;
+}
+
+// Informa os operandos que não casaram com nenhuma entrada do diretório
+static void report_unmatched(const char* cmd, const FsGlobSet* set){
+    for (int i = 0; i < set->count; i++){
+        if (!set->hits[i]){
+            printf("%s: Arquivo '%s' nao encontrado\n", cmd, set->globs[i].text);
+        }
+    }
+}
+
+// Casa os operandos com o diretório atual em uma única passada e devolve os nós na ordem
+// dos operandos (dentro de um mesmo padrão, na ordem do diretório). O vetor devolvido é
+// liberado com free(); retorna quantos nós casaram ou -1 sem memória
+static int match_in_operand_order(FsGlobSet* set, FsNode*** out){
+    *out = NULL;
+    int n = 0, capacity = 0;
+    FsNode** found = NULL;
+    int* operand = NULL;
+
+    for (FsNode* child = fs_current_dir->first_child; child; child = child->next_sibling){
+        int index = fs_globset_match(set, child->name);
+        if (index < 0) continue;
+
+        if (n == capacity){
+            capacity = capacity ? capacity * 2 : 16;
+            FsNode** grown_found = (FsNode**)realloc(found, sizeof(FsNode*) * (size_t)capacity);
+            if (grown_found) found = grown_found;
+            int* grown_operand = (int*)realloc(operand, sizeof(int) * (size_t)capacity);
+            if (grown_operand) operand = grown_operand;
+            if (!grown_found || !grown_operand){
+                free(found);
+                free(operand);
+                return -1;
+            }
+        }
+        found[n] = child;
+        operand[n] = index;
+        n++;
+    }
+
+    // Ordenação por contagem, estável: start[i] é onde começa o balde do operando i
+    int* start = (int*)calloc((size_t)set->count + 1, sizeof(int));
+    FsNode** sorted = (FsNode**)malloc(sizeof(FsNode*) * (size_t)(n ? n : 1));
+    if (!start || !sorted){
+        free(start);
+        free(sorted);
+        free(found);
+        free(operand);
+        return -1;
+    }
+    for (int k = 0; k < n; k++) start[operand[k] + 1]++;
+    for (int i = 0; i < set->count; i++) start[i + 1] += start[i];
+    for (int k = 0; k < n; k++) sorted[start[operand[k]]++] = found[k];
+
+    free(start);
+    free(found);
+    free(operand);
+    *out = sorted;
+    return n;
+}
+
+
+void cmd_report_quota(const char* cmd, const FsNode* over){
+    if (!over){
+        printf("%s: Cota do usuario excedida\n", cmd);
+        return;
+    }
+    char path[PATH_MAX_LEN];
+    fs_get_path((FsNode*)over, path, sizeof(path));
+    printf("%s: Cota do diretorio '%s' excedida\n", cmd, path);
+}
+
+
+// Diretório atual 
+void cmd_pwd(){
+    char path[PATH_MAX_LEN];
+    fs_get_path(fs_current_dir, path, sizeof(path));
+    printf("%s\n", path);
+}
+
+// Criar diretório
+void cmd_mkdir(int argc, char** argv){
+    if (argc < 2){
+        printf("Uso: mkdir <nome_diretorio>\n");
+        return;
+    }
+
+    // Nome do novo diretório
+    const char* name = argv[1];
+
+    if (strlen(name) == 0 || strcmp(name, ".") == 0 || strcmp(name, "..") == 0){
+        printf("mkdir: Nome de diretório invalido\n");
+        return;
+    }
+
+    if (strchr(name, '/')){
+        printf("mkdir: Nome de diretório nao pode conter '/'\n");
+        return;
+    }
+
+    if (fs_find_child(fs_current_dir, name)){
+        printf("mkdir: Diretorio ou arquivo com esse nome ja existe\n");
+        return;
+    }
+
+    const FsNode* over = NULL;
+    if (fs_usage_check(fs_current_dir, FS_USAGE_NO_OWNER, 0, 1, &over) != 0){
+        cmd_report_quota("mkdir", over);
+        return;
+    }
+
+    FsNode* new_dir = fs_create_node(name, NODE_DIR, fs_current_dir); // Cria novo diretório
+    fs_add_child(fs_current_dir, new_dir); // Adiciona ao diretório atual
+}
+
+// Diretórios que casaram com os padrões: listados depois dos arquivos, cada um com cabeçalho
+typedef struct {
+    FsGlobSet* set;
+    FsNode**   dirs;
+    int        count;
+    int        cap;
+    int        failed;
+} LsMatch;
+
+// Filtro do ls com padrões (fs_globset_match também marca os padrões que casaram).
+// Arquivos entram na listagem; diretórios são guardados para serem listados por dentro
+static int ls_glob_filter(const FsNode* node, void* arg){
+    LsMatch* match = (LsMatch*)arg;
+    if (fs_globset_match(match->set, node->name) < 0) return 0;
+    if (node->type == NODE_FILE) return 1;
+
+    if (match->count == match->cap){
+        int cap = match->cap ? match->cap * 2 : 16;
+        FsNode** grown = (FsNode**)realloc(match->dirs, (size_t)cap * sizeof(FsNode*));
+        if (!grown){
+            match->failed = 1;
+            return 0;
+        }
+        match->dirs = grown;
+        match->cap = cap;
+    }
+    match->dirs[match->count++] = (FsNode*)node;
+    return 0;
+}
+
+// Conteúdo de um diretório operando, com o cabeçalho "nome:" quando há mais de uma listagem
+static void ls_dir_section(FsNode* dir, const char* name, const FsListOptions* opt, int header, int* sections){
+    if (header){
+        printf("%s%s:\n", *sections ? "\n" : "", name);
+        fflush(stdout);
+    }
+    if (fs_list_dir(dir, opt, NULL, NULL, STDOUT_FILENO) < 0){
+        printf("ls: Erro ao listar\n");
+    }
+    (*sections)++;
+}
+
+// Lista os operandos: arquivos que casam com algum padrão primeiro (uma única passada
+// pelo diretório atual), depois o conteúdo de cada diretório, como o ls do Linux.
+// "." e ".." são resolvidos antes, sem passar pelos padrões
+static void ls_match_set(char** operands, int count, const FsListOptions* opt){
+    FsNode* dots[MAX_TOKENS];
+    const char* dot_names[MAX_TOKENS];
+    char* patterns[MAX_TOKENS];
+    int dot_count = 0, pattern_count = 0;
+    for (int i = 0; i < count; i++){
+        if (strcmp(operands[i], ".") == 0 || strcmp(operands[i], "..") == 0){
+            int up = operands[i][1] == '.' && fs_current_dir->parent;
+            dots[dot_count] = up ? fs_current_dir->parent : fs_current_dir;
+            dot_names[dot_count++] = operands[i];
+        } else {
+            patterns[pattern_count++] = operands[i];
+        }
+    }
+
+    FsGlobSet set;
+    if (fs_globset_compile(&set, patterns, pattern_count) != 0){
+        printf("ls: Padrao invalido\n");
+        return;
+    }
+    LsMatch match = { &set, NULL, 0, 0, 0 };
+
+    // Uma única passada pelo diretório para todos os padrões
+    long files = 0;
+    if (pattern_count > 0){
+        files = fs_list_dir(fs_current_dir, opt, ls_glob_filter, &match, STDOUT_FILENO);
+        if (files < 0 || match.failed){
+            printf("ls: Erro ao listar\n");
+            files = files < 0 ? 0 : files;
+        }
+    }
+
+    for (int i = 0; i < set.count; i++){
+        if (!set.hits[i]){
+            printf("ls: Diretorio ou arquivo '%s' nao encontrado\n", set.globs[i].text);
+        }
+    }
+
+    int header = files > 0 || dot_count + match.count > 1;
+    int sections = files > 0;
+    for (int i = 0; i < dot_count; i++){
+        ls_dir_section(dots[i], dot_names[i], opt, header, &sections);
+    }
+    for (int i = 0; i < match.count; i++){
+        ls_dir_section(match.dirs[i], match.dirs[i]->name, opt, header, &sections);
+    }
+
+    free(match.dirs);
+    fs_globset_free(&set);
+}
+
+// Valor de --limit/--offset (inteiro >= 0)
+static int ls_parse_count(const char* text, size_t* value){
+    char* end = NULL;
+    long v = strtol(text, &end, 10);
+    if (*text == '\0' || *end != '\0' || v < 0) return -1;
+    *value = (size_t)v;
+    return 0;
+}
+
+// ls [-l] [-S|-t] [--limit N] [--offset N] [nome|padrao]...
+void cmd_ls(int argc, char** argv){
+    FsNode* target = fs_current_dir;
+    FsListOptions opt = { 0, FS_LIST_SORT_NONE, 0, 0 };
+
+    char* operands[MAX_TOKENS];
+    int count = 0;
+    for (int i = 1; i < argc; i++){
+        const char* arg = argv[i];
+        if (strcmp(arg, "--limit") == 0 || strcmp(arg, "--offset") == 0){
+            size_t* field = strcmp(arg, "--limit") == 0 ? &opt.limit : &opt.offset;
+            if (i + 1 >= argc || ls_parse_count(argv[i + 1], field) != 0){
+                printf("ls: Valor invalido para %s\n", arg);
+                return;
+            }
+            i++;
+        } else if (arg[0] == '-' && arg[1] != '\0' && arg[1] != '-'){
+            for (const char* flag = arg + 1; *flag; flag++){
+                if (*flag == 'l'){
+                    opt.long_format = 1;
+                } else if (*flag == 'S'){
+                    opt.sort = FS_LIST_SORT_SIZE;
+                } else if (*flag == 't'){
+                    opt.sort = FS_LIST_SORT_TIME;
+                } else {
+                    printf("ls: Opcao invalida '-%c'\n", *flag);
+                    printf("Uso: ls [-l] [-S|-t] [--limit N] [--offset N] [nome|padrao]...\n");
+                    return;
+                }
+            }
+        } else if (count < MAX_TOKENS){
+            operands[count++] = argv[i];
+        }
+    }
+
+    // O motor de listagem escreve direto no descritor: o que o stdio guardou sai antes
+    fflush(stdout);
+
+    // Vários nomes ou padrões: lista o conjunto de entradas que casam
+    if (count > 1 || (count == 1 && fs_glob_has_magic(operands[0]))){
+        ls_match_set(operands, count, &opt);
+        return;
+    }
+
+    // Se um nome for fornecido, tenta encontrar esse diretório
+    if (count == 1){
+        const char* name = operands[0];
+
+        if (strcmp(name, ".") == 0){
+            // Já está no diretório atual
+        } else if (strcmp(name, "..") == 0) { // Sair para pasta pai
+            if (fs_current_dir->parent){
+                target = fs_current_dir->parent;
+            }
+        } else {
+            FsNode* child = fs_find_child(fs_current_dir, name);
+            if (!child){
+                printf("ls: Diretorio ou arquivo '%s' nao encontrado\n", name);
+                return;
+            }
+            target = child;
+        }
+    }
+
+    // Um arquivo: a mesma linha que ele teria na listagem do diretório
+    int failed = target->type == NODE_FILE ? fs_list_node(target, opt.long_format, STDOUT_FILENO) < 0
+                                           : fs_list_dir(target, &opt, NULL, NULL, STDOUT_FILENO) < 0;
+    if (failed){
+        printf("ls: Erro ao listar\n");
+    }
+}
+
+// Mudar diretório 
+void cmd_cd(int argc, char** argv){
+    if (argc < 2){
+        // Sem argumento, volta para a raíz
+        fs_current_dir = fs_root;
+        return;
+    }
+
+    // Pega o caminho fornecido
+    const char* path = argv[1];
+
+    if (strcmp(path, "/") == 0){
+        fs_current_dir = fs_root; // Vai para raíz
+        return;
+    } else if (strcmp(path, ".") == 0){
+        // Fica no diretório atual
+    } else if (strcmp(path, "..") == 0){
+        if (fs_current_dir->parent){
+            fs_current_dir  = fs_current_dir->parent; // Sobe para o pai
+        }
+        return;
+    } else {
+        FsNode* child = fs_find_child(fs_current_dir, path);
+        if(!child || child->type != NODE_DIR){ 
+            printf("cd: Diretorio '%s' nao encontrado\n", path);
+            return;
+        }
+        fs_current_dir  = child; // Muda para o diretório encontrado
+    }
+}
+
+void cmd_touch(int argc, char** argv){
+    if (argc < 2){
+        printf("Uso: touch <nome_arquivo>\n");
+        return;
+    }
+
+    for (int i = 1; i < argc; i++){
+        const char* name = argv[i];
+
+        if (strlen(name) == 0 || strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+            printf("touch: Nome de arquivo inválido '%s'\n", name);
+            continue;
+        }
+
+        if (strchr(name, '/')){
+            printf("touch: Nome de arquivo nao pode conter '/': '%s'\n", name);
+            continue;
+        }
+        FsNode* existing = fs_find_child(fs_current_dir, name);
+        if (existing){
+            if (existing->type == NODE_DIR){
+                printf("touch: Já existe um diretório com esse nome: '%s'\n", name);
+                continue;
+            } 
+            // arquivo já existe -> atualiza timestamps
+            if (existing->fcb) {
+                snap_touch(existing);
+                fs_time_modify(existing->fcb);
+            }
+        } else {
+            const FsNode* over = NULL;
+            if (fs_usage_check(fs_current_dir, fs_current_user_class, 0, 1, &over) != 0){
+                cmd_report_quota("touch", over);
+                continue;
+            }
+            // Cria novo arquivo
+            FsNode* new_file = fs_create_node(name, NODE_FILE, fs_current_dir);
+            new_file->fcb = create_fcb(name, FILETYPE_TEXT); // Por enquanto, todos são arquivos de texto
+            fs_add_child(fs_current_dir, new_file);
+        }
+    }
+
+}
+
+#define WRITE_CHUNK 4096 // Trecho lido por vez da entrada (heredoc e '-')
+
+// Por que o write parou de gravar: o resto da entrada só é consumido
+typedef enum {
+    WRITE_OK,
+    WRITE_REFUSED,   // Destino recusado antes da leitura (a mensagem já saiu)
+    WRITE_TOO_BIG,   // Passou de blocks_max_file_size()
+    WRITE_QUOTA,
+    WRITE_NO_SPACE,  // A reserva da alocação adiada não coube no disco
+    WRITE_NO_MEMORY
+} WriteStatus;
+
+// A entrada do write vai trecho a trecho direto para o arquivo: fcb->content cresce
+// em dobro e a alocação adiada reserva os blocos novos a cada trecho
+typedef struct {
+    FsNode*       node;
+    WriteStatus   status;
+    const FsNode* over;  // Diretório com a cota estourada (NULL = cota do usuário)
+} WriteInput;
+
+static void write_append(WriteInput* in, const char* data, size_t len){
+    if (in->status != WRITE_OK || len == 0) return;
+
+    FCB* fcb = in->node->fcb;
+    if (len > blocks_max_file_size() - fcb->size){
+        in->status = WRITE_TOO_BIG;
+        return;
+    }
+    size_t size = fcb->size + len;
+
+    // Cotas a cada bloco novo: os totais dos diretórios ainda contam o arquivo vazio
+    long blocks = fs_usage_estimate_blocks(size);
+    if (blocks != fs_usage_estimate_blocks(fcb->size) &&
+        fs_usage_check(in->node->parent, fcb->owner, blocks, 0, &in->over) != 0){
+        in->status = WRITE_QUOTA;
+        return;
+    }
+
+    size_t capacity = mem_capacity(fcb->content);
+    if (size + 1 > capacity){
+        capacity = capacity * 2 > size + 1 ? capacity * 2 : size + 1;
+        char* grown = (char*)mem_realloc(MEM_CONTENT, fcb->content, capacity);
+        if (!grown){
+            in->status = WRITE_NO_MEMORY;
+            return;
+        }
+        fcb->content = grown;
+    }
+    memcpy(fcb->content + fcb->size, data, len);
+    fcb->content[size] = '\0';
+    fcb->size = size;
+
+    // Só reserva os blocos que faltam (inline, compressão e deduplicação alocam no fim)
+    if (delalloc_grow(fcb, size) < 0){
+        in->status = WRITE_NO_SPACE;
+    }
+}
+
+// write <arq> <<FIM: linhas até uma linha igual a delim. Linhas maiores que o trecho
+// chegam em partes; só um começo de linha pode ser o terminador.
+// Retorna 0 ou -1 se a entrada acabar antes do terminador
+static int write_read_heredoc(WriteInput* in, const char* delim){
+    char chunk[WRITE_CHUNK];
+    size_t delim_len = strlen(delim);
+    int line_start = 1;
+
+    while (fgets(chunk, sizeof(chunk), stdin)){
+        size_t n = strlen(chunk);
+        int complete = n > 0 && chunk[n - 1] == '\n';
+        size_t text_len = complete ? n - 1 : n;
+
+        if (line_start && (complete || feof(stdin)) && text_len == delim_len &&
+            memcmp(chunk, delim, delim_len) == 0){
+            return 0;
+        }
+        write_append(in, chunk, n);
+        line_start = complete;
+    }
+    clearerr(stdin); // No terminal, o Ctrl+D encerra só o write: a shell continua lendo
+    return -1;
+}
+
+// write <arq> -: a entrada padrão inteira, em trechos, até o fim (seguro para binários)
+static void write_read_stdin(WriteInput* in){
+    char chunk[WRITE_CHUNK];
+    size_t n;
+    do {
+        n = fread(chunk, 1, sizeof(chunk), stdin);
+        write_append(in, chunk, n);
+    } while (n == sizeof(chunk)); // Trecho curto: fim da entrada (não lê de novo após o Ctrl+D)
+    clearerr(stdin);
+}
+
+// Abre (ou cria) o destino do write e o esvazia, como o '>' da shell. Retorna NULL
+// (depois de avisar) se o destino for recusado
+static FsNode* write_open_target(const char* file_name){
+    if (strchr(file_name, '/')){
+        printf("write: Nome de arquivo nao pode conter '/': '%s'\n", file_name);
+        return NULL;
+    }
+
+    // Verificar se o arquivo já existe
+    FsNode* node = fs_find_child(fs_current_dir, file_name);
+
+    if(!node){
+        const FsNode* over = NULL;
+        if (fs_usage_check(fs_current_dir, fs_current_user_class, 0, 1, &over) != 0){
+            cmd_report_quota("write", over);
+            return NULL;
+        }
+        // Cria novo arquivo
+        node = fs_create_node(file_name, NODE_FILE, fs_current_dir);
+        node->fcb = create_fcb(file_name, FILETYPE_TEXT);
+        fs_add_child(fs_current_dir, node);
+        return node;
+    }
+
+    if (node->type == NODE_DIR){
+        printf("write: '%s' nao e um arquivo\n", file_name);
+        return NULL;
+    }
+    if (!node->fcb){
+        snap_touch(node);
+        node->fcb = create_fcb(file_name, FILETYPE_TEXT);
+        return node;
+    }
+    // Verifica se há permissão de escrita
+    if(!perms_can_write(node->fcb)){
+        printf("write: Permissão negada para escrever no arquivo '%s'\n", file_name);
+        return NULL;
+    }
+    snap_touch(node);
+
+    // Sobrescrever arquivo: a versão anterior sai antes da entrada chegar
+    blocks_free_for_file(node->fcb);
+    mem_free(MEM_CONTENT, node->fcb->content);
+    node->fcb->content = NULL;
+    node->fcb->size = 0;
+    fs_usage_refresh(node);
+    return node;
+}
+
+void cmd_write(int argc, char** argv){
+    if (argc < 3){
+       printf("Uso: write <nome_arquivo> <texto> | - | <<FIM\n");
+       return;
+    }
+
+    const char* file_name = argv[1];
+
+    // O terminador do heredoc pode vir colado (<<FIM) ou separado (<< FIM)
+    const char* delim = NULL;
+    if (strncmp(argv[2], "<<", 2) == 0){
+        delim = argv[2][2] ? argv[2] + 2 : (argc > 3 ? argv[3] : NULL);
+        if (!delim){
+            printf("Uso: write <nome_arquivo> <<FIM\n");
+            return;
+        }
+    }
+
+    // Mesmo com o destino recusado a entrada é consumida: o corpo do heredoc nunca
+    // pode ser executado como comandos da shell
+    WriteInput in = { write_open_target(file_name), WRITE_OK, NULL };
+    if (!in.node) in.status = WRITE_REFUSED;
+
+    if (delim){
+        if (write_read_heredoc(&in, delim) != 0){
+            printf("write: Entrada terminou antes de '%s'\n", delim);
+        }
+    } else if (argc == 3 && strcmp(argv[2], "-") == 0){
+        write_read_stdin(&in);
+    } else {
+        for (int i = 2; i < argc; i++){
+            if (i > 2) write_append(&in, " ", 1);
+            write_append(&in, argv[i], strlen(argv[i]));
+        }
+    }
+    if (in.status == WRITE_REFUSED) return;
+
+    FCB* fcb = in.node->fcb;
+    if (in.status == WRITE_OK && fcb->content && mem_capacity(fcb->content) > fcb->size + 1){
+        // Devolve a folga do crescimento em dobro
+        char* fitted = (char*)mem_realloc(MEM_CONTENT, fcb->content, fcb->size + 1);
+        if (fitted) fcb->content = fitted;
+    }
+
+    // Pendente, o arquivo já tem a reserva; os demais são alocados agora
+    if (in.status == WRITE_OK && !fcb->delalloc && delalloc_write(fcb) != 0){
+        in.status = WRITE_NO_SPACE;
+    }
+
+    switch (in.status){
+        case WRITE_TOO_BIG:
+            printf("write: Conteudo maior que o limite de %zu bytes por arquivo\n", blocks_max_file_size());
+            break;
+        case WRITE_QUOTA:
+            cmd_report_quota("write", in.over);
+            break;
+        case WRITE_NO_SPACE:
+            printf("write: Falha ao alocar blocos para '%s' (disco cheio ou arquivo muito grande)\n", file_name);
+            break;
+        case WRITE_NO_MEMORY:
+            fprintf(stderr, "Erro ao alocar memoria para conteudo do arquivo\n");
+            break;
+        default:
+            break;
+    }
+    if (in.status != WRITE_OK){
+        // Gravação interrompida: o arquivo fica vazio (o fsck acusaria um arquivo sem dados no disco)
+        blocks_free_for_file(fcb);
+        mem_free(MEM_CONTENT, fcb->content);
+        fcb->content = NULL;
+        fcb->size = 0;
+    }
+
+    fs_usage_refresh(in.node); // Totais dos diretórios acima
+    fs_time_modify(fcb);
+}
+
+// truncate <arquivo> <tamanho>: corta o arquivo ou o estende com um buraco (lê como zeros,
+// sem ocupar blocos). Cria o arquivo se ele não existir
+void cmd_truncate(int argc, char** argv){
+    if (argc < 3){
+        printf("Uso: truncate <nome_arquivo> <tamanho>\n");
+        return;
+    }
+
+    const char* file_name = argv[1];
+    if (strchr(file_name, '/')){
+        printf("truncate: Nome de arquivo nao pode conter '/': '%s'\n", file_name);
+        return;
+    }
+
+    char* end = NULL;
+    long value = strtol(argv[2], &end, 10);
+    if (*argv[2] == '\0' || *end != '\0' || value < 0){
+        printf("truncate: Tamanho invalido '%s'\n", argv[2]);
+        return;
+    }
+    size_t size = (size_t)value;
+    if (size > blocks_max_file_size()){
+        printf("truncate: Tamanho maximo de arquivo e %zu bytes\n", blocks_max_file_size());
+        return;
+    }
+
+    FsNode* node = fs_find_child(fs_current_dir, file_name);
+    if (node && node->type == NODE_DIR){
+        printf("truncate: '%s' nao e um arquivo\n", file_name);
+        return;
+    }
+    if (node && node->fcb && !perms_can_write(node->fcb)){
+        printf("truncate: Permissão negada para escrever no arquivo '%s'\n", file_name);
+        return;
+    }
+
+    // Cotas: estender só cria buracos, então em geral nada muda
+    const FsNode* over = NULL;
+    UserClass owner = (node && node->fcb) ? node->fcb->owner : fs_current_user_class;
+    long blocks = (node && node->fcb) ? fs_usage_truncate_blocks(node->fcb, size) : 0;
+    if (fs_usage_check(fs_current_dir, owner, blocks, node ? 0 : 1, &over) != 0){
+        cmd_report_quota("truncate", over);
+        return;
+    }
+
+    if (!node){
+        node = fs_create_node(file_name, NODE_FILE, fs_current_dir);
+        node->fcb = create_fcb(file_name, FILETYPE_TEXT);
+        fs_add_child(fs_current_dir, node);
+    } else {
+        snap_touch(node);
+        if (!node->fcb) node->fcb = create_fcb(file_name, FILETYPE_TEXT);
+    }
+
+    if (blocks_truncate_file(node->fcb, size) != 0){
+        printf("truncate: Falha ao mudar o tamanho de '%s' (disco cheio)\n", file_name);
+    }
+    fs_usage_refresh(node);
+    fs_time_modify(node->fcb);
+}
+
+
+// Imprime o conteúdo de um único arquivo já localizado
+static void cat_node(FsNode* node){
+    if(node->type == NODE_DIR){
+        printf("cat: '%s' não é um arquivo\n", node->name);
+        return;
+    }
+
+    if(!node->fcb){
+        printf("cat: Arquivo '%s' não possui FCB\n", node->name);
+        return;
+    }
+
+    if(!perms_can_read(node->fcb)){
+        printf("cat: Permissão negada para ler o arquivo '%s'\n", node->name);
+        return;
+    }
+
+    if(node->fcb->size == 0){
+         // Arquivo vazio
+        fs_time_access(node);
+        return;
+    }
+
+    // Envia os blocos direto do disco simulado para a saída, sem passar pelo stdio.
+    // O stdout precisa ser esvaziado antes para manter a ordem das mensagens.
+    fflush(stdout);
+    if (blocks_writev_file(node->fcb, STDOUT_FILENO, "\n", 1) < 0){
+        if (errno == EIO){
+            printf("cat: Erro de checksum nos blocos de '%s'\n", node->name);
+        }
+        // Blocos incompletos ou corrompidos: usa a cópia em memória
+        if (node->fcb->content){
+            fwrite(node->fcb->content, 1, node->fcb->size, stdout);
+            fputc('\n', stdout);
+        }
+    }
+    fs_time_access(node); // Conforme a política de montagem (noatime/relatime/lazytime)
+}
+
+// Imprime o conteúdo de todos os arquivos que casam com os operandos
+void cmd_cat(int argc, char** argv){
+    if (argc < 2){
+        printf("Uso: cat <nome_arquivo|padrao>...\n");
+        return;
+    }
+
+    FsGlobSet set;
+    if (compile_operands("cat", &set, &argv[1], argc - 1) != 0){
+        return;
+    }
+
+    // Concatena na ordem dos operandos, como o cat do sistema
+    FsNode** nodes = NULL;
+    int n = match_in_operand_order(&set, &nodes);
+    if (n < 0){
+        printf("cat: Memoria insuficiente\n");
+        fs_globset_free(&set);
+        return;
+    }
+    for (int i = 0; i < n; i++){
+        cat_node(nodes[i]);
+    }
+    free(nodes);
+
+    report_unmatched("cat", &set);
+    fs_globset_free(&set);
+}
+
+void cmd_cp(int argc, char** argv){
+    if(argc < 3){
+        printf("Uso: cp <src> <dst>\n");
+        return;
+    }
+
+    const char* src_name = argv[1];
+    const char* dst_name = argv[2];
+
+    if(strchr(src_name, '/')){
+        printf("cp: Nomes de arquivo nao podem conter '/'\n");
+        return;
+    }
+
+    // Procura o arquivo de origem
+    FsNode* src = fs_find_child(fs_current_dir, src_name);
+    if(!src){
+        printf("cp: Arquivo de origem '%s' nao encontrado\n", src_name);
+        return;
+    }
+
+    if(src->type == NODE_DIR){
+        printf("cp: '%s' nao e um arquivo\n", src_name);
+        return;
+    }
+
+    if(!src->fcb){
+        printf("cp: Arquivo de origem '%s' nao possui FCB\n", src_name);
+        return;
+    }
+
+    if(!perms_can_read(src->fcb)){
+        printf("cp: Permissão negada para ler o arquivo '%s'\n", src_name);
+        return;
+    }
+
+    if(fs_find_child(fs_current_dir, dst_name)){
+        printf("cp: Não foi possível criar arquivo. Arquivo de destino '%s' ja existe\n", dst_name);
+        return;
+    }
+
+    const FsNode* over = NULL;
+    if (fs_usage_check(fs_current_dir, fs_current_user_class, fs_usage_file_blocks(src->fcb), 1, &over) != 0){
+        cmd_report_quota("cp", over);
+        return;
+    }
+
+    // Cria o novo arquivo
+    FsNode* dst = fs_create_node(dst_name, NODE_FILE, fs_current_dir);
+    dst->fcb = create_fcb(dst_name, src->fcb->type);
+
+
+    // Copia os dados bloco a bloco, direto no disco simulado
+    dst->fcb->size = src->fcb->size;
+    if (blocks_copy_file(dst->fcb, src->fcb) != 0) {
+        printf("cp: Falha ao alocar blocos para '%s'\n", dst_name);
+        fs_free_node(dst);
+        return;
+    }
+
+    // Mantém também a cópia em memória, se a origem tiver uma
+    if (src->fcb->content && src->fcb->size > 0) {
+        dst->fcb->content = (char*)mem_alloc(MEM_CONTENT, src->fcb->size + 1);
+        if(!dst->fcb->content){
+            fprintf(stderr, "Erro ao alocar memoria para conteudo do arquivo\n");
+            fs_free_node(dst);
+            return;
+        }
+        memcpy(dst->fcb->content, src->fcb->content, src->fcb->size);
+        dst->fcb->content[src->fcb->size] = '\0';
+    }
+
+    // timestamp do dst
+    time_t now = fs_clock_now();
+    dst->fcb->created_at = now;
+    dst->fcb->modified_at = now;
+    dst->fcb->accessed_at = now;
+
+    fs_add_child(fs_current_dir, dst);
+}
+    
+void cmd_mv(int argc, char** argv){
+    if(argc < 3){
+        printf("Uso: mv <old> <new>\n");
+        return;
+    }
+
+    const char* old_name = argv[1];
+    const char* new_name = argv[2];
+
+    FsNode* node = fs_find_child(fs_current_dir, old_name);
+    if(!node){
+        printf("mv: Arquivo '%s' nao encontrado\n", old_name);
+        return;
+    }
+
+    // Mover para o diretório pai
+    if (strcmp(new_name, "..") == 0){
+        if(!fs_current_dir->parent){
+            printf("mv: Direttório pai não existe\n");
+            return;
+        }
+        
+        FsNode* parent = fs_current_dir->parent;
+
+        if(fs_find_child(parent, node->name)){
+            printf("mv: Não foi possível mover. Arquivo '%s' ja existe em '%s'\n", node->name, parent->name);
+            return;
+        }
+
+        const FsNode* over = NULL;
+        if (fs_usage_check_move(node, parent, &over) != 0){
+            cmd_report_quota("mv", over);
+            return;
+        }
+
+        fs_move_node(node, parent);
+        return;
+    }
+
+    // Primeiro tenta interpretar new_name como como diretorio de destino
+    FsNode* maybe_dir = fs_find_child(fs_current_dir, new_name);
+    if(maybe_dir && maybe_dir->type == NODE_DIR){
+        if(fs_find_child(maybe_dir, node->name)){
+            printf("mv: Não foi possível mover. Arquivo '%s' ja existe em '%s'\n", node->name, new_name);
+            return;
+        }
+        const FsNode* over = NULL;
+        if (fs_usage_check_move(node, maybe_dir, &over) != 0){
+            cmd_report_quota("mv", over);
+            return;
+        }
+        fs_move_node(node, maybe_dir);
+        return;
+    }
+
+    // Se não for diretório, tenta renomear
+    if(strchr(new_name, '/')){
+        printf("mv: Nomes de arquivo nao podem conter '/'\n");
+        return;
+    }
+
+    if(fs_find_child(fs_current_dir, new_name)){
+        printf("mv: Não foi possível renomear. Arquivo '%s' ja existe\n", new_name);
+        return;
+    }
+
+    if(node->fcb && !perms_can_write(node->fcb)){
+        printf("mv: Permissão negada para renomear o arquivo '%s'\n", old_name);
+        return;
+    }
+
+    // Renomeia
+    snap_touch(node);
+    fs_rename_node(node, new_name); // Se for arquivo, renomeia no FCB também
+
+}
+
+// Remove todos os arquivos que casam com os operandos em uma única passada
+void cmd_rm(int argc, char** argv){
+    if(argc < 2){
+        printf("Uso: rm <nome_arquivo|padrao>...\n");
+        return;
+    }
+
+    FsGlobSet set;
+    if (compile_operands("rm", &set, &argv[1], argc - 1) != 0){
+        return;
+    }
+
+    FsNode* prev  = NULL;
+    FsNode* child = fs_current_dir->first_child;
+    while (child){
+        FsNode* next = child->next_sibling;
+
+        if (fs_globset_match(&set, child->name) >= 0){
+            if(child->type == NODE_DIR){
+                printf("rm: '%s' nao e um arquivo\n", child->name);
+            } else if (child->fcb && !perms_can_write(child->fcb)) {
+                printf("rm: Permissao negada para excluir '%s'\n", child->name);
+            } else {
+                // Já conhecemos o irmão anterior: remove sem percorrer a lista de novo
+                fs_remove_child_after(fs_current_dir, prev, child);
+                child = next;
+                continue;
+            }
+        }
+
+        prev  = child;
+        child = next;
+    }
+
+    report_unmatched("rm", &set);
+    fs_globset_free(&set);
+}
+
+void cmd_whoami(){
+    const char* name = "unknown";
+
+    switch (fs_current_user_class){
+        case USER_OWNER:
+            name = "owner";
+            break;
+        case USER_GROUP:
+            name = "group";
+            break;
+        case USER_OTHER:
+            name = "other";
+            break;
+        default:
+            break;
+    }
+
+    printf("%s\n", name);    
+}
+
+void cmd_user(int argc, char** argv){
+    if (argc < 2){
+        printf("Uso: user <owner|group|other>\n");
+        return;
+    }
+
+    const char* role = argv[1];
+
+    if (strcmp(role, "owner") == 0){
+        fs_current_user_class = USER_OWNER;
+    } else if (strcmp(role, "group") == 0){
+        fs_current_user_class = USER_GROUP;
+    } else if (strcmp(role, "other") == 0){
+        fs_current_user_class = USER_OTHER;
+    } else {
+        printf("user: Usuario desconhecido '%s'\n", role);
+    }
+}
+
+void cmd_chmod(int argc, char** argv){
+    if (argc < 3){
+        printf("Uso: chmod <perms> <file|padrao>...\n");
+        return;
+    }
+
+    const char* perm_text = argv[1];
+
+    int ok = 0;
+
+    unsigned int perms = perms_parse_numeric(perm_text, &ok);
+
+    if(!ok){
+        printf("chmod: Permissoes invalidas: '%s'\n", perm_text);
+        return;
+    }
+
+    FsGlobSet set;
+    if (compile_operands("chmod", &set, &argv[2], argc - 2) != 0){
+        return;
+    }
+
+    char perm_str[10];
+    perms_to_string(perms, perm_str, sizeof(perm_str));
+
+    for (FsNode* node = fs_current_dir->first_child; node; node = node->next_sibling){
+        if (fs_globset_match(&set, node->name) < 0){
+            continue;
+        }
+
+        if(node->type == NODE_DIR){
+            printf("chmod: '%s' nao e um arquivo\n", node->name);
+            continue;
+        }
+
+        if(!node->fcb){
+            printf("chmod: Arquivo '%s' nao possui FCB\n", node->name);
+            continue;
+        }
+
+        snap_touch(node);
+        node->fcb->permissions = perms;
+        printf("Permissoes de '%s' alteradas para %s \n", node->name, perm_str);
+    }
+
+    report_unmatched("chmod", &set);
+    fs_globset_free(&set);
+}
+
+// Mostra os metadados de um único arquivo já localizado
+static void stat_node(const FsNode* node){
+    if (node->type == NODE_DIR){
+        printf("stat: '%s' nao e um arquivo\n", node->name);
+        return;
+    }
+
+    if(!node->fcb){
+        printf("stat: Arquivo '%s' nao possui FCB\n", node->name);
+        return;
+    }
+
+    FCB* fcb = node->fcb;
+
+    char perms[10];
+    perms_to_string(fcb->permissions, perms, sizeof(perms));
+
+    const char* owner_name = "unknown";
+    switch (fcb->owner){
+        case USER_OWNER: owner_name = "owner"; break;
+        case USER_GROUP: owner_name = "group"; break;
+        case USER_OTHER: owner_name = "other"; break;
+    }
+
+    printf("  Estatisticas de '%s':\n", node->name);
+    // Tamanho lógico (o que se lê) e alocado (o que ocupa o disco): buracos só estão no mapa
+    int allocated = blocks_allocated(fcb);
+    int holes = fcb->inlined ? 0 : fcb->block_count - allocated;
+    printf("  Tamanho: %zu bytes\n", fcb->size);
+    printf("  Tamanho fisico: %zu bytes em %d blocos%s\n", blocks_physical_size(fcb),
+           allocated, fcb->compressed ? " (comprimido)" : fcb->inlined ? " (inline no FCB)" :
+           fcb->delalloc ? " (alocacao adiada)" : holes > 0 ? " (esparso)" : "");
+    printf("  Permissoes: %s\n", perms);
+    printf("  Proprietario: %s\n", owner_name);
+    printf("  Inode: %d\n", fcb->inode);
+    printf("  Criado em: %s", ctime(&fcb->created_at));
+    printf("  Modificado em: %s", ctime(&fcb->modified_at));
+    time_t accessed_at = fs_time_accessed(node);
+    printf("  Ultimo acesso em: %s", ctime(&accessed_at));
+    if (holes > 0){
+        printf("  Blocos alocados (%d, %d buracos): ", allocated, holes);
+    } else {
+        printf("  Blocos alocados (%d): ", allocated);
+    }
+
+    blocks_dump_file(fcb);
+}
+
+void cmd_stat(int argc, char** argv){
+    if(argc < 2){
+        printf("Uso: stat <nome_arquivo|padrao>...\n");
+        return;
+    }
+
+    FsGlobSet set;
+    if (compile_operands("stat", &set, &argv[1], argc - 1) != 0){
+        return;
+    }
+
+    FsNode** nodes = NULL;
+    int n = match_in_operand_order(&set, &nodes);
+    if (n < 0){
+        printf("stat: Memoria insuficiente\n");
+        fs_globset_free(&set);
+        return;
+    }
+    for (int i = 0; i < n; i++){
+        stat_node(nodes[i]);
+    }
+    free(nodes);
+
+    report_unmatched("stat", &set);
+    fs_globset_free(&set);
+}
+
+void cmd_df(){
+    int total_blocks = 0;
+    int used_blocks  = 0;
+    int free_blocks  = 0;
+    long references  = 0;
+
+    blocks_stats_refs(&total_blocks, &used_blocks, &free_blocks, &references);
+
+    size_t capacity_bytes = (size_t)total_blocks * FS_BLOCK_SIZE;
+
+    printf("  Blocos totais: %d\n", total_blocks);
+    printf("  Blocos usados: %d\n", used_blocks);
+    printf("  Blocos livres: %d\n", free_blocks);
+    printf("  Tamanho de bloco: %d bytes\n", FS_BLOCK_SIZE);
+    printf("  Capacidade total aproximada: %zu bytes\n", capacity_bytes);
+
+    // Só as referências criadas pela deduplicação contam como economia; blocos presos
+    // por snapshots (ou restaurados já compartilhados) aparecem à parte
+    long saved = dedup_saved_blocks();
+    if (dedup_enabled()){
+        double ratio = used_blocks > 0 ? (double)(used_blocks + saved) / (double)used_blocks : 1.0;
+        printf("  Deduplicacao: ligada (razao %.2f:1, %ld blocos economizados)\n", ratio, saved);
+    } else {
+        printf("  Deduplicacao: desligada\n");
+    }
+    long shared = references - used_blocks - saved;
+    if (shared > 0){
+        printf("  Blocos compartilhados: %ld referencias extras (snapshots, rollback, checkpoint)\n", shared);
+    }
+
+    char options[64];
+    fs_time_describe(options, sizeof(options));
+    printf("  Montagem: %s (%d acessos pendentes)\n", options, fs_time_pending());
+
+    int  pending = 0, reserved = 0;
+    long flushed = 0, cancelled = 0;
+    delalloc_stats(&pending, &reserved, &flushed, &cancelled);
+    printf("  Alocacao adiada: %d arquivos, %d blocos reservados (%ld descarregados, %ld cancelados)\n",
+           pending, reserved, flushed, cancelled);
+
+    if (blkio_is_open()){
+        BlkioStats io;
+        blkio_get_stats(&io);
+        printf("  Imagem: %s (%s, fila %d): %ld lotes, %ld requisicoes, %ld blocos, %ld chamadas, %ld erros\n",
+               blkio_path(), blkio_backend_name(), blkio_queue_depth(),
+               io.batches, io.requests, io.blocks, io.syscalls, blocks_image_errors());
+
+        int  dirty = 0;
+        long rounds = 0, written = 0;
+        blocks_writeback_stats(&dirty, &rounds, &written);
+        printf("  Blocos sujos: %d (%.1f%% do disco; %ld descargas gravaram %ld blocos)\n",
+               dirty, total_blocks > 0 ? 100.0 * dirty / total_blocks : 0.0, rounds, written);
+
+        long issued = 0, hits = 0, waste = 0;
+        blocks_readahead_stats(&issued, &hits, &waste);
+        printf("  Leitura antecipada: %ld blocos pedidos, %ld acertos, %ld desperdicados\n",
+               issued, hits, waste);
+    }
+}
+
+// Uma linha do du: totais já mantidos no diretório, sem percorrer a subárvore
+static void du_print(const FsNode* node){
+    FsUsage u;
+    fs_usage_get(node, &u);
+
+    char path[PATH_MAX_LEN];
+    fs_get_path((FsNode*)node, path, sizeof(path));
+    printf("%8ld blocos %10ld bytes %8ld inodes  %s\n", u.blocks, u.bytes, u.inodes, path);
+}
+
+// Uso em disco do diretório atual ou das entradas que casam com os operandos
+void cmd_du(int argc, char** argv){
+    if (argc < 2){
+        du_print(fs_current_dir);
+        return;
+    }
+    if (argc == 2 && strcmp(argv[1], ".") == 0){
+        du_print(fs_current_dir);
+        return;
+    }
+    if (argc == 2 && strcmp(argv[1], "..") == 0){
+        du_print(fs_current_dir->parent ? fs_current_dir->parent : fs_current_dir);
+        return;
+    }
+
+    FsGlobSet set;
+    if (compile_operands("du", &set, &argv[1], argc - 1) != 0){
+        return;
+    }
+
+    for (FsNode* node = fs_current_dir->first_child; node; node = node->next_sibling){
+        if (fs_globset_match(&set, node->name) >= 0){
+            du_print(node);
+        }
+    }
+
+    report_unmatched("du", &set);
+    fs_globset_free(&set);
+}
+
+// Uso e limite de uma cota ("-" = sem limite)
+static void quota_print(const char* label, const FsUsage* u){
+    char blocks[24] = "-", inodes[24] = "-";
+    if (u->max_blocks > 0) snprintf(blocks, sizeof(blocks), "%ld", u->max_blocks);
+    if (u->max_inodes > 0) snprintf(inodes, sizeof(inodes), "%ld", u->max_inodes);
+    printf("  %-24s %ld/%s blocos, %ld/%s inodes, %ld bytes\n",
+           label, u->blocks, blocks, u->inodes, inodes, u->bytes);
+}
+
+// Lê um limite de cota (inteiro >= 0; 0 = sem limite)
+static int quota_parse(const char* text, long* value){
+    char* end = NULL;
+    long v = strtol(text, &end, 10);
+    if (*text == '\0' || *end != '\0' || v < 0) return -1;
+    *value = v;
+    return 0;
+}
+
+// quota                                     - cotas que valem aqui
+// quota <dir> <blocos> [inodes]             - cota de um diretório
+// quota -u <owner|group|other> <blocos> [inodes]
+void cmd_quota(int argc, char** argv){
+    static const char* user_names[] = { "owner", "group", "other" };
+
+    if (argc < 2){
+        FsUsage u;
+        for (int i = USER_OWNER; i <= USER_OTHER; i++){
+            char label[32];
+            snprintf(label, sizeof(label), "Usuario %s:", user_names[i]);
+            fs_usage_user((UserClass)i, &u);
+            quota_print(label, &u);
+        }
+
+        // Só a cadeia de diretórios acima do atual: O(profundidade)
+        for (FsNode* dir = fs_current_dir; dir; dir = dir->parent){
+            if (!dir->usage || (dir->usage->max_blocks == 0 && dir->usage->max_inodes == 0)) continue;
+            char path[PATH_MAX_LEN];
+            char label[PATH_MAX_LEN + 16];
+            fs_get_path(dir, path, sizeof(path));
+            snprintf(label, sizeof(label), "Diretorio %s:", path);
+            quota_print(label, dir->usage);
+        }
+        return;
+    }
+
+    int user_mode = strcmp(argv[1], "-u") == 0;
+    int first = user_mode ? 3 : 2; // Primeiro limite
+    long max_blocks = 0, max_inodes = 0;
+    if (argc < first + 1 || argc > first + 2 || quota_parse(argv[first], &max_blocks) != 0 ||
+        (argc == first + 2 && quota_parse(argv[first + 1], &max_inodes) != 0)){
+        printf("Uso: quota [<dir> | -u <owner|group|other>] <blocos> [inodes]  (0 = sem limite)\n");
+        return;
+    }
+
+    if (fs_current_user_class != USER_OWNER){
+        printf("quota: Apenas o usuario owner pode definir cotas\n");
+        return;
+    }
+
+    if (user_mode){
+        for (int i = USER_OWNER; i <= USER_OTHER; i++){
+            if (strcmp(argv[2], user_names[i]) != 0) continue;
+            fs_usage_set_user_quota((UserClass)i, max_blocks, max_inodes);
+            printf("Cota do usuario %s: %ld blocos, %ld inodes (0 = sem limite)\n",
+                   user_names[i], max_blocks, max_inodes);
+            return;
+        }
+        printf("quota: Usuario invalido '%s'\n", argv[2]);
+        return;
+    }
+
+    FsNode* dir = NULL;
+    if (strcmp(argv[1], ".") == 0){
+        dir = fs_current_dir;
+    } else if (strcmp(argv[1], "..") == 0){
+        dir = fs_current_dir->parent ? fs_current_dir->parent : fs_current_dir;
+    } else {
+        dir = fs_find_child(fs_current_dir, argv[1]);
+    }
+    if (!dir || dir->type != NODE_DIR){
+        printf("quota: Diretorio '%s' nao encontrado\n", argv[1]);
+        return;
+    }
+
+    fs_usage_set_quota(dir, max_blocks, max_inodes);
+    char path[PATH_MAX_LEN];
+    fs_get_path(dir, path, sizeof(path));
+    printf("Cota de '%s': %ld blocos, %ld inodes (0 = sem limite)\n", path, max_blocks, max_inodes);
+}
+
+// Memória usada pelo simulador, por categoria
+void cmd_meminfo(){
+    MemTagStats stats[MEM_TAG_COUNT];
+    long total = 0, peak = 0, allocations = 0;
+    mem_stats(stats, &total, &peak);
+
+    printf("  %-14s %10s %14s\n", "Categoria", "Alocacoes", "Bytes");
+    for (int i = 0; i < MEM_TAG_COUNT; i++){
+        printf("  %-14s %10ld %14ld\n", mem_tag_name((MemTag)i), stats[i].count, stats[i].bytes);
+        allocations += stats[i].count;
+    }
+
+    // Nomes internados: um registro por nome distinto, compartilhado por nós e FCBs
+    long distinct = 0, name_refs = 0, name_bytes = 0;
+    fs_name_stats(&distinct, &name_refs, &name_bytes);
+    long metadata = allocations * (long)MEM_CHUNK_OVERHEAD;
+    printf("  Nomes: %ld distintos, %ld referencias, %ld bytes em registros\n",
+           distinct, name_refs, name_bytes);
+    printf("  Metadados do alocador: %ld bytes (%ld alocacoes)\n", metadata, allocations);
+    printf("  Total: %ld bytes + %ld de metadados (pico %ld bytes)\n", total, metadata, peak);
+
+    long files = stats[MEM_FCB].count;
+    if (files > 0 && stats[MEM_NODE].count > 0){
+        long node  = stats[MEM_NODE].bytes / stats[MEM_NODE].count;
+        long fcb   = stats[MEM_FCB].bytes / files;
+        long data  = stats[MEM_CONTENT].bytes / files;
+        long name  = name_bytes / stats[MEM_NODE].count; // Registro dividido por quem o compartilha
+        long chunk = 3 * (long)MEM_CHUNK_OVERHEAD;
+        printf("  Por arquivo: %ld bytes (no %ld + FCB %ld + conteudo %ld + nome %ld + alocador %ld)\n",
+               node + fcb + data + name + chunk, node, fcb, data, name, chunk);
+    }
+}
+
+// Rastreamento de eventos: trace start|stop|dump <arquivo>
+void cmd_trace(int argc, char** argv){
+    long recorded = 0, dropped = 0;
+
+    if (argc < 2){
+        trace_counts(&recorded, &dropped);
+        printf("Rastreamento %s: %ld eventos guardados, %ld perdidos\n",
+               atomic_load(&trace_on) ? "ligado" : "desligado", recorded, dropped);
+        return;
+    }
+
+    if (strcmp(argv[1], "start") == 0){
+        trace_start();
+        printf("Rastreamento ligado\n");
+    } else if (strcmp(argv[1], "stop") == 0){
+        trace_stop();
+        trace_counts(&recorded, &dropped);
+        printf("Rastreamento desligado: %ld eventos guardados, %ld perdidos\n", recorded, dropped);
+    } else if (strcmp(argv[1], "dump") == 0 && argc >= 3){
+        long written = trace_dump(argv[2]);
+        if (written < 0){
+            printf("trace: Nao foi possivel escrever '%s': %s\n", argv[2], strerror(errno));
+            return;
+        }
+        printf("trace: %ld eventos escritos em '%s'\n", written, argv[2]);
+    } else {
+        printf("Uso: trace [start|stop|dump <arquivo_host>]\n");
+    }
+}
+
+void cmd_dedup(int argc, char** argv){
+    if (argc < 2){
+        printf("Deduplicacao %s, %ld blocos reaproveitados\n",
+               dedup_enabled() ? "ligada" : "desligada", dedup_hits());
+        return;
+    }
+
+    if (strcmp(argv[1], "on") == 0){
+        delalloc_flush(); // Os arquivos pendentes entram no índice junto com os demais
+        if (dedup_enable() != 0){
+            printf("dedup: Memoria insuficiente para o indice\n");
+            return;
+        }
+        printf("Deduplicacao ligada\n");
+    } else if (strcmp(argv[1], "off") == 0){
+        dedup_disable();
+        printf("Deduplicacao desligada\n");
+    } else {
+        printf("Uso: dedup [on|off]\n");
+    }
+}
+
+void cmd_compress(int argc, char** argv){
+    if (argc < 2){
+        printf("Compressao %s (clusters de %d bytes)\n",
+               blocks_compression_enabled() ? "ligada" : "desligada", FS_CLUSTER_SIZE);
+        return;
+    }
+
+    if (strcmp(argv[1], "on") == 0){
+        blocks_set_compression(1);
+        printf("Compressao ligada para as proximas gravacoes\n");
+    } else if (strcmp(argv[1], "off") == 0){
+        blocks_set_compression(0);
+        printf("Compressao desligada para as proximas gravacoes\n");
+    } else {
+        printf("Uso: compress [on|off]\n");
+    }
+}
+
+void cmd_inline(int argc, char** argv){
+    if (argc < 2){
+        printf("Dados inline: arquivos de ate %zu bytes (maximo %d)\n",
+               blocks_inline_threshold(), FCB_INLINE_MAX);
+        return;
+    }
+
+    char* end = NULL;
+    long value = strtol(argv[1], &end, 10);
+    if (*argv[1] == '\0' || *end != '\0' || value < 0){
+        printf("Uso: inline [bytes]  (0 desliga)\n");
+        return;
+    }
+
+    blocks_set_inline_threshold((size_t)value);
+    if (blocks_inline_threshold() == 0){
+        printf("Dados inline desligados\n");
+        return;
+    }
+    printf("Dados inline: arquivos de ate %zu bytes\n", blocks_inline_threshold());
+}
+
+// Critérios aceitos pelo find
+typedef struct {
+    int          has_name;
+    FsGlob       name;        // Padrão de nome (glob)
+    int          type;        // -1 = qualquer, NODE_FILE ou NODE_DIR
+    char         size_cmp;    // 0 = sem filtro, '+' maior, '-' menor, '=' igual
+    size_t       size;
+    int          has_perm;
+    unsigned int perm;
+    int          maxdepth;    // -1 = sem limite
+    int          quit;        // Para no primeiro resultado
+} FindCriteria;
+
+// Verifica se um nó satisfaz todos os critérios
+static int find_matches(const FsNode* node, const FindCriteria* crit){
+    if (crit->type >= 0 && (int)node->type != crit->type){
+        return 0;
+    }
+
+    if (crit->has_name && !fs_glob_match(&crit->name, node->name)){
+        return 0;
+    }
+
+    // Tamanho e permissões só existem para arquivos
+    if (crit->size_cmp || crit->has_perm){
+        if (!node->fcb){
+            return 0;
+        }
+        if (crit->size_cmp == '+' && !(node->fcb->size > crit->size)) return 0;
+        if (crit->size_cmp == '-' && !(node->fcb->size < crit->size)) return 0;
+        if (crit->size_cmp == '=' && node->fcb->size != crit->size)   return 0;
+        if (crit->has_perm && node->fcb->permissions != crit->perm)    return 0;
+    }
+    return 1;
+}
+
+// Busca nós a partir de um diretório, imprimindo cada resultado assim que encontrado
+void cmd_find(int argc, char** argv){
+    FindCriteria crit;
+    memset(&crit, 0, sizeof(crit));
+    crit.type     = -1;
+    crit.maxdepth = -1;
+    FsNode* start = fs_current_dir;
+    int i = 1;
+
+    // Diretório de partida opcional
+    if (argc > 1 && argv[1][0] != '-'){
+        const char* dir_name = argv[1];
+        if (strcmp(dir_name, "/") == 0){
+            start = fs_root;
+        } else if (strcmp(dir_name, "..") == 0){
+            if (fs_current_dir->parent){
+                start = fs_current_dir->parent;
+            }
+        } else if (strcmp(dir_name, ".") != 0){
+            start = fs_find_child(fs_current_dir, dir_name);
+            if (!start){
+                printf("find: Diretorio '%s' nao encontrado\n", dir_name);
+                return;
+            }
+        }
+        i = 2;
+    }
+
+    for (; i < argc; i++){
+        const char* opt = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(opt, "-quit") == 0){
+            crit.quit = 1;
+            continue;
+        }
+
+        if (!value){
+            printf("find: Opcao '%s' requer um valor\n", opt);
+            return;
+        }
+
+        if (strcmp(opt, "-name") == 0){
+            if (fs_glob_compile(&crit.name, value) != 0){
+                printf("find: Padrao invalido '%s'\n", value);
+                return;
+            }
+            crit.has_name = 1;
+        } else if (strcmp(opt, "-type") == 0){
+            if (strcmp(value, "f") == 0){
+                crit.type = NODE_FILE;
+            } else if (strcmp(value, "d") == 0){
+                crit.type = NODE_DIR;
+            } else {
+                printf("find: Tipo invalido '%s' (use f ou d)\n", value);
+                return;
+            }
+        } else if (strcmp(opt, "-size") == 0){
+            const char* digits = value;
+            crit.size_cmp = '=';
+            if (value[0] == '+' || value[0] == '-'){
+                crit.size_cmp = value[0];
+                digits++;
+            }
+            char* end = NULL;
+            unsigned long n = strtoul(digits, &end, 10);
+            if (digits[0] == '\0' || *end != '\0'){
+                printf("find: Tamanho invalido '%s'\n", value);
+                return;
+            }
+            crit.size = (size_t)n;
+        } else if (strcmp(opt, "-perm") == 0){
+            int ok = 0;
+            crit.perm = perms_parse_numeric(value, &ok);
+            if (!ok){
+                printf("find: Permissoes invalidas: '%s'\n", value);
+                return;
+            }
+            crit.has_perm = 1;
+        } else if (strcmp(opt, "-maxdepth") == 0){
+            char* end = NULL;
+            long depth = strtol(value, &end, 10);
+            if (value[0] == '\0' || *end != '\0' || depth < 0){
+                printf("find: Profundidade invalida '%s'\n", value);
+                return;
+            }
+            crit.maxdepth = (int)depth;
+        } else {
+            printf("find: Opcao desconhecida '%s'\n", opt);
+            printf("Uso: find [dir] [-name <nome>] [-type f|d] [-size [+|-]N] [-perm NNN] [-maxdepth N] [-quit]\n");
+            return;
+        }
+        i++; // Consome o valor da opção
+    }
+
+    char path[PATH_MAX_LEN];
+    FsWalk walk;
+    fs_walk_begin(&walk, start, FS_WALK_PREORDER);
+
+    FsNode* node;
+    while ((node = fs_walk_next(&walk)) != NULL){
+        // Não desce abaixo da profundidade máxima
+        if (crit.maxdepth >= 0 && fs_walk_depth(&walk) >= crit.maxdepth){
+            fs_walk_prune(&walk);
+        }
+
+        if (!find_matches(node, &crit)){
+            continue;
+        }
+
+        fs_get_path(node, path, sizeof(path));
+        printf("%s\n", path);
+
+        if (crit.quit){
+            break; // Para assim que o primeiro resultado é encontrado
+        }
+    }
+}
@@ -0,0 +1,288 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "fs.h"
+#include "commands.h"
+#include "blocks.h"
+#include "crc32c.h"
+#include "dedup.h"
+#include "scrub.h"
+#include "fsck.h"
+
+#define BENCH_DEFAULT_ITERATIONS 20000
+#define BENCH_CRC_BUFFER (64 * 1024)
+#define BENCH_ROUNDS 15
+
+
+static double integrity_now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void scrub_print(const ScrubStats* stats){
+    if (stats->running){
+        printf("scrub: em andamento, %ld de %ld blocos percorridos (%.0f%%) em %.3f s, %ld verificados, %ld com erro\n",
+               stats->scanned, stats->total,
+               stats->total > 0 ? 100.0 * (double)stats->scanned / (double)stats->total : 100.0,
+               stats->seconds, stats->checked, stats->errors);
+    } else {
+        printf("scrub: %s%ld blocos verificados com %d threads em %.3f s, %ld com erro\n",
+               stats->cancelled ? "cancelado apos " : "", stats->checked, stats->threads,
+               stats->seconds, stats->errors);
+    }
+    if (stats->sealed > 0){
+        printf("  CRCs calculados agora: %ld (blocos gravados desde a ultima descarga)\n", stats->sealed);
+    }
+    if (stats->errors > 0){
+        printf("  Blocos corrompidos:");
+        long shown = stats->errors < SCRUB_MAX_REPORTED ? stats->errors : SCRUB_MAX_REPORTED;
+        for (long i = 0; i < shown; i++){
+            printf(" %d", stats->bad_blocks[i]);
+        }
+        printf(stats->errors > shown ? " ...\n" : "\n");
+    }
+}
+
+// Verifica os checksums de todos os blocos alocados em segundo plano
+void cmd_scrub(int argc, char** argv){
+    ScrubStats stats;
+
+    if (argc == 2 && strcmp(argv[1], "status") == 0){
+        if (scrub_status(&stats) != 0){
+            printf("scrub: Nenhuma verificacao foi iniciada\n");
+            return;
+        }
+        scrub_print(&stats);
+        return;
+    }
+    if (argc == 2 && strcmp(argv[1], "wait") == 0){
+        if (scrub_wait(&stats) != 0){
+            printf("scrub: Nenhuma verificacao foi iniciada\n");
+            return;
+        }
+        scrub_print(&stats);
+        return;
+    }
+    if (argc == 2 && strcmp(argv[1], "cancel") == 0){
+        scrub_cancel();
+        if (scrub_wait(&stats) == 0) scrub_print(&stats);
+        return;
+    }
+
+    long rate = 0;
+    int threads = 0;
+    int wait = 0;
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc){
+            rate = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc){
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--wait") == 0){
+            wait = 1;
+        } else {
+            printf("Uso: scrub [--rate blocos_por_segundo] [--threads N] [--wait] | scrub status|wait|cancel\n");
+            return;
+        }
+    }
+
+    if (scrub_status(&stats) == 0 && stats.running){
+        printf("scrub: Ja existe uma verificacao em andamento (use 'scrub status')\n");
+        return;
+    }
+    if (scrub_start(threads, rate) != 0){
+        printf("scrub: Nao foi possivel iniciar a verificacao\n");
+        return;
+    }
+
+    if (wait){
+        scrub_wait(&stats);
+        scrub_print(&stats);
+        return;
+    }
+    scrub_status(&stats);
+    printf("scrub: verificando %ld blocos em segundo plano com %d threads (acompanhe com 'scrub status')\n",
+           stats.total, stats.threads);
+}
+
+// Mostra o resultado de um scrub em segundo plano que terminou desde o último prompt
+void cmd_scrub_notify(void){
+    ScrubStats stats;
+    if (scrub_poll(&stats)) scrub_print(&stats);
+}
+
+// Confere a árvore e o mapa de blocos, opcionalmente corrigindo
+void cmd_fsck(int argc, char** argv){
+    int repair = 0;
+    int threads = 0;
+
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "-r") == 0){
+            repair = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc){
+            threads = atoi(argv[++i]);
+        } else {
+            printf("Uso: fsck [-r] [--threads N]\n");
+            return;
+        }
+    }
+
+    FsckReport report;
+    long problems = fsck_run(fs_root, threads, repair, &report);
+    if (problems < 0){
+        printf("fsck: Nao foi possivel iniciar a verificacao\n");
+        return;
+    }
+
+    printf("fsck: %ld nos (%ld diretorios, %ld arquivos) e %ld blocos com %d threads em %.3f s\n",
+           report.nodes, report.dirs, report.files, report.blocks, report.threads, report.seconds);
+    if (problems == 0){
+        printf("  Nenhum problema encontrado\n");
+        return;
+    }
+
+    if (report.leaked_blocks)     printf("  Blocos usados sem dono: %ld\n", report.leaked_blocks);
+    if (report.unmarked_blocks)   printf("  Blocos com dono marcados como livres: %ld\n", report.unmarked_blocks);
+    if (report.refcount_mismatch) printf("  Contagens de referencia erradas: %ld\n", report.refcount_mismatch);
+    if (report.bad_block_refs)    printf("  Arquivos com indices de bloco invalidos: %ld\n", report.bad_block_refs);
+    if (report.short_files)       printf("  Arquivos sem blocos suficientes: %ld\n", report.short_files);
+    if (report.duplicate_inodes)  printf("  Inodes duplicados: %ld\n", report.duplicate_inodes);
+    if (report.bad_inodes)        printf("  Inodes fora da faixa: %ld\n", report.bad_inodes);
+    if (report.bad_links)         printf("  Ligacoes pai/filho inconsistentes: %ld\n", report.bad_links);
+
+    if (repair){
+        printf("  %ld problemas, %ld correcoes aplicadas\n", problems, report.repaired);
+    } else {
+        printf("  %ld problemas (use 'fsck -r' para corrigir)\n", problems);
+    }
+}
+
+typedef struct {
+    double write_ns;    // blocks_alloc_for_file
+    double read_ns;     // blocks_read_file (cópia para buffer)
+    double writev_ns;   // blocks_writev_file para /dev/null (caminho do cat/export)
+} BenchResult;
+
+static double bench_elapsed_ns(double start, long iterations){
+    return (integrity_now() - start) * 1e9 / (double)iterations;
+}
+
+// Mede gravação e leitura de um arquivo de 32 blocos
+static void bench_io(FCB* fcb, const char* payload, size_t len, long iterations,
+                     int devnull, BenchResult* result){
+    char buffer[FCB_MAX_BLOCKS * FS_BLOCK_SIZE];
+
+    double start = integrity_now();
+    for (long i = 0; i < iterations; i++){
+        blocks_alloc_for_file(fcb, payload, len);
+    }
+    result->write_ns = bench_elapsed_ns(start, iterations);
+
+    fcb->size = len;
+    start = integrity_now();
+    for (long i = 0; i < iterations; i++){
+        blocks_read_file(fcb, 0, buffer, len);
+    }
+    result->read_ns = bench_elapsed_ns(start, iterations);
+
+    start = integrity_now();
+    for (long i = 0; i < iterations; i++){
+        blocks_writev_file(fcb, devnull, NULL, 0);
+    }
+    result->writev_ns = bench_elapsed_ns(start, iterations);
+}
+
+// Guarda o menor tempo de cada medida (menos ruído de escalonamento)
+static void bench_keep_best(BenchResult* best, const BenchResult* run, int first){
+    if (first || run->write_ns  < best->write_ns)  best->write_ns  = run->write_ns;
+    if (first || run->read_ns   < best->read_ns)   best->read_ns   = run->read_ns;
+    if (first || run->writev_ns < best->writev_ns) best->writev_ns = run->writev_ns;
+}
+
+static void bench_print(const char* label, double off, double on){
+    printf("  %-9s %8.1f ns sem CRC, %8.1f ns com CRC (%+.1f%%)\n",
+           label, off, on, off > 0.0 ? (on / off - 1.0) * 100.0 : 0.0);
+}
+
+static double bench_crc_mb_s(uint32_t (*fn)(uint32_t, const void*, size_t), const char* data){
+    int rounds = 2000;
+    volatile uint32_t sink = 0;
+
+    double start = integrity_now();
+    for (int i = 0; i < rounds; i++){
+        sink ^= fn(0, data, BENCH_CRC_BUFFER);
+    }
+    double seconds = integrity_now() - start;
+    (void)sink;
+    return seconds > 0.0 ? ((double)BENCH_CRC_BUFFER * rounds / (1024.0 * 1024.0)) / seconds : 0.0;
+}
+
+// Compara o caminho de gravação/leitura com e sem checksums
+void cmd_bench(int argc, char** argv){
+    long iterations = BENCH_DEFAULT_ITERATIONS;
+    if (argc >= 2){
+        iterations = atol(argv[1]);
+        if (iterations <= 0){
+            printf("Uso: bench [iteracoes]\n");
+            return;
+        }
+    }
+
+    // Arquivo fora da árvore, sempre em blocos crus
+    FCB fcb;
+    memset(&fcb, 0, sizeof(fcb));
+    for (int i = 0; i < FCB_MAX_BLOCKS; i++) fcb.direct_blocks[i] = -1;
+
+    size_t len = FCB_MAX_BLOCKS * FS_BLOCK_SIZE;
+    char payload[FCB_MAX_BLOCKS * FS_BLOCK_SIZE];
+    for (size_t i = 0; i < len; i++) payload[i] = (char)('a' + (i * 7) % 26);
+
+    int    had_dedup    = dedup_enabled();
+    int    had_compress = blocks_compression_enabled();
+    size_t had_inline   = blocks_inline_threshold();
+    if (had_dedup) dedup_disable();
+    blocks_set_compression(0);
+    blocks_set_inline_threshold(0);
+
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull < 0){
+        printf("bench: Nao foi possivel abrir /dev/null\n");
+        return;
+    }
+
+    // Rodadas alternadas com e sem CRC; vale o melhor tempo de cada modo
+    BenchResult off = {0}, on = {0}, run;
+    for (int round = 0; round < BENCH_ROUNDS; round++){
+        blocks_set_checksums(0);
+        bench_io(&fcb, payload, len, iterations, devnull, &run);
+        bench_keep_best(&off, &run, round == 0);
+
+        blocks_set_checksums(1);
+        bench_io(&fcb, payload, len, iterations, devnull, &run);
+        bench_keep_best(&on, &run, round == 0);
+    }
+    close(devnull);
+
+    blocks_free_for_file(&fcb);
+    blocks_set_inline_threshold(had_inline);
+    blocks_set_compression(had_compress);
+    if (had_dedup) dedup_enable();
+
+    printf("bench: %ld iteracoes x %d rodadas, arquivo de %zu bytes (%d blocos)\n",
+           iterations, BENCH_ROUNDS, len, FCB_MAX_BLOCKS);
+    bench_print("gravacao:", off.write_ns, on.write_ns);
+    bench_print("leitura:", off.read_ns, on.read_ns);
+    bench_print("writev:", off.writev_ns, on.writev_ns);
+
+    char* data = (char*)malloc(BENCH_CRC_BUFFER);
+    if (!data) return;
+    for (int i = 0; i < BENCH_CRC_BUFFER; i++) data[i] = (char)(i * 31);
+    printf("  crc32c:   %.0f MB/s (%s), tabela %.0f MB/s\n",
+           bench_crc_mb_s(crc32c, data), crc32c_hw_enabled() ? "instrucao SSE4.2" : "tabela",
+           bench_crc_mb_s(crc32c_sw, data));
+    free(data);
+}
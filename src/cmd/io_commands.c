@@ -0,0 +1,313 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "fs.h"
+#include "fs_helpers.h"
+#include "fcb_helpers.h"
+#include "commands.h"
+#include "permissions.h"
+#include "blocks.h"
+#include "snapshot.h"
+#include "delalloc.h"
+#include "fs_usage.h"
+#include "fs_time.h"
+#include "mem.h"
+#include "blkio.h"
+#include "checkpoint.h"
+
+
+// Tempo monotônico em segundos, usado para medir a vazão
+static double io_now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void io_report(const char* cmd, size_t bytes, double seconds){
+    double mb_s = 0.0;
+    if (seconds > 0.0){
+        mb_s = ((double)bytes / (1024.0 * 1024.0)) / seconds;
+    }
+    printf("%s: %zu bytes em %.6f s (%.2f MB/s)\n", cmd, bytes, seconds, mb_s);
+}
+
+// Encontra ou cria o arquivo de destino no diretório atual, validando permissões
+static FsNode* io_open_target(const char* cmd, const char* name){
+    if (strlen(name) == 0 || strcmp(name, ".") == 0 || strcmp(name, "..") == 0){
+        printf("%s: Nome de arquivo invalido '%s'\n", cmd, name);
+        return NULL;
+    }
+
+    if (strchr(name, '/')){
+        printf("%s: Nome de arquivo nao pode conter '/': '%s'\n", cmd, name);
+        return NULL;
+    }
+
+    FsNode* node = fs_find_child(fs_current_dir, name);
+    if (!node){
+        const FsNode* over = NULL;
+        if (fs_usage_check(fs_current_dir, fs_current_user_class, 0, 1, &over) != 0){
+            cmd_report_quota(cmd, over);
+            return NULL;
+        }
+        node = fs_create_node(name, NODE_FILE, fs_current_dir);
+        node->fcb = create_fcb(name, FILETYPE_BINARY);
+        fs_add_child(fs_current_dir, node);
+        return node;
+    }
+
+    if (node->type == NODE_DIR){
+        printf("%s: '%s' nao e um arquivo\n", cmd, name);
+        return NULL;
+    }
+
+    if (node->fcb && !perms_can_write(node->fcb)){
+        printf("%s: Permissão negada para escrever no arquivo '%s'\n", cmd, name);
+        return NULL;
+    }
+
+    snap_touch(node);
+    if (!node->fcb){
+        node->fcb = create_fcb(name, FILETYPE_BINARY);
+    }
+    return node;
+}
+
+// Lê o arquivo inteiro do host e grava comprimido (o tamanho já foi validado)
+static int io_import_compressed(FCB* fcb, int fd, size_t size){
+    char buffer[FCB_MAX_CLUSTERS * FS_CLUSTER_SIZE];
+    size_t got = 0;
+
+    while (got < size){
+        ssize_t n = read(fd, buffer + got, size - got);
+        if (n < 0){
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break; // A origem encolheu durante a leitura
+        got += (size_t)n;
+    }
+
+    if (blocks_alloc_for_file(fcb, buffer, got) != 0){
+        return -1;
+    }
+    fcb->size = got;
+    return 0;
+}
+
+// Importa um arquivo do host para o disco simulado
+void cmd_import(int argc, char** argv){
+    if (argc < 3){
+        printf("Uso: import <arquivo_host> <nome>\n");
+        return;
+    }
+
+    const char* host_path = argv[1];
+    const char* name      = argv[2];
+
+    int fd = open(host_path, O_RDONLY);
+    if (fd < 0){
+        printf("import: Nao foi possivel abrir '%s': %s\n", host_path, strerror(errno));
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)){
+        printf("import: '%s' nao e um arquivo regular\n", host_path);
+        close(fd);
+        return;
+    }
+
+    size_t size = (size_t)st.st_size;
+    if (size > blocks_max_file_size()){
+        printf("import: '%s' tem %zu bytes, maximo por arquivo e %zu bytes\n",
+               host_path, size, blocks_max_file_size());
+        close(fd);
+        return;
+    }
+
+    FsNode* node = io_open_target("import", name);
+    if (!node){
+        close(fd);
+        return;
+    }
+    FCB* fcb = node->fcb;
+
+    const FsNode* over = NULL;
+    long blocks = fs_usage_estimate_blocks(size) - fs_usage_file_blocks(fcb);
+    if (fs_usage_check(fs_current_dir, fcb->owner, blocks, 0, &over) != 0){
+        cmd_report_quota("import", over);
+        close(fd);
+        return;
+    }
+
+    double start = io_now();
+
+    // O conteúdo vive apenas nos blocos: descarta a cópia em memória
+    if (fcb->content){
+        mem_free(MEM_CONTENT, fcb->content);
+        fcb->content = NULL;
+    }
+    fcb->size = 0;
+
+    // Com compressão os dados passam por um buffer antes de irem para os blocos (arquivos
+    // maiores que FCB_MAX_CLUSTERS clusters ficam crus)
+    if (blocks_compression_enabled() && size <= (size_t)FCB_MAX_CLUSTERS * FS_CLUSTER_SIZE){
+        if (io_import_compressed(fcb, fd, size) != 0){
+            printf("import: Falha ao importar '%s' (erro de leitura, disco cheio ou dados pouco compressiveis)\n", name);
+            close(fd);
+            fs_usage_refresh(node);
+            return;
+        }
+        close(fd);
+        fs_usage_refresh(node);
+        fs_time_modify(fcb);
+        io_report("import", fcb->size, io_now() - start);
+        return;
+    }
+
+    if (blocks_reserve_for_file(fcb, size) != 0){
+        printf("import: Falha ao alocar blocos para '%s' (disco cheio)\n", name);
+        close(fd);
+        fs_usage_refresh(node);
+        return;
+    }
+    fcb->size = size;
+
+    ssize_t got = blocks_readv_file(fcb, fd);
+    close(fd);
+    if (got < 0){
+        printf("import: Erro ao ler '%s': %s\n", host_path, strerror(errno));
+        blocks_free_for_file(fcb);
+        fcb->size = 0;
+        fs_usage_refresh(node);
+        return;
+    }
+    fcb->size = (size_t)got;
+    blocks_punch_holes(fcb); // A leitura foi direto para blocos novos
+    blocks_dedup_file(fcb);
+
+    fs_usage_refresh(node); // Totais dos diretórios acima
+    fs_time_modify(fcb);
+    io_report("import", fcb->size, io_now() - start);
+}
+
+// Exporta um arquivo do disco simulado para o host
+void cmd_export(int argc, char** argv){
+    if (argc < 3){
+        printf("Uso: export <nome> <arquivo_host>\n");
+        return;
+    }
+
+    const char* name      = argv[1];
+    const char* host_path = argv[2];
+
+    FsNode* node = fs_find_child(fs_current_dir, name);
+    if (!node){
+        printf("export: Arquivo '%s' nao encontrado\n", name);
+        return;
+    }
+
+    if (node->type == NODE_DIR || !node->fcb){
+        printf("export: '%s' nao e um arquivo\n", name);
+        return;
+    }
+
+    if (!perms_can_read(node->fcb)){
+        printf("export: Permissão negada para ler o arquivo '%s'\n", name);
+        return;
+    }
+
+    int fd = open(host_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0){
+        printf("export: Nao foi possivel criar '%s': %s\n", host_path, strerror(errno));
+        return;
+    }
+
+    double start = io_now();
+    FCB* fcb = node->fcb;
+
+    // Escreve as faixas de blocos direto no arquivo do host
+    ssize_t written = 0;
+    if (fcb->size > 0){
+        written = blocks_writev_file(fcb, fd, NULL, 0);
+        if (written < 0 && errno == EIO){
+            printf("export: Erro de checksum nos blocos de '%s'\n", name);
+        }
+        if (written < 0 && fcb->content){
+            written = write(fd, fcb->content, fcb->size); // Blocos incompletos
+        }
+    }
+    close(fd);
+
+    if (written < 0){
+        printf("export: Erro ao escrever '%s'\n", host_path);
+        return;
+    }
+
+    fs_time_access(node);
+    io_report("export", (size_t)written, io_now() - start);
+}
+
+// Esquece os blocos limpos em memória; as próximas leituras vêm da imagem em lotes
+void cmd_dropcache(){
+    int dropped = blocks_drop_cache();
+    if (dropped < 0){
+        printf("dropcache: Nenhuma imagem anexada (use --image)\n");
+        return;
+    }
+
+    int dirty = 0;
+    blocks_writeback_stats(&dirty, NULL, NULL);
+    printf("dropcache: %d blocos descartados da memoria", dropped);
+    if (dirty > 0){
+        printf(" (%d sujos mantidos; use 'sync' antes)", dirty);
+    }
+    printf("\n");
+}
+
+// Aloca os arquivos pendentes, grava os blocos sujos na imagem e espera chegarem à mídia
+void cmd_sync(){
+    int flushed = delalloc_flush();
+    if (!blkio_is_open()){
+        printf("sync: %d arquivos com alocacao adiada receberam blocos (nenhuma imagem anexada)\n", flushed);
+        return;
+    }
+
+    int dirty = 0;
+    blocks_writeback_stats(&dirty, NULL, NULL);
+
+    double start = io_now();
+    if (blocks_sync() != 0){
+        printf("sync: %s\n", strerror(errno));
+        return;
+    }
+    printf("sync: %d arquivos alocados, %d blocos gravados em %.6f s\n", flushed, dirty, io_now() - start);
+}
+
+// Grava o namespace inteiro em um arquivo do host (restaurado com --restore)
+void cmd_checkpoint(int argc, char** argv){
+    if (argc < 2){
+        printf("Uso: checkpoint <arquivo_host>\n");
+        return;
+    }
+
+    CheckpointStats stats;
+    if (checkpoint_save(argv[1], &stats) != 0){
+        if (errno == ENOSPC){
+            printf("checkpoint: Sem espaco para alocar os arquivos com alocacao adiada\n");
+        } else {
+            printf("checkpoint: Erro ao gravar '%s': %s\n", argv[1], strerror(errno));
+        }
+        return;
+    }
+    printf("checkpoint: %ld diretorios, %ld arquivos, %ld blocos, %zu bytes em %.6f s\n",
+           stats.dirs, stats.files, stats.blocks, stats.bytes, stats.seconds);
+}
@@ -1,67 +1,153 @@
-#include <stdio.h>
-#include <string.h>
-#include "cmd.h"
-#include "commands.h"  
-
-void cmd_help(void) {
-    printf("Comandos disponiveis:\n");
-    printf("  help                     - Mostra comandos disponíveis\n");
-    printf("  pwd                      - Mostra o caminho do diretorio atual\n");
-    printf("  mkdir <dir>              - Cria um novo diretorio no diretório atual\n");
-    printf("  ls [name]                - Lista o conteudo do diretorio atual\n");
-    printf("  cd [path]                - Altera o diretório atual\n");
-    printf("  touch <file>             - Cria um novo arquivo no diretório atual\n");
-    printf("  write <file> <text>      - Criar/Sobrescrever arquivos com o texto fornecido\n");
-    printf("  cat <file>               - Imprime o conteúdo do arquivo\n");
-    printf("  cp <src> <dst>           - Copia um arquivo\n");
-    printf("  mv <old> <new>           - Renomeia/move um arquivo dentro do diretório atual\n");
-    printf("  rm <file>                - Remove um arquivo\n");
-    printf("  chmod <perms> <file>     - Altera as permissões de um arquivo\n");
-    printf("  user <owner|group|other> - Altera o usuario atual da simulacao\n");
-    printf("  whoami                   - Mostra o usuário atual\n");
-    printf("  stat <file>              - Mostra metadados e blocos do arquivo\n");
-    printf("  df                       - Mostra estatisticas do disco simulado\n");
-    printf("  exit                     - Sai do simulador\n");
-}
-
-// Essa função será chamada pelo shell
-void cmd_handle(int argc, char** argv) {
-    const char* cmd = argv[0];
-
-    if (strcmp(cmd, "help") == 0) {
-        cmd_help();
-    } else if (strcmp(cmd, "pwd") == 0) {
-        cmd_pwd();
-    } else if (strcmp(cmd, "mkdir") == 0) {
-        cmd_mkdir(argc, argv);
-    } else if (strcmp(cmd, "ls") == 0) {
-        cmd_ls(argc, argv);
-    } else if (strcmp(cmd, "cd") == 0) {  
-        cmd_cd(argc, argv); 
-    } else if (strcmp(cmd, "touch") == 0) {
-        cmd_touch(argc, argv);
-    } else if (strcmp(cmd, "write") == 0) {
-        cmd_write(argc, argv);
-    } else if (strcmp(cmd, "cat") == 0) {
-        cmd_cat(argc, argv);
-    } else if (strcmp(cmd, "cp") == 0) {
-        cmd_cp(argc, argv);
-    } else if (strcmp(cmd, "mv") == 0) {
-        cmd_mv(argc, argv);
-    } else if (strcmp(cmd, "rm") == 0) {
-        cmd_rm(argc, argv);
-    } else if (strcmp(cmd, "chmod") == 0) {
-        cmd_chmod(argc, argv);
-    } else if (strcmp(cmd, "user") == 0) {
-        cmd_user(argc, argv);
-    } else if (strcmp(cmd, "whoami") == 0) {
-        cmd_whoami();
-    } else if (strcmp(cmd, "stat") == 0) {
-        cmd_stat(argc, argv);
-    } else if (strcmp(cmd, "df") == 0) {
-        cmd_df();
-    } else {
-        printf("Comando desconhecido: %s\n", cmd);
-        printf("Digite 'help' para ver a lista de comandos disponiveis.\n");
-    }
-}
+#include <stdio.h>
+#include <string.h>
+#include "cmd.h"
+#include "commands.h"  
+#include "fs_time.h"
+#include "delalloc.h"
+#include "trace.h"
+#include "blocks.h"
+
+void cmd_help(void) {
+    printf("Comandos disponiveis:\n");
+    printf("  help                     - Mostra comandos disponíveis\n");
+    printf("  pwd                      - Mostra o caminho do diretorio atual\n");
+    printf("  mkdir <dir>              - Cria um novo diretorio no diretório atual\n");
+    printf("  ls [-l] [name|padrao]... - Lista o conteudo do diretorio atual\n");
+    printf("     [-S|-t] [--limit N] [--offset N] - Ordena por tamanho/modificacao e pagina\n");
+    printf("  cd [path]                - Altera o diretório atual\n");
+    printf("  touch <file>             - Cria um novo arquivo no diretório atual\n");
+    printf("  write <file> <text>      - Criar/Sobrescrever arquivos com o texto fornecido\n");
+    printf("  write <file> <<FIM | -   - Grava as linhas seguintes (ate FIM) ou a entrada padrao\n");
+    printf("  truncate <file> <size>   - Corta o arquivo ou o estende com um buraco (sem blocos)\n");
+    printf("  cat <file|padrao>...     - Imprime o conteúdo dos arquivos\n");
+    printf("  cp <src> <dst>           - Copia um arquivo\n");
+    printf("  mv <old> <new>           - Renomeia/move um arquivo dentro do diretório atual\n");
+    printf("  rm <file|padrao>...      - Remove arquivos (aceita *, ? e [a-z])\n");
+    printf("  chmod <perms> <file>...  - Altera as permissões de arquivos\n");
+    printf("  user <owner|group|other> - Altera o usuario atual da simulacao\n");
+    printf("  whoami                   - Mostra o usuário atual\n");
+    printf("  stat <file|padrao>...    - Mostra metadados e blocos dos arquivos\n");
+    printf("  df                       - Mostra estatisticas do disco simulado\n");
+    printf("  du [dir|padrao]...       - Blocos, bytes e inodes de diretorios (sem percorrer a arvore)\n");
+    printf("  quota [-u user|dir] <b> [i] - Mostra/define cotas de blocos e inodes\n");
+    printf("  meminfo                  - Mostra a memoria usada por categoria\n");
+    printf("  trace start|stop|dump <f> - Rastreia eventos e exporta no formato do Chrome\n");
+    printf("  dedup [on|off]           - Liga/desliga a deduplicacao de blocos\n");
+    printf("  compress [on|off]        - Liga/desliga a compressao transparente (LZ)\n");
+    printf("  inline [bytes]           - Limite de tamanho para dados inline no FCB\n");
+    printf("  scrub [--rate N] [--wait] - Verifica o CRC dos blocos alocados em segundo plano\n");
+    printf("  scrub status|wait|cancel - Progresso, espera ou cancela o scrub em andamento\n");
+    printf("  bench [iteracoes]        - Mede o custo dos checksums na gravacao e leitura\n");
+    printf("  fsck [-r] [--threads N]  - Confere a arvore e o mapa de blocos (-r corrige)\n");
+    printf("  find [dir] [opcoes]      - Busca arquivos/diretorios (-name, -type, -size, -perm, -maxdepth, -quit)\n");
+    printf("  import <host> <file>     - Importa um arquivo do host para o disco simulado\n");
+    printf("  export <file> <host>     - Exporta um arquivo do disco simulado para o host\n");
+    printf("  dropcache                - Descarta os blocos limpos em memoria (relidos da imagem)\n");
+    printf("  sync                     - Aloca os arquivos pendentes e grava os blocos sujos na imagem\n");
+    printf("  checkpoint <host>        - Grava o namespace inteiro no host (abra com --restore)\n");
+    printf("  snapshot [nome]          - Cria um snapshot (sem nome: lista os snapshots)\n");
+    printf("  rollback <nome>          - Volta o sistema de arquivos ao estado do snapshot\n");
+    printf("  snapshot-rm <nome>       - Remove um snapshot\n");
+    printf("  exit                     - Sai do simulador\n");
+}
+
+// Essa função será chamada pelo shell
+void cmd_handle(int argc, char** argv) {
+    const char* cmd = argv[0];
+
+    // O scrub em segundo plano confere os blocos entre um comando e outro. O próprio
+    // "scrub" fica de fora: "scrub wait" espera threads que precisam da trava
+    int locked = strcmp(cmd, "scrub") != 0;
+    if (locked) blocks_lock();
+
+    fs_clock_tick(); // Um único relógio para todos os timestamps do comando
+    delalloc_tick(); // Descarrega a alocação adiada que expirou
+
+    // O fim é registrado sempre que o início foi, mesmo se o próprio comando for "trace stop"
+    int traced = atomic_load_explicit(&trace_on, memory_order_relaxed);
+    if (traced) trace_record(TRACE_CMD, 'B', cmd, argc, 0);
+
+    if (strcmp(cmd, "help") == 0) {
+        cmd_help();
+    } else if (strcmp(cmd, "pwd") == 0) {
+        cmd_pwd();
+    } else if (strcmp(cmd, "mkdir") == 0) {
+        cmd_mkdir(argc, argv);
+    } else if (strcmp(cmd, "ls") == 0) {
+        cmd_ls(argc, argv);
+    } else if (strcmp(cmd, "cd") == 0) {  
+        cmd_cd(argc, argv); 
+    } else if (strcmp(cmd, "touch") == 0) {
+        cmd_touch(argc, argv);
+    } else if (strcmp(cmd, "write") == 0) {
+        cmd_write(argc, argv);
+    } else if (strcmp(cmd, "truncate") == 0) {
+        cmd_truncate(argc, argv);
+    } else if (strcmp(cmd, "cat") == 0) {
+        cmd_cat(argc, argv);
+    } else if (strcmp(cmd, "cp") == 0) {
+        cmd_cp(argc, argv);
+    } else if (strcmp(cmd, "mv") == 0) {
+        cmd_mv(argc, argv);
+    } else if (strcmp(cmd, "rm") == 0) {
+        cmd_rm(argc, argv);
+    } else if (strcmp(cmd, "chmod") == 0) {
+        cmd_chmod(argc, argv);
+    } else if (strcmp(cmd, "user") == 0) {
+        cmd_user(argc, argv);
+    } else if (strcmp(cmd, "whoami") == 0) {
+        cmd_whoami();
+    } else if (strcmp(cmd, "stat") == 0) {
+        cmd_stat(argc, argv);
+    } else if (strcmp(cmd, "df") == 0) {
+        cmd_df();
+    } else if (strcmp(cmd, "du") == 0) {
+        cmd_du(argc, argv);
+    } else if (strcmp(cmd, "quota") == 0) {
+        cmd_quota(argc, argv);
+    } else if (strcmp(cmd, "meminfo") == 0) {
+        cmd_meminfo();
+    } else if (strcmp(cmd, "trace") == 0) {
+        cmd_trace(argc, argv);
+    } else if (strcmp(cmd, "dedup") == 0) {
+        cmd_dedup(argc, argv);
+    } else if (strcmp(cmd, "compress") == 0) {
+        cmd_compress(argc, argv);
+    } else if (strcmp(cmd, "inline") == 0) {
+        cmd_inline(argc, argv);
+    } else if (strcmp(cmd, "scrub") == 0) {
+        cmd_scrub(argc, argv);
+    } else if (strcmp(cmd, "bench") == 0) {
+        cmd_bench(argc, argv);
+    } else if (strcmp(cmd, "fsck") == 0) {
+        cmd_fsck(argc, argv);
+    } else if (strcmp(cmd, "find") == 0) {
+        cmd_find(argc, argv);
+    } else if (strcmp(cmd, "import") == 0) {
+        cmd_import(argc, argv);
+    } else if (strcmp(cmd, "export") == 0) {
+        cmd_export(argc, argv);
+    } else if (strcmp(cmd, "dropcache") == 0) {
+        cmd_dropcache();
+    } else if (strcmp(cmd, "sync") == 0) {
+        cmd_sync();
+    } else if (strcmp(cmd, "checkpoint") == 0) {
+        cmd_checkpoint(argc, argv);
+    } else if (strcmp(cmd, "snapshot") == 0) {
+        cmd_snapshot(argc, argv);
+    } else if (strcmp(cmd, "rollback") == 0) {
+        cmd_rollback(argc, argv);
+    } else if (strcmp(cmd, "snapshot-rm") == 0) {
+        cmd_snapshot_rm(argc, argv);
+    } else {
+        printf("Comando desconhecido: %s\n", cmd);
+        printf("Digite 'help' para ver a lista de comandos disponiveis.\n");
+    }
+
+    if (traced) trace_record(TRACE_CMD, 'E', cmd, 0, 0);
+    if (locked) blocks_unlock();
+}
+
+void cmd_report_background(void) {
+    cmd_scrub_notify();
+}
@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "fs.h"
+#include "commands.h"
+#include "snapshot.h"
+
+
+// Cria um snapshot (ou lista os existentes, sem argumentos)
+void cmd_snapshot(int argc, char** argv){
+    if (argc < 2){
+        snap_list();
+        return;
+    }
+
+    const char* name = argv[1];
+    int result = snap_create(name);
+
+    if (result == -2){
+        printf("snapshot: Snapshot '%s' ja existe\n", name);
+    } else if (result != 0){
+        printf("snapshot: Nome de snapshot invalido '%s'\n", name);
+    } else {
+        printf("Snapshot '%s' criado\n", name);
+    }
+}
+
+// Volta o namespace ao estado de um snapshot (os mais novos são descartados)
+void cmd_rollback(int argc, char** argv){
+    if (argc < 2){
+        printf("Uso: rollback <nome>\n");
+        return;
+    }
+
+    if (snap_rollback(argv[1]) != 0){
+        printf("rollback: Snapshot '%s' nao encontrado\n", argv[1]);
+        return;
+    }
+    printf("Sistema de arquivos restaurado para '%s'\n", argv[1]);
+}
+
+// Remove um snapshot sem alterar o estado atual
+void cmd_snapshot_rm(int argc, char** argv){
+    if (argc < 2){
+        printf("Uso: snapshot-rm <nome>\n");
+        return;
+    }
+
+    if (snap_remove(argv[1]) != 0){
+        printf("snapshot-rm: Snapshot '%s' nao encontrado\n", argv[1]);
+    }
+}
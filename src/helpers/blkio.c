@@ -0,0 +1,400 @@
+#define _GNU_SOURCE // syscall(): o io_uring é usado direto, sem a liburing
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "fs.h"
+#include "blocks.h"
+#include "blkio.h"
+#include "thread_pool.h"
+
+
+// Uma faixa de blocos consecutivos
+typedef struct {
+    struct iovec iov;
+    off_t   offset;
+    int     write;
+    int     blocks;
+    ssize_t result;     // Bytes transferidos ou -errno
+} BlkioRequest;
+
+// Anéis do io_uring mapeados na memória do processo
+typedef struct {
+    int fd;
+    unsigned entries;
+
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    struct io_uring_sqe* sqes;
+
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+
+    void*  sq_ptr;
+    size_t sq_size;
+    void*  cq_ptr;      // Igual a sq_ptr com IORING_FEAT_SINGLE_MMAP
+    size_t cq_size;
+    size_t sqes_size;
+} BlkioRing;
+
+static int   blkio_fd = -1;
+static char* blkio_image_path = NULL;
+static int   blkio_depth = BLKIO_DEFAULT_QUEUE_DEPTH;
+static int   blkio_uring_on = 0;
+static BlkioRing   blkio_ring;
+static ThreadPool* blkio_pool = NULL;
+
+// Um lote por vez: o anel não é compartilhável e o pool espera todas as tarefas
+static pthread_mutex_t blkio_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static atomic_long blkio_batches, blkio_requests, blkio_blocks, blkio_syscalls, blkio_errors;
+
+
+// ---------------------------------------------------------------------------
+// io_uring
+
+static int blkio_uring_setup(unsigned entries){
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) return -1; // Kernel sem io_uring ou bloqueado (seccomp)
+
+    BlkioRing* r = &blkio_ring;
+    memset(r, 0, sizeof(*r));
+    r->fd = fd;
+    r->entries = params.sq_entries;
+
+    r->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    r->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    int single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single){
+        if (r->cq_size > r->sq_size) r->sq_size = r->cq_size;
+        r->cq_size = r->sq_size;
+    }
+
+    r->sq_ptr = mmap(NULL, r->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_SQ_RING);
+    if (r->sq_ptr == MAP_FAILED){
+        close(fd);
+        return -1;
+    }
+    r->cq_ptr = r->sq_ptr;
+    if (!single){
+        r->cq_ptr = mmap(NULL, r->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_CQ_RING);
+        if (r->cq_ptr == MAP_FAILED){
+            munmap(r->sq_ptr, r->sq_size);
+            close(fd);
+            return -1;
+        }
+    }
+
+    r->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = (struct io_uring_sqe*)mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE,
+                                         MAP_SHARED, fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED){
+        if (!single) munmap(r->cq_ptr, r->cq_size);
+        munmap(r->sq_ptr, r->sq_size);
+        close(fd);
+        return -1;
+    }
+
+    char* sq = (char*)r->sq_ptr;
+    r->sq_head  = (unsigned*)(sq + params.sq_off.head);
+    r->sq_tail  = (unsigned*)(sq + params.sq_off.tail);
+    r->sq_mask  = (unsigned*)(sq + params.sq_off.ring_mask);
+    r->sq_array = (unsigned*)(sq + params.sq_off.array);
+
+    char* cq = (char*)r->cq_ptr;
+    r->cq_head = (unsigned*)(cq + params.cq_off.head);
+    r->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    r->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    r->cqes    = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return 0;
+}
+
+static void blkio_uring_teardown(void){
+    BlkioRing* r = &blkio_ring;
+    munmap(r->sqes, r->sqes_size);
+    if (r->cq_ptr != r->sq_ptr) munmap(r->cq_ptr, r->cq_size);
+    munmap(r->sq_ptr, r->sq_size);
+    close(r->fd);
+    memset(r, 0, sizeof(*r));
+}
+
+// Submete count requisições (count <= entradas do anel) e espera todas
+static int blkio_uring_submit(BlkioRequest* reqs, int count){
+    BlkioRing* r = &blkio_ring;
+
+    unsigned tail = *r->sq_tail;
+    unsigned mask = *r->sq_mask;
+    for (int i = 0; i < count; i++){
+        unsigned slot = tail & mask;
+        struct io_uring_sqe* sqe = &r->sqes[slot];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode    = reqs[i].write ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe->fd        = blkio_fd;
+        sqe->addr      = (unsigned long long)(uintptr_t)&reqs[i].iov;
+        sqe->len       = 1;
+        sqe->off       = (unsigned long long)reqs[i].offset;
+        sqe->user_data = (unsigned long long)i;
+        r->sq_array[slot] = slot;
+        tail++;
+    }
+    __atomic_store_n(r->sq_tail, tail, __ATOMIC_RELEASE); // Publica as entradas para o kernel
+
+    int submitted = 0, completed = 0;
+    while (completed < count){
+        int to_submit = count - submitted;
+        int ret = (int)syscall(__NR_io_uring_enter, r->fd, (unsigned)to_submit,
+                               (unsigned)(count - completed), IORING_ENTER_GETEVENTS, NULL, 0);
+        atomic_fetch_add_explicit(&blkio_syscalls, 1, memory_order_relaxed);
+        if (ret < 0){
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return -1;
+        }
+        submitted += ret;
+
+        unsigned head = *r->cq_head;
+        unsigned cq_tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+        while (head != cq_tail){
+            struct io_uring_cqe* cqe = &r->cqes[head & *r->cq_mask];
+            if (cqe->user_data < (unsigned long long)count){
+                reqs[cqe->user_data].result = cqe->res;
+                completed++;
+            }
+            head++;
+        }
+        __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// pread/pwrite
+
+// Transfere a requisição inteira, continuando depois de transferências parciais
+static ssize_t blkio_sync_transfer(BlkioRequest* req, size_t done){
+    char*  base = (char*)req->iov.iov_base;
+    size_t len  = req->iov.iov_len;
+
+    while (done < len){
+        ssize_t n = req->write
+            ? pwrite(blkio_fd, base + done, len - done, req->offset + (off_t)done)
+            : pread(blkio_fd, base + done, len - done, req->offset + (off_t)done);
+        atomic_fetch_add_explicit(&blkio_syscalls, 1, memory_order_relaxed);
+        if (n < 0){
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        if (n == 0){
+            // Leitura além do fim da imagem: o restante é zero
+            memset(base + done, 0, len - done);
+            break;
+        }
+        done += (size_t)n;
+    }
+    return (ssize_t)len;
+}
+
+static void blkio_pool_task(void* arg){
+    BlkioRequest* req = (BlkioRequest*)arg;
+    req->result = blkio_sync_transfer(req, 0);
+}
+
+static void blkio_pool_submit(BlkioRequest* reqs, int count){
+    // Uma faixa só não compensa a passagem para outra thread
+    if (count == 1 || !blkio_pool){
+        for (int i = 0; i < count; i++) blkio_pool_task(&reqs[i]);
+        return;
+    }
+
+    for (int i = 0; i < count; i++){
+        if (tp_submit(blkio_pool, blkio_pool_task, &reqs[i]) != 0){
+            blkio_pool_task(&reqs[i]);
+        }
+    }
+    tp_wait(blkio_pool);
+}
+
+// ---------------------------------------------------------------------------
+
+int blkio_open(const char* path, int queue_depth, int use_uring, int* existing_blocks){
+    if (blkio_fd >= 0 || !path) return -1;
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)){
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+
+    blkio_image_path = strdup(path);
+    if (!blkio_image_path){
+        close(fd);
+        return -1;
+    }
+
+    blkio_fd    = fd;
+    blkio_depth = queue_depth > 0 ? queue_depth : BLKIO_DEFAULT_QUEUE_DEPTH;
+    if (existing_blocks) *existing_blocks = (int)(st.st_size / FS_BLOCK_SIZE);
+
+    blkio_uring_on = use_uring && blkio_uring_setup((unsigned)blkio_depth) == 0;
+    if (blkio_uring_on){
+        if ((int)blkio_ring.entries < blkio_depth) blkio_depth = (int)blkio_ring.entries;
+    } else {
+        int threads = blkio_depth < BLKIO_MAX_THREADS ? blkio_depth : BLKIO_MAX_THREADS;
+        blkio_pool = tp_create(threads); // Sem pool, as faixas são feitas uma a uma
+    }
+    return 0;
+}
+
+int blkio_is_open(void){
+    return blkio_fd >= 0;
+}
+
+void blkio_close(void){
+    if (blkio_fd < 0) return;
+
+    if (blkio_uring_on) blkio_uring_teardown();
+    if (blkio_pool) tp_destroy(blkio_pool);
+    blkio_pool = NULL;
+    blkio_uring_on = 0;
+
+    fdatasync(blkio_fd);
+    close(blkio_fd);
+    blkio_fd = -1;
+    free(blkio_image_path);
+    blkio_image_path = NULL;
+}
+
+const char* blkio_path(void){
+    return blkio_image_path;
+}
+
+const char* blkio_backend_name(void){
+    return blkio_uring_on ? "io_uring" : "pread/pwrite";
+}
+
+int blkio_queue_depth(void){
+    return blkio_depth;
+}
+
+int blkio_resize(int total_blocks){
+    if (blkio_fd < 0) return 0;
+
+    struct stat st;
+    off_t size = (off_t)total_blocks * FS_BLOCK_SIZE;
+    if (fstat(blkio_fd, &st) == 0 && st.st_size >= size) return 0; // A imagem só cresce
+    return ftruncate(blkio_fd, size);
+}
+
+// Agrupa a lista em faixas contíguas e executa o lote. Com packed, o bloco i da
+// lista está em disk + i * FS_BLOCK_SIZE em vez de na posição do índice
+static int blkio_transfer(char* disk, const int* indices, int count, int write, int packed){
+    if (blkio_fd < 0) return 0;
+    if (count <= 0) return 0;
+
+    BlkioRequest* reqs = (BlkioRequest*)malloc((size_t)count * sizeof(BlkioRequest));
+    if (!reqs) return -1;
+
+    int nreq = 0;
+    for (int i = 0; i < count; i++){
+        int idx = indices[i];
+        if (nreq > 0 && reqs[nreq - 1].offset + (off_t)reqs[nreq - 1].iov.iov_len == (off_t)idx * FS_BLOCK_SIZE){
+            reqs[nreq - 1].iov.iov_len += FS_BLOCK_SIZE; // Bloco seguido do anterior
+            reqs[nreq - 1].blocks++;
+            continue;
+        }
+        reqs[nreq].iov.iov_base = disk + (size_t)(packed ? i : idx) * FS_BLOCK_SIZE;
+        reqs[nreq].iov.iov_len  = FS_BLOCK_SIZE;
+        reqs[nreq].offset = (off_t)idx * FS_BLOCK_SIZE;
+        reqs[nreq].write  = write;
+        reqs[nreq].blocks = 1;
+        reqs[nreq].result = 0;
+        nreq++;
+    }
+
+    pthread_mutex_lock(&blkio_lock);
+
+    // A fila nunca recebe mais que blkio_depth requisições por vez
+    for (int start = 0; start < nreq; start += blkio_depth){
+        int window = nreq - start < blkio_depth ? nreq - start : blkio_depth;
+
+        if (blkio_uring_on && blkio_uring_submit(&reqs[start], window) != 0){
+            blkio_uring_teardown(); // O anel falhou: segue sem ele
+            blkio_uring_on = 0;
+            blkio_pool = tp_create(blkio_depth < BLKIO_MAX_THREADS ? blkio_depth : BLKIO_MAX_THREADS);
+        }
+        if (!blkio_uring_on){
+            blkio_pool_submit(&reqs[start], window);
+        }
+    }
+
+    int status = 0;
+    for (int i = 0; i < nreq; i++){
+        ssize_t res = reqs[i].result;
+        if (res >= 0 && (size_t)res < reqs[i].iov.iov_len){
+            res = blkio_sync_transfer(&reqs[i], (size_t)res); // Transferência parcial
+        } else if (res == -EINVAL && blkio_uring_on){
+            res = blkio_sync_transfer(&reqs[i], 0); // Kernel sem READV/WRITEV no anel
+        }
+        if (res < 0){
+            atomic_fetch_add_explicit(&blkio_errors, 1, memory_order_relaxed);
+            errno = (int)-res;
+            status = -1;
+        }
+    }
+
+    pthread_mutex_unlock(&blkio_lock);
+
+    atomic_fetch_add_explicit(&blkio_batches, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&blkio_requests, nreq, memory_order_relaxed);
+    atomic_fetch_add_explicit(&blkio_blocks, count, memory_order_relaxed);
+    free(reqs);
+    return status;
+}
+
+int blkio_read(char* disk, const int* indices, int count){
+    return blkio_transfer(disk, indices, count, 0, 0);
+}
+
+int blkio_write(const char* disk, const int* indices, int count){
+    return blkio_transfer((char*)disk, indices, count, 1, 0); // Os buffers só são lidos
+}
+
+int blkio_write_packed(const char* buffer, const int* indices, int count){
+    return blkio_transfer((char*)buffer, indices, count, 1, 1);
+}
+
+int blkio_sync(void){
+    if (blkio_fd < 0) return 0;
+    atomic_fetch_add_explicit(&blkio_syscalls, 1, memory_order_relaxed);
+    return fdatasync(blkio_fd);
+}
+
+void blkio_get_stats(BlkioStats* stats){
+    stats->batches  = atomic_load(&blkio_batches);
+    stats->requests = atomic_load(&blkio_requests);
+    stats->blocks   = atomic_load(&blkio_blocks);
+    stats->syscalls = atomic_load(&blkio_syscalls);
+    stats->errors   = atomic_load(&blkio_errors);
+}
@@ -1,127 +1,1846 @@
-#include <stdio.h>
-#include <string.h>
-
-#include "fs.h"
-#include "blocks.h"
-
-static char fs_disk[FS_BLOCK_SIZE * FS_MAX_BLOCKS];
-static int fs_block_used[FS_MAX_BLOCKS];
-
-
-void blocks_init(){
-    for (int i = 0; i < FS_MAX_BLOCKS; i++){
-        fs_block_used[i] = 0; // Livre
-    }
-}
-
-void blocks_shutdown(){
-    // Nada a fazer por enquanto
-}
-
-static int blocks_find_free(int needed, int* out_indices){
-    int found = 0;
-    
-    for (int i = 0; i < FS_MAX_BLOCKS && found < needed; i++){
-        if(!fs_block_used[i]){
-            out_indices[found++] = i;
-        }
-    }
-
-    return (found == needed) ? 0 : -1;
-}
-
-void blocks_free_for_file(FCB* fcb){
-    if(!fcb) return;
-
-    for(int i = 0; i < fcb->block_count; i++){
-        int block_index = fcb->blocks[i];
-        if(block_index >=0 && block_index < FS_MAX_BLOCKS){
-            fs_block_used[block_index] = 0; // libera o bloco
-        }
-        fcb->blocks[i] = -1; // invalida o índice
-    }
-    fcb->block_count = 0;
-}
-
-int blocks_alloc_for_file(FCB* fcb, const char* data, size_t len){
-    if(!fcb) return -1;
-
-    blocks_free_for_file(fcb); // libera blocos existentes
-
-    if(len == 0) return 0; // nada a alocar
-
-    // Calcula quantos blocos são necessários para armazinar os dados
-    size_t blocks_needed = (len + FS_BLOCK_SIZE -1) / FS_BLOCK_SIZE;
-    if((int)blocks_needed > FCB_MAX_BLOCKS){
-        return -1; // arquivo muito grande
-    }
-
-    int indexes[FCB_MAX_BLOCKS];
-    // Procura por blocos livres
-    if(blocks_find_free((int)blocks_needed, indexes) != 0){
-        return -1; // espaço insuficiente
-    }
-
-    // Marca os blocos encontrados como "usados" e armazena no FCB
-    for (int i = 0; i < (int)blocks_needed; i++){
-        int idx = indexes[i];
-        fs_block_used[idx] = 1;     // marca como usado
-        fcb->blocks[i] = idx;       // armazena o índice
-    }
-
-    fcb->block_count = (int)blocks_needed; // Registra quantos blocos foram alocados
-
-    // Grava os dados do arquivo dentro dos blocos alocados
-    for (int i = 0; i < (int)blocks_needed; i++){
-        int idx = fcb->blocks[i];
-        size_t offset = i * FS_BLOCK_SIZE;
-        size_t remaining = 0;
-
-        // Calcula quantos bytes ainda faltam escrever no arquivo
-        if(offset < len){
-            remaining = len - offset;
-            if (remaining > FS_BLOCK_SIZE){
-                remaining = FS_BLOCK_SIZE;
-            }
-        }
-
-        size_t base = (size_t)idx * FS_BLOCK_SIZE; // Endereço do bloco
-        if(remaining > 0){
-            memcpy(&fs_disk[base], data + offset, remaining); // Preenche com os dados
-        } if(remaining < FS_BLOCK_SIZE){
-            memset(&fs_disk[base + remaining], 0, FS_BLOCK_SIZE - remaining); // Zera o restante do bloco
-        } else {
-            memset(&fs_disk[base], 0, FS_BLOCK_SIZE); // Zera o bloco inteiro
-        }
-    }
-    return 0;
-}
-
-void blocks_dump_file(const FCB* fcb) {
-    if (!fcb) return;
-
-    printf("blocos: ");
-    for (int i = 0; i < fcb->block_count; i++) {
-        printf("%d ", fcb->blocks[i]); // Imprime cada bloco alocado ao arquivo
-    }
-    if (fcb->block_count == 0) {
-        printf("(nenhum bloco alocado)");
-    }
-    printf("\n");
-}
-
-void blocks_stats(int* total_blocks, int* used_blocks, int* free_blocks){
-    if(total_blocks) { *total_blocks = FS_MAX_BLOCKS; } 
-
-    int used = 0;
-    // Conta quantos blocos estão marcados como usados 
-    for (int i = 0; i < FS_MAX_BLOCKS; i++){
-        if(fs_block_used[i]){
-            used++;
-        }
-    }
-
-    if (used_blocks) { *used_blocks = used; }
-
-    if (free_blocks) { *free_blocks = FS_MAX_BLOCKS - used; }
-}
\ No newline at end of file
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "fs.h"
+#include "blocks.h"
+#include "fcb_helpers.h"
+#include "dedup.h"
+#include "delalloc.h"
+#include "lz.h"
+#include "crc32c.h"
+#include "mem.h"
+#include "trace.h"
+#include "blkio.h"
+#include "thread_pool.h"
+
+// Disco simulado: área de dados e mapa de ocupação, dimensionados em tempo de execução
+static char* fs_disk = NULL;
+static int*  fs_block_used = NULL;   // Contagem de referências de cada bloco (0 = livre)
+static uint32_t* fs_block_crc = NULL; // CRC32C de cada bloco, gravado junto com a alocação
+static atomic_uchar* fs_block_seal = NULL; // Se o CRC de cada bloco vale (BLOCK_STALE, ...)
+static int   fs_total_blocks = 0;
+static int   fs_used_count = 0;      // Blocos com contagem > 0
+static int   fs_reserved = 0;        // Capacidade prometida à alocação adiada (ainda sem blocos)
+static int   fs_compress = 0;        // Compressão transparente das novas gravações
+static size_t fs_inline_max = FCB_INLINE_MAX; // Arquivos até este tamanho ficam dentro do FCB
+static atomic_int fs_checksums = 1;  // CRCs mantidos e conferidos (o bench desliga para comparar)
+static const char blocks_zeros[FCB_MAX_BLOCKS * FS_BLOCK_SIZE]; // O que os buracos entregam ao writev (em ciclo)
+static atomic_long fs_checksum_errors;
+
+// Quem muda blocos (a shell, um comando por vez) contra o scrub em segundo plano
+static pthread_mutex_t fs_block_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Estados de fs_block_seal. Gravar só marca os blocos como STALE, sem calcular nada: o
+// CRC é calculado quando o bloco vai para a imagem (na descarga) ou pelo scrub. SEALING
+// impede que uma selagem guarde o CRC de bytes regravados no meio dela
+#define BLOCK_STALE   0   // O conteúdo mudou depois do último CRC
+#define BLOCK_SEALING 1
+#define BLOCK_SEALED  2   // fs_block_crc vale para o conteúdo atual
+
+// Com uma imagem anexada a memória é um cache de escrita adiada (write-back): toda
+// gravação só marca os blocos como sujos e uma thread os leva para a imagem depois.
+// Um bloco não residente é lido da imagem no primeiro acesso
+static atomic_uchar* fs_block_resident = NULL; // NULL = sem imagem
+static pthread_mutex_t fs_fetch_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_long fs_image_errors;
+
+#define BLOCKS_FETCH_BATCH 64
+#define BLOCKS_IOV_MAX     1024 // Faixas por writev/readv (o IOV_MAX do Linux)
+
+// Estados de fs_block_resident
+#define BLOCK_ABSENT     0
+#define BLOCK_RESIDENT   1
+#define BLOCK_PREFETCHED 2   // Trazido pela leitura antecipada e ainda não lido
+#define BLOCK_INFLIGHT   3   // Pedido pela leitura antecipada, ainda a caminho
+#define BLOCK_DIRTY      4   // Gravado na memória, ainda não na imagem
+#define BLOCK_WRITEBACK  5   // Sujo, sendo gravado na imagem agora
+#define BLOCK_BAD        6   // Lido da imagem com CRC divergente: leituras falham com EIO
+
+// Escrita adiada: a thread de descarga acorda a cada WB_INTERVAL_MS e grava os blocos
+// sujos quando passam de WB_BACKGROUND_RATIO % do disco ou o mais antigo tem WB_EXPIRE_MS.
+// Acima de WB_DIRTY_RATIO % quem grava descarrega na hora (segura novas gravações)
+#define WB_INTERVAL_MS      250
+#define WB_EXPIRE_MS        1000
+#define WB_BACKGROUND_RATIO 10
+#define WB_DIRTY_RATIO      40
+#define WB_BATCH            256  // Blocos copiados e gravados por lote
+
+static atomic_int  fs_dirty_blocks;
+static atomic_long fs_dirty_since;      // Quando o primeiro bloco sujo apareceu (ms, 0 = limpo)
+static atomic_long wb_rounds, wb_written;
+static pthread_mutex_t wb_lock = PTHREAD_MUTEX_INITIALIZER;     // Uma descarga por vez
+static pthread_mutex_t wb_copy_lock = PTHREAD_MUTEX_INITIALIZER; // Cópia dos blocos sujos
+static pthread_mutex_t wb_wake_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  wb_wake = PTHREAD_COND_INITIALIZER;
+static pthread_t wb_thread;
+static int wb_running = 0;
+static int wb_stop = 0;
+static int wb_kick = 0;
+
+// Leitura antecipada: cada arquivo lido em sequência ganha uma janela de blocos
+// (na ordem do mapa de blocos) buscada em segundo plano antes de ser pedida
+#define RA_STREAMS     16
+#define RA_MIN_WINDOW  4
+#define RA_INIT_WINDOW 8
+#define RA_MAX_WINDOW  FCB_MAX_BLOCKS
+
+typedef struct {
+    const FCB* fcb;
+    int inode;          // Confere se o FCB não foi reaproveitado por outro arquivo
+    int next;           // Posição no mapa de blocos esperada na próxima leitura sequencial
+    int ahead;          // Até onde a janela já foi pedida
+    int window;         // Blocos lidos à frente
+    unsigned long used; // Para escolher a entrada a substituir
+} RaStream;
+
+static RaStream ra_streams[RA_STREAMS];
+static unsigned long ra_clock = 0;
+static pthread_mutex_t ra_lock = PTHREAD_MUTEX_INITIALIZER;
+static ThreadPool* ra_pool = NULL;    // Uma thread: as leituras antecipadas em ordem
+static atomic_long ra_issued, ra_hits, ra_waste;
+
+static void blocks_ra_wait(void);
+static void blocks_wb_stop(void);
+static int  blocks_seal_begin(int block_index);
+static void blocks_seal_end(int block_index, const char* data);
+static int  blocks_check_loaded(int block_index);
+
+
+void blocks_init(){
+    fs_disk = NULL;
+    fs_block_used = NULL;
+    fs_block_crc = NULL;
+    fs_total_blocks = 0;
+    fs_used_count = 0;
+    fs_reserved = 0;
+    atomic_init(&fs_checksum_errors, 0);
+    crc32c_init();
+
+    if (blocks_resize(FS_MAX_BLOCKS) != 0){
+        fprintf(stderr, "Erro ao alocar memoria para o disco simulado\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void blocks_shutdown(){
+    if (ra_pool) tp_destroy(ra_pool);
+    ra_pool = NULL;
+    blocks_wb_stop();
+    blocks_sync(); // Grava o que ainda está sujo
+    dedup_shutdown();
+    mem_free(MEM_DISK, fs_disk);
+    mem_free(MEM_DISK, fs_block_used);
+    mem_free(MEM_DISK, fs_block_crc);
+    mem_free(MEM_DISK, (void*)fs_block_seal);
+    mem_free(MEM_DISK, (void*)fs_block_resident);
+    blkio_close();
+    fs_disk = NULL;
+    fs_block_used = NULL;
+    fs_block_crc = NULL;
+    fs_block_seal = NULL;
+    fs_block_resident = NULL;
+    fs_total_blocks = 0;
+    fs_used_count = 0;
+    fs_reserved = 0;
+}
+
+// Realoca os vetores do disco (com a descarga parada)
+static int blocks_grow(int total_blocks){
+    char* disk = (char*)mem_realloc(MEM_DISK, fs_disk, (size_t)total_blocks * FS_BLOCK_SIZE);
+    if (!disk) return -1;
+    fs_disk = disk;
+
+    int* used = (int*)mem_realloc(MEM_DISK, fs_block_used, (size_t)total_blocks * sizeof(int));
+    if (!used) return -1;
+    fs_block_used = used;
+
+    uint32_t* crc = (uint32_t*)mem_realloc(MEM_DISK, fs_block_crc, (size_t)total_blocks * sizeof(uint32_t));
+    if (!crc) return -1;
+    fs_block_crc = crc;
+
+    atomic_uchar* seal = (atomic_uchar*)mem_realloc(MEM_DISK, (void*)fs_block_seal, (size_t)total_blocks);
+    if (!seal) return -1;
+    fs_block_seal = seal;
+
+    if (fs_block_resident){
+        atomic_uchar* resident = (atomic_uchar*)mem_realloc(MEM_DISK, (void*)fs_block_resident,
+                                                            (size_t)total_blocks);
+        if (!resident) return -1;
+        fs_block_resident = resident;
+        for (int i = fs_total_blocks; i < total_blocks; i++){
+            atomic_init(&fs_block_resident[i], BLOCK_RESIDENT); // Zerado na memória e na imagem
+        }
+        if (blkio_resize(total_blocks) != 0){
+            atomic_fetch_add(&fs_image_errors, 1);
+        }
+    }
+
+    // Blocos novos começam livres e zerados
+    memset(&fs_disk[(size_t)fs_total_blocks * FS_BLOCK_SIZE], 0,
+           (size_t)(total_blocks - fs_total_blocks) * FS_BLOCK_SIZE);
+    memset(&fs_block_used[fs_total_blocks], 0,
+           (size_t)(total_blocks - fs_total_blocks) * sizeof(int));
+
+    static const char zero_block[FS_BLOCK_SIZE];
+    uint32_t zero_crc = crc32c(0, zero_block, FS_BLOCK_SIZE);
+    for (int i = fs_total_blocks; i < total_blocks; i++){
+        fs_block_crc[i] = zero_crc;
+        atomic_init(&fs_block_seal[i], BLOCK_SEALED);
+    }
+
+    fs_total_blocks = total_blocks;
+    dedup_resize(total_blocks);
+    return 0;
+}
+
+int blocks_resize(int total_blocks){
+    if (total_blocks <= fs_total_blocks){
+        return 0; // O disco só cresce
+    }
+    blocks_ra_wait(); // O disco pode mudar de endereço
+    pthread_mutex_lock(&wb_lock);
+    int result = blocks_grow(total_blocks);
+    pthread_mutex_unlock(&wb_lock);
+    return result;
+}
+
+int blocks_total(void){
+    return fs_total_blocks;
+}
+
+// Marca o bloco como lido e devolve o estado anterior (ABSENT: precisa vir da imagem)
+static unsigned char blocks_touch(int idx){
+    unsigned char state = atomic_load_explicit(&fs_block_resident[idx], memory_order_acquire);
+    if (state == BLOCK_PREFETCHED &&
+        atomic_exchange(&fs_block_resident[idx], BLOCK_RESIDENT) == BLOCK_PREFETCHED){
+        atomic_fetch_add_explicit(&ra_hits, 1, memory_order_relaxed);
+    }
+    return state;
+}
+
+// Lê da imagem os blocos ausentes da lista, em lotes, deixando-os no estado indicado
+static void blocks_load(const int* indices, int count, unsigned char state){
+    pthread_mutex_lock(&fs_fetch_lock);
+    int batch[BLOCKS_FETCH_BATCH];
+    int n = 0;
+    for (int i = 0; i <= count; i++){
+        if (i < count){
+            int idx = indices[i];
+            if (idx < 0 || idx >= fs_total_blocks) continue;
+            unsigned char wanted = state == BLOCK_RESIDENT ? BLOCK_ABSENT : BLOCK_INFLIGHT;
+            if (state == BLOCK_RESIDENT ? blocks_touch(idx) != wanted
+                : atomic_load_explicit(&fs_block_resident[idx], memory_order_relaxed) != wanted){
+                continue;
+            }
+            batch[n++] = idx;
+            if (n < BLOCKS_FETCH_BATCH) continue;
+        }
+        if (n == 0) continue;
+
+        if (blkio_read(fs_disk, batch, n) != 0){
+            atomic_fetch_add(&fs_image_errors, 1);
+        }
+        // O CRC só é conferido aqui, quando o bloco volta da imagem. Mesmo com erro de E/S
+        // o bloco fica na memória: o CRC acusa os dados errados
+        for (int j = 0; j < n; j++){
+            unsigned char loaded = blocks_check_loaded(batch[j]) == 0 ? state : BLOCK_BAD;
+            atomic_store_explicit(&fs_block_resident[batch[j]], loaded, memory_order_release);
+        }
+        n = 0;
+    }
+    pthread_mutex_unlock(&fs_fetch_lock);
+}
+
+// Traz da imagem os blocos da lista que ainda não estão na memória (um lote por vez).
+// Retorna -1 (errno = EIO) se algum deles voltou da imagem com o CRC errado
+static int blocks_fetch(const int* indices, int count){
+    if (!fs_block_resident) return 0;
+
+    int missing = 0, inflight = 0, bad = 0;
+    for (int i = 0; i < count; i++){
+        int idx = indices[i];
+        if (idx < 0 || idx >= fs_total_blocks) continue;
+        unsigned char state = blocks_touch(idx);
+        missing  |= state == BLOCK_ABSENT;
+        inflight |= state == BLOCK_INFLIGHT;
+        bad      |= state == BLOCK_BAD;
+    }
+
+    if (inflight){
+        // A leitura antecipada já pediu parte dos blocos: espera por ela em vez de ler de novo
+        blocks_ra_wait();
+        missing = 0;
+        for (int i = 0; i < count; i++){
+            int idx = indices[i];
+            if (idx < 0 || idx >= fs_total_blocks) continue;
+            unsigned char state = blocks_touch(idx);
+            missing |= state == BLOCK_ABSENT;
+            bad     |= state == BLOCK_BAD;
+        }
+    }
+    if (missing){
+        blocks_load(indices, count, BLOCK_RESIDENT);
+        for (int i = 0; i < count; i++){
+            int idx = indices[i];
+            if (idx >= 0 && idx < fs_total_blocks){
+                bad |= atomic_load_explicit(&fs_block_resident[idx], memory_order_acquire) == BLOCK_BAD;
+            }
+        }
+    }
+    if (bad){
+        errno = EIO;
+        return -1;
+    }
+    return 0; // Caminho comum: tudo residente, sem trava e sem CRC
+}
+
+typedef struct {
+    int count;
+    int indices[RA_MAX_WINDOW];
+} RaJob;
+
+static void blocks_ra_task(void* arg){
+    RaJob* job = (RaJob*)arg;
+    blocks_load(job->indices, job->count, BLOCK_PREFETCHED);
+    free(job);
+}
+
+// Espera as leituras antecipadas pendentes (antes de alocar ou mover blocos)
+static void blocks_ra_wait(void){
+    if (ra_pool) tp_wait(ra_pool);
+}
+
+// Soma ao desperdício um bloco trazido antecipadamente que não chegou a ser lido
+static void blocks_ra_discard(int idx){
+    if (atomic_load_explicit(&fs_block_resident[idx], memory_order_relaxed) == BLOCK_PREFETCHED &&
+        atomic_exchange(&fs_block_resident[idx], BLOCK_RESIDENT) == BLOCK_PREFETCHED){
+        atomic_fetch_add_explicit(&ra_waste, 1, memory_order_relaxed);
+    }
+}
+
+static RaStream* blocks_ra_stream(const FCB* fcb, int first, int* sequential){
+    RaStream* victim = &ra_streams[0];
+    for (int i = 0; i < RA_STREAMS; i++){
+        RaStream* s = &ra_streams[i];
+        if (s->fcb == fcb && s->inode == fcb->inode){
+            if (first == 0) s->ahead = 0; // Voltou ao início: nova passada pelo arquivo
+            *sequential = first == s->next || first == 0;
+            return s;
+        }
+        if (s->used < victim->used) victim = s;
+    }
+
+    // Primeira leitura do arquivo: só conta como sequencial se começar do início
+    victim->fcb    = fcb;
+    victim->inode  = fcb->inode;
+    victim->next   = 0;
+    victim->ahead  = 0;
+    victim->window = RA_INIT_WINDOW;
+    *sequential = first == 0;
+    return victim;
+}
+
+// Lê as posições [first, end) do mapa de blocos e pede a próxima janela em segundo plano.
+// Retorna -1 (errno = EIO) se algum bloco pedido voltou da imagem corrompido
+static int blocks_fetch_file(const FCB* fcb, int first, int end){
+    if (!fs_block_resident || end <= first) return 0;
+
+    pthread_mutex_lock(&ra_lock);
+    int sequential;
+    RaStream* s = blocks_ra_stream(fcb, first, &sequential);
+    s->used = ++ra_clock;
+
+    if (sequential){
+        // A janela anterior acertou: dobra. Se a leitura alcançou a janela, ela também cresce
+        if (s->ahead > first && s->window < RA_MAX_WINDOW) s->window *= 2;
+        if (s->window > RA_MAX_WINDOW) s->window = RA_MAX_WINDOW;
+    } else {
+        s->window /= 2; // Acesso aleatório: a janela encolhe
+        if (s->window < RA_MIN_WINDOW) s->window = RA_MIN_WINDOW;
+        s->ahead = end;
+    }
+    s->next = end;
+
+    int from = s->ahead > end ? s->ahead : end;
+    int to   = end + s->window < fcb->block_count ? end + s->window : fcb->block_count;
+    if (!sequential || to < from) to = from;
+    s->ahead = to;
+    pthread_mutex_unlock(&ra_lock);
+
+    const int* map = fcb_blocks(fcb);
+    int result = blocks_fetch(&map[first], end - first);
+    if (to == from) return result;
+
+    // Só entram na janela os blocos ausentes; quem pedir um deles espera a leitura terminar
+    RaJob* job = (RaJob*)malloc(sizeof(RaJob));
+    if (!job) return result;
+    job->count = 0;
+    for (int i = from; i < to; i++){
+        int idx = map[i];
+        unsigned char absent = BLOCK_ABSENT;
+        if (idx >= 0 && idx < fs_total_blocks &&
+            atomic_compare_exchange_strong(&fs_block_resident[idx], &absent, BLOCK_INFLIGHT)){
+            job->indices[job->count++] = idx;
+        }
+    }
+
+    if (job->count == 0){
+        free(job);
+    } else {
+        atomic_fetch_add_explicit(&ra_issued, job->count, memory_order_relaxed);
+        if (!ra_pool) ra_pool = tp_create(1);
+        if (!ra_pool || tp_submit(ra_pool, blocks_ra_task, job) != 0){
+            blocks_ra_task(job); // Sem thread: lê na hora
+        }
+    }
+    return result;
+}
+
+void blocks_readahead_stats(long* issued, long* hits, long* waste){
+    if (issued) *issued = atomic_load(&ra_issued);
+    if (hits)   *hits   = atomic_load(&ra_hits);
+    if (waste)  *waste  = atomic_load(&ra_waste);
+}
+
+void blocks_fetch_range(int first_block, int count){
+    if (!fs_block_resident || count <= 0) return;
+
+    int indices[BLOCKS_FETCH_BATCH];
+    for (int start = first_block; start < first_block + count; start += BLOCKS_FETCH_BATCH){
+        int n = first_block + count - start < BLOCKS_FETCH_BATCH ? first_block + count - start
+                                                                 : BLOCKS_FETCH_BATCH;
+        int used = 0;
+        for (int i = start; i < start + n; i++){
+            if (fs_block_used[i]) indices[used++] = i; // Bloco livre é regravado inteiro antes do uso
+        }
+        blocks_fetch(indices, used);
+    }
+}
+
+static long blocks_now_ms(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int blocks_is_dirty(unsigned char state){
+    return state == BLOCK_DIRTY || state == BLOCK_WRITEBACK;
+}
+
+// Esquece a sujeira de um bloco cujo conteúdo deixou de valer (liberado ou realocado).
+// Espera a cópia da descarga, se ela estiver lendo o bloco, antes de ele ser regravado
+static void blocks_clean(int idx){
+    if (!blocks_is_dirty(atomic_load_explicit(&fs_block_resident[idx], memory_order_relaxed))) return;
+
+    pthread_mutex_lock(&wb_copy_lock);
+    if (blocks_is_dirty(atomic_exchange(&fs_block_resident[idx], BLOCK_RESIDENT))){
+        atomic_fetch_sub(&fs_dirty_blocks, 1);
+    }
+    pthread_mutex_unlock(&wb_copy_lock);
+}
+
+// O bloco foi regravado: o CRC antigo deixa de valer e será recalculado depois
+static void blocks_unseal(int block_index){
+    if (atomic_load_explicit(&fs_checksums, memory_order_relaxed)){
+        atomic_store_explicit(&fs_block_seal[block_index], BLOCK_STALE, memory_order_release);
+    }
+}
+
+// Um bloco livre que volta a ser usado será regravado inteiro: o CRC antigo (e um CRC errado
+// vindo da imagem) deixa de valer. Ninguém o sela antes dos dados novos chegarem: ele ainda
+// não está sujo e o scrub não anda no meio de um comando
+static void blocks_claim(int idx){
+    blocks_unseal(idx);
+    if (!fs_block_resident) return;
+    blocks_clean(idx);
+    unsigned char bad = BLOCK_BAD;
+    atomic_compare_exchange_strong(&fs_block_resident[idx], &bad, BLOCK_RESIDENT);
+}
+
+static void blocks_wb_kick(void){
+    pthread_mutex_lock(&wb_wake_lock);
+    wb_kick = 1;
+    pthread_cond_signal(&wb_wake);
+    pthread_mutex_unlock(&wb_wake_lock);
+}
+
+// Grava na imagem todos os blocos sujos, em ordem de índice e em lotes
+static void blocks_writeback(void){
+    pthread_mutex_lock(&wb_lock);
+    if (atomic_load(&fs_dirty_blocks) == 0){
+        pthread_mutex_unlock(&wb_lock);
+        return;
+    }
+
+    char* buffer = (char*)malloc((size_t)WB_BATCH * FS_BLOCK_SIZE);
+    int indices[WB_BATCH];
+    atomic_fetch_add(&wb_rounds, 1);
+    atomic_store(&fs_dirty_since, 0); // Quem sujar um bloco durante a descarga reinicia a idade
+
+    for (int next = 0; buffer && next < fs_total_blocks; ){
+        // Copia um lote de blocos sujos; a gravação sai do buffer, com o disco livre
+        int n = 0;
+        pthread_mutex_lock(&wb_copy_lock);
+        for (; next < fs_total_blocks && n < WB_BATCH; next++){
+            unsigned char dirty = BLOCK_DIRTY;
+            if (!atomic_compare_exchange_strong(&fs_block_resident[next], &dirty, BLOCK_WRITEBACK)) continue;
+
+            // O CRC sai da cópia que vai para a imagem, fora do caminho de quem gravou
+            char* copy = &buffer[(size_t)n * FS_BLOCK_SIZE];
+            int sealing = blocks_seal_begin(next);
+            memcpy(copy, &fs_disk[(size_t)next * FS_BLOCK_SIZE], FS_BLOCK_SIZE);
+            if (sealing) blocks_seal_end(next, copy);
+            indices[n++] = next;
+        }
+        pthread_mutex_unlock(&wb_copy_lock);
+        if (n == 0) break;
+
+        int failed = blkio_write_packed(buffer, indices, n) != 0;
+        if (failed) atomic_fetch_add(&fs_image_errors, 1);
+
+        // Se o bloco foi liberado ou regravado no meio, o novo estado prevalece
+        for (int i = 0; i < n; i++){
+            unsigned char writeback = BLOCK_WRITEBACK;
+            if (atomic_compare_exchange_strong(&fs_block_resident[indices[i]], &writeback,
+                                               failed ? BLOCK_DIRTY : BLOCK_RESIDENT) && !failed){
+                atomic_fetch_sub(&fs_dirty_blocks, 1);
+            }
+        }
+        if (!failed) atomic_fetch_add(&wb_written, n);
+    }
+    free(buffer);
+
+    if (atomic_load(&fs_dirty_blocks) > 0 && atomic_load(&fs_dirty_since) == 0){
+        atomic_store(&fs_dirty_since, blocks_now_ms()); // Sobrou algo (erro): tenta de novo depois
+    }
+    pthread_mutex_unlock(&wb_lock);
+}
+
+static void* blocks_wb_main(void* arg){
+    (void)arg;
+    pthread_mutex_lock(&wb_wake_lock);
+    while (!wb_stop){
+        if (!wb_kick){
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_nsec += (long)WB_INTERVAL_MS * 1000000;
+            until.tv_sec  += until.tv_nsec / 1000000000;
+            until.tv_nsec %= 1000000000;
+            pthread_cond_timedwait(&wb_wake, &wb_wake_lock, &until);
+        }
+        int kicked = wb_kick;
+        wb_kick = 0;
+        if (wb_stop) break;
+        pthread_mutex_unlock(&wb_wake_lock);
+
+        int  dirty = atomic_load(&fs_dirty_blocks);
+        long since = atomic_load(&fs_dirty_since);
+        if (dirty > 0 && (kicked || (long)dirty * 100 >= (long)fs_total_blocks * WB_BACKGROUND_RATIO ||
+                          (since > 0 && blocks_now_ms() - since >= WB_EXPIRE_MS))){
+            blocks_writeback();
+        }
+        pthread_mutex_lock(&wb_wake_lock);
+    }
+    pthread_mutex_unlock(&wb_wake_lock);
+    return NULL;
+}
+
+// Marca como sujos blocos que acabaram de ser escritos na memória
+static void blocks_persist(const int* indices, int count){
+    if (!fs_block_resident || count <= 0) return;
+
+    int added = 0;
+    for (int i = 0; i < count; i++){
+        if (indices[i] < 0 || indices[i] >= fs_total_blocks) continue; // Buraco no mapa do arquivo
+        blocks_ra_discard(indices[i]); // Regravado antes de ser lido
+        unsigned char old = atomic_exchange(&fs_block_resident[indices[i]], BLOCK_DIRTY);
+        added += !blocks_is_dirty(old);
+    }
+    if (added == 0) return;
+
+    long zero = 0;
+    atomic_compare_exchange_strong(&fs_dirty_since, &zero, blocks_now_ms());
+    long dirty = atomic_fetch_add(&fs_dirty_blocks, added) + added;
+
+    if (dirty * 100 >= (long)fs_total_blocks * WB_DIRTY_RATIO){
+        blocks_writeback(); // Sujeira demais: quem grava paga a descarga
+    } else if (dirty * 100 >= (long)fs_total_blocks * WB_BACKGROUND_RATIO){
+        blocks_wb_kick();
+    }
+}
+
+// Para a thread de descarga (desligamento)
+static void blocks_wb_stop(void){
+    if (!wb_running) return;
+
+    pthread_mutex_lock(&wb_wake_lock);
+    wb_stop = 1;
+    pthread_cond_signal(&wb_wake);
+    pthread_mutex_unlock(&wb_wake_lock);
+    pthread_join(wb_thread, NULL);
+    wb_running = 0;
+}
+
+int blocks_sync(void){
+    if (!fs_block_resident) return -1;
+
+    blocks_writeback();
+    return blkio_sync();
+}
+
+void blocks_writeback_stats(int* dirty, long* rounds, long* written){
+    if (dirty)   *dirty   = atomic_load(&fs_dirty_blocks);
+    if (rounds)  *rounds  = atomic_load(&wb_rounds);
+    if (written) *written = atomic_load(&wb_written);
+}
+
+static void blocks_persist_file(const FCB* fcb){
+    if (fcb && !fcb->inlined) blocks_persist(fcb_blocks(fcb), fcb->block_count);
+}
+
+int blocks_attach_image(const char* path, int queue_depth, int use_uring){
+    if (fs_block_resident) return -1; // Já existe uma imagem
+
+    int existing = 0;
+    if (blkio_open(path, queue_depth, use_uring, &existing) != 0) return -1;
+
+    // O disco acompanha o tamanho da imagem (os blocos antigos ficam livres)
+    if (existing > fs_total_blocks && blocks_resize(existing) != 0){
+        blkio_close();
+        return -1;
+    }
+
+    atomic_uchar* resident = (atomic_uchar*)mem_alloc(MEM_DISK, (size_t)fs_total_blocks);
+    if (!resident || blkio_resize(fs_total_blocks) != 0){
+        mem_free(MEM_DISK, resident);
+        blkio_close();
+        return -1;
+    }
+    for (int i = 0; i < fs_total_blocks; i++){
+        atomic_init(&resident[i], BLOCK_RESIDENT);
+    }
+    fs_block_resident = resident;
+    atomic_init(&fs_image_errors, 0);
+    atomic_init(&fs_dirty_blocks, 0);
+    atomic_init(&fs_dirty_since, 0);
+
+    wb_stop = 0;
+    wb_running = pthread_create(&wb_thread, NULL, blocks_wb_main, NULL) == 0;
+
+    // Blocos gravados antes da imagem existir (ex.: arquivos de exemplo) vão para ela agora
+    int* used = (int*)malloc((size_t)fs_total_blocks * sizeof(int));
+    if (used){
+        int n = 0;
+        for (int i = 0; i < fs_total_blocks; i++){
+            if (fs_block_used[i]) used[n++] = i;
+        }
+        blocks_persist(used, n);
+        free(used);
+    }
+    return 0;
+}
+
+int blocks_drop_cache(void){
+    if (!fs_block_resident) return -1;
+
+    // Só blocos limpos saem: os sujos ainda não estão na imagem
+    blocks_ra_wait();
+    pthread_mutex_lock(&wb_lock);
+    pthread_mutex_lock(&fs_fetch_lock);
+    int dropped = 0;
+    for (int i = 0; i < fs_total_blocks; i++){
+        blocks_ra_discard(i);
+        unsigned char state = atomic_load_explicit(&fs_block_resident[i], memory_order_relaxed);
+        if (state == BLOCK_RESIDENT || state == BLOCK_BAD){ // Um bloco ruim é relido da imagem
+            atomic_store_explicit(&fs_block_resident[i], BLOCK_ABSENT, memory_order_relaxed);
+            memset(&fs_disk[(size_t)i * FS_BLOCK_SIZE], 0, FS_BLOCK_SIZE);
+            dropped++;
+        }
+    }
+    pthread_mutex_unlock(&fs_fetch_lock);
+    pthread_mutex_unlock(&wb_lock);
+    return dropped;
+}
+
+long blocks_image_errors(void){
+    return fs_block_resident ? atomic_load(&fs_image_errors) : 0;
+}
+
+char* blocks_data(int block_index){
+    if (block_index < 0 || block_index >= fs_total_blocks) return NULL;
+    blocks_fetch(&block_index, 1);
+    return &fs_disk[(size_t)block_index * FS_BLOCK_SIZE];
+}
+
+int blocks_refcount(int block_index){
+    if (block_index < 0 || block_index >= fs_total_blocks) return 0;
+    return fs_block_used[block_index];
+}
+
+void blocks_set_refcount(int block_index, int refcount){
+    if (block_index < 0 || block_index >= fs_total_blocks || refcount < 0) return;
+
+    if (refcount == 0 && fs_block_used[block_index] > 0){
+        dedup_forget(block_index);
+        fs_used_count--;
+    } else if (refcount > 0 && fs_block_used[block_index] == 0){
+        fs_used_count++;
+    }
+    fs_block_used[block_index] = refcount;
+    dedup_note_release(block_index, refcount);
+}
+
+
+// Para gravações no lugar, em blocos que o arquivo já tinha
+static void blocks_unseal_file(const FCB* fcb){
+    if (!atomic_load_explicit(&fs_checksums, memory_order_relaxed) || fcb->inlined) return;
+    const int* map = fcb_blocks(fcb);
+    for (int i = 0; i < fcb->block_count; i++){
+        int idx = map[i];
+        if (idx >= 0 && idx < fs_total_blocks){ // Buracos não têm bloco nem CRC
+            atomic_store_explicit(&fs_block_seal[idx], BLOCK_STALE, memory_order_release);
+        }
+    }
+}
+
+// Reserva a selagem de um bloco STALE. Os bytes têm que ser lidos DEPOIS disto: uma gravação
+// que chegue no meio volta o estado a STALE e a selagem é descartada em blocks_seal_end
+static int blocks_seal_begin(int block_index){
+    unsigned char stale = BLOCK_STALE;
+    return atomic_compare_exchange_strong(&fs_block_seal[block_index], &stale, BLOCK_SEALING);
+}
+
+static void blocks_seal_end(int block_index, const char* data){
+    fs_block_crc[block_index] = crc32c(0, data, FS_BLOCK_SIZE);
+    unsigned char sealing = BLOCK_SEALING;
+    atomic_compare_exchange_strong(&fs_block_seal[block_index], &sealing, BLOCK_SEALED);
+}
+
+// Confere um bloco que acabou de voltar da imagem. 0 = íntegro ou ainda sem CRC
+static int blocks_check_loaded(int block_index){
+    if (!atomic_load_explicit(&fs_checksums, memory_order_relaxed)) return 0;
+    if (atomic_load_explicit(&fs_block_seal[block_index], memory_order_acquire) != BLOCK_SEALED) return 0;
+
+    uint32_t crc = crc32c(0, &fs_disk[(size_t)block_index * FS_BLOCK_SIZE], FS_BLOCK_SIZE);
+    if (crc == fs_block_crc[block_index]) return 0;
+    atomic_fetch_add(&fs_checksum_errors, 1);
+    return -1;
+}
+
+int blocks_verify_block(int block_index){
+    if (!atomic_load(&fs_checksums) || block_index < 0 || block_index >= fs_total_blocks) return 0;
+
+    if (blocks_fetch(&block_index, 1) != 0) return -1; // Já acusado ao voltar da imagem
+
+    const char* data = &fs_disk[(size_t)block_index * FS_BLOCK_SIZE];
+    if (blocks_seal_begin(block_index)){
+        blocks_seal_end(block_index, data); // Gravado desde a última descarga: sela agora
+        return 1;
+    }
+    if (atomic_load_explicit(&fs_block_seal[block_index], memory_order_acquire) != BLOCK_SEALED) return 0;
+
+    if (crc32c(0, data, FS_BLOCK_SIZE) != fs_block_crc[block_index]){
+        atomic_fetch_add(&fs_checksum_errors, 1);
+        return -1;
+    }
+    return 0;
+}
+
+long blocks_checksum_errors(void){
+    return atomic_load(&fs_checksum_errors);
+}
+
+void blocks_set_checksums(int enabled){
+    if (enabled && !atomic_load(&fs_checksums)){
+        // Blocos gravados com a verificação desligada ficaram sem CRC atualizado
+        for (int i = 0; i < fs_total_blocks; i++){
+            if (fs_block_used[i]) atomic_store(&fs_block_seal[i], BLOCK_STALE);
+        }
+    }
+    atomic_store(&fs_checksums, enabled ? 1 : 0);
+}
+
+int blocks_checksums_enabled(void){
+    return atomic_load(&fs_checksums);
+}
+
+void blocks_lock(void){
+    pthread_mutex_lock(&fs_block_lock);
+}
+
+void blocks_unlock(void){
+    pthread_mutex_unlock(&fs_block_lock);
+}
+
+// Solta uma referência a um bloco; ao ficar livre ele sai do índice de deduplicação
+static void blocks_release(int block_index){
+    if (block_index >= 0 && block_index < fs_total_blocks && fs_block_used[block_index] > 0){
+        dedup_note_release(block_index, fs_block_used[block_index] - 1);
+        if (--fs_block_used[block_index] == 0){
+            fs_used_count--;
+            dedup_forget(block_index);
+            if (fs_block_resident){
+                blocks_ra_discard(block_index);
+                blocks_clean(block_index); // Apagado antes da descarga: nunca vai para a imagem
+            }
+            TRACE_EVENT(TRACE_BLOCK_FREE, NULL, block_index, 0);
+        }
+    }
+}
+
+// Blocos livres que não estão prometidos à alocação adiada
+static int blocks_available(void){
+    return fs_total_blocks - fs_used_count - fs_reserved;
+}
+
+int blocks_reserve_capacity(int count){
+    if (count < 0 || count > blocks_available()) return -1;
+    fs_reserved += count;
+    return 0;
+}
+
+void blocks_unreserve_capacity(int count){
+    fs_reserved -= count < fs_reserved ? count : fs_reserved;
+}
+
+static int blocks_find_free(int needed, int* out_indices){
+    int found = 0;
+    if (needed > blocks_available()) return -1;
+
+    for (int i = 0; i < fs_total_blocks && found < needed; i++){
+        if(!fs_block_used[i]){
+            out_indices[found++] = i;
+        }
+    }
+
+    return (found == needed) ? 0 : -1;
+}
+
+// Marca count blocos livres como usados e devolve seus índices
+static int blocks_take_list(int count, int* out_indices){
+    if (blocks_find_free(count, out_indices) != 0){
+        return -1; // espaço insuficiente
+    }
+
+    for (int i = 0; i < count; i++){
+        int idx = out_indices[i];
+        fs_block_used[idx] = 1;     // marca como usado
+        fs_used_count++;
+        blocks_claim(idx);
+        TRACE_EVENT(TRACE_BLOCK_ALLOC, NULL, idx, 0);
+    }
+    return 0;
+}
+
+void blocks_free_for_file(FCB* fcb){
+    if(!fcb) return;
+    delalloc_cancel(fcb); // Pendente: só devolve a capacidade reservada
+
+    if (!fcb->inlined){
+        int* map = fcb_blocks(fcb);
+        for(int i = 0; i < fcb->block_count; i++){
+            blocks_release(map[i]); // libera o bloco quando ninguém mais o referencia
+        }
+    }
+    fcb->block_count = 0;
+    fcb->compressed  = 0;
+
+    // Invalida os índices e devolve o mapa de fora do FCB. Com dados inline, o espaço
+    // deles volta a ser a lista de blocos
+    fcb_map_release(fcb);
+    fcb->inlined = 0;
+}
+
+void blocks_set_inline_threshold(size_t max_bytes){
+    fs_inline_max = max_bytes < (size_t)FCB_INLINE_MAX ? max_bytes : (size_t)FCB_INLINE_MAX;
+}
+
+size_t blocks_inline_threshold(void){
+    return fs_inline_max;
+}
+
+int blocks_inline_fits(size_t len){
+    return len > 0 && len <= fs_inline_max;
+}
+
+// Trecho só de zeros: vira buraco no mapa em vez de ocupar um bloco
+static int blocks_is_zero(const char* data, size_t len){
+    uint64_t bits = 0;
+    size_t i = 0;
+    for (; i + sizeof(bits) <= len; i += sizeof(bits)){
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        bits |= word;
+    }
+    for (; i < len; i++){
+        bits |= (unsigned char)data[i];
+    }
+    return bits == 0;
+}
+
+// Marca em present[i] os blocos de len bytes com algum dado. Retorna quantos são
+static int blocks_scan_data(const char* data, size_t len, char* present){
+    int count = 0;
+    for (size_t offset = 0, i = 0; offset < len; offset += FS_BLOCK_SIZE, i++){
+        size_t chunk = len - offset < FS_BLOCK_SIZE ? len - offset : FS_BLOCK_SIZE;
+        present[i] = !blocks_is_zero(data + offset, chunk);
+        count += present[i];
+    }
+    return count;
+}
+
+int blocks_count_data(const char* data, size_t len){
+    char present[FS_MAX_FILE_BLOCKS];
+    if (len > sizeof(present) * FS_BLOCK_SIZE) len = sizeof(present) * FS_BLOCK_SIZE;
+    return blocks_scan_data(data, len, present);
+}
+
+int blocks_allocated(const FCB* fcb){
+    if (!fcb || fcb->inlined) return 0;
+
+    const int* map = fcb_blocks(fcb);
+    int count = 0;
+    for (int i = 0; i < fcb->block_count; i++){
+        count += map[i] != FS_BLOCK_HOLE;
+    }
+    return count;
+}
+
+void blocks_retain_file(const FCB* fcb){
+    if(!fcb) return;
+
+    const int* map = fcb_blocks(fcb);
+    for(int i = 0; i < fcb->block_count; i++){
+        int block_index = map[i];
+        if(block_index >=0 && block_index < fs_total_blocks){
+            fs_block_used[block_index]++; // mais um dono (ex.: snapshot)
+        }
+    }
+}
+
+// Reserva sempre blocos de verdade (usado também para os bytes físicos de arquivos comprimidos)
+static int blocks_reserve_raw(FCB* fcb, size_t len){
+    blocks_ra_wait(); // Nenhuma leitura antecipada pode cair em um bloco que será regravado
+    blocks_free_for_file(fcb); // libera blocos existentes
+
+    if(len == 0) return 0; // nada a alocar
+
+    // Calcula quantos blocos são necessários para armazinar os dados
+    size_t blocks_needed = (len + FS_BLOCK_SIZE -1) / FS_BLOCK_SIZE;
+    if(fcb_map_reserve(fcb, (int)blocks_needed) != 0){
+        return -1; // arquivo muito grande
+    }
+
+    int* map = fcb_blocks(fcb);
+    // Procura por blocos livres e os marca como "usados" (já direto no mapa)
+    if(blocks_take_list((int)blocks_needed, map) != 0){
+        fcb_map_release(fcb);
+        return -1; // espaço insuficiente
+    }
+
+    fcb->block_count = (int)blocks_needed; // Registra quantos blocos foram alocados
+
+    // Zera só o final do último bloco; o restante será preenchido pelo chamador
+    size_t tail = len % FS_BLOCK_SIZE;
+    if (tail != 0){
+        size_t base = (size_t)map[blocks_needed - 1] * FS_BLOCK_SIZE;
+        memset(&fs_disk[base + tail], 0, FS_BLOCK_SIZE - tail);
+    }
+    return 0;
+}
+
+int blocks_reserve_for_file(FCB* fcb, size_t len){
+    if(!fcb) return -1;
+
+    if (blocks_inline_fits(len)){
+        blocks_free_for_file(fcb);
+        fcb->inlined = 1; // Cabe no próprio FCB: o alocador nem é consultado
+        return 0;
+    }
+    return blocks_reserve_raw(fcb, len);
+}
+
+// Procura um bloco livre a partir da última posição usada
+static int blocks_take_free(void){
+    static int hint = 0;
+    blocks_ra_wait();
+    if (blocks_available() < 1) return -1;
+
+    for (int n = 0; n < fs_total_blocks; n++){
+        int i = (hint + n) % fs_total_blocks;
+        if (!fs_block_used[i]){
+            fs_block_used[i] = 1;
+            fs_used_count++;
+            blocks_claim(i);
+            hint = i + 1;
+            TRACE_EVENT(TRACE_BLOCK_ALLOC, NULL, i, 0);
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Gravação com deduplicação: cada bloco igual a um já existente vira apenas mais uma referência
+static int blocks_alloc_dedup(FCB* fcb, const char* data, size_t len){
+    size_t blocks_needed = (len + FS_BLOCK_SIZE - 1) / FS_BLOCK_SIZE;
+    if ((int)blocks_needed > FS_MAX_FILE_BLOCKS){
+        return -1;
+    }
+
+    int indexes[FS_MAX_FILE_BLOCKS];
+    int written[FS_MAX_FILE_BLOCKS]; // Blocos novos, gravados na imagem no fim em um lote
+    int nwritten = 0;
+    char chunk[FS_BLOCK_SIZE];
+
+    // Os blocos antigos só são soltos no fim, para que regravar o mesmo conteúdo os reaproveite
+    for (int i = 0; i < (int)blocks_needed; i++){
+        size_t offset = (size_t)i * FS_BLOCK_SIZE;
+        size_t remaining = len - offset;
+        if (remaining >= FS_BLOCK_SIZE){
+            memcpy(chunk, data + offset, FS_BLOCK_SIZE);
+        } else {
+            memcpy(chunk, data + offset, remaining); // Último bloco completado com zeros
+            memset(chunk + remaining, 0, FS_BLOCK_SIZE - remaining);
+        }
+
+        int idx;
+        if (blocks_is_zero(chunk, FS_BLOCK_SIZE)){
+            idx = FS_BLOCK_HOLE; // Só zeros: nem o bloco compartilhado é preciso
+        } else if ((idx = dedup_lookup(chunk)) >= 0){
+            fs_block_used[idx]++;
+            dedup_note_share(idx);
+        } else {
+            idx = blocks_take_free();
+            if (idx < 0){
+                for (int j = 0; j < i; j++) blocks_release(indexes[j]);
+                return -1; // espaço insuficiente
+            }
+            memcpy(&fs_disk[(size_t)idx * FS_BLOCK_SIZE], chunk, FS_BLOCK_SIZE);
+            dedup_insert(idx);
+            written[nwritten++] = idx;
+        }
+        indexes[i] = idx;
+    }
+    if (nwritten > 0) blocks_persist(written, nwritten);
+
+    blocks_free_for_file(fcb);
+    if (fcb_map_reserve(fcb, (int)blocks_needed) != 0){
+        for (int i = 0; i < (int)blocks_needed; i++) blocks_release(indexes[i]);
+        return -1; // Sem memória para o mapa
+    }
+    memcpy(fcb_blocks(fcb), indexes, blocks_needed * sizeof(int));
+    fcb->block_count = (int)blocks_needed;
+    return 0;
+}
+
+// Grava bytes físicos nos blocos do arquivo (com ou sem deduplicação)
+static int blocks_store(FCB* fcb, const char* data, size_t len){
+    if (dedup_enabled()){
+        if (blocks_alloc_dedup(fcb, data, len) == 0){
+            return 0;
+        }
+        blocks_free_for_file(fcb); // Sem espaço: tenta de novo sem os blocos antigos
+        return blocks_alloc_dedup(fcb, data, len);
+    }
+
+    blocks_ra_wait();
+    blocks_free_for_file(fcb); // libera blocos existentes
+    if (len == 0) return 0;
+
+    size_t blocks_needed = (len + FS_BLOCK_SIZE - 1) / FS_BLOCK_SIZE;
+    if (fcb_map_reserve(fcb, (int)blocks_needed) != 0){
+        return -1; // arquivo muito grande
+    }
+
+    // Só os blocos com algum dado ocupam o disco; os de zeros viram buracos
+    int indexes[FS_MAX_FILE_BLOCKS];
+    char present[FS_MAX_FILE_BLOCKS];
+    if (blocks_take_list(blocks_scan_data(data, len, present), indexes) != 0){
+        fcb_map_release(fcb);
+        return -1;
+    }
+    int* map = fcb_blocks(fcb);
+
+    // Grava os dados do arquivo dentro dos blocos alocados
+    int next = 0;
+    for (int i = 0; i < (int)blocks_needed; i++){
+        size_t offset = (size_t)i * FS_BLOCK_SIZE;
+        size_t remaining = len - offset; // Bytes que ainda faltam escrever
+        if (remaining > FS_BLOCK_SIZE){
+            remaining = FS_BLOCK_SIZE;
+        }
+        if (!present[i]){
+            map[i] = FS_BLOCK_HOLE;
+            continue;
+        }
+
+        map[i] = indexes[next++];
+        size_t base = (size_t)map[i] * FS_BLOCK_SIZE; // Endereço do bloco
+        memcpy(&fs_disk[base], data + offset, remaining); // Preenche com os dados
+        if (remaining < FS_BLOCK_SIZE){
+            memset(&fs_disk[base + remaining], 0, FS_BLOCK_SIZE - remaining);
+        }
+    }
+    fcb->block_count = (int)blocks_needed;
+    blocks_persist_file(fcb);
+    return 0;
+}
+
+void blocks_set_compression(int enabled){
+    fs_compress = enabled ? 1 : 0;
+}
+
+int blocks_compression_enabled(void){
+    return fs_compress;
+}
+
+size_t blocks_max_file_size(void){
+    return (size_t)FS_MAX_FILE_BLOCKS * FS_BLOCK_SIZE; // Acima de FCB_MAX_CLUSTERS, sem compressão
+}
+
+static size_t blocks_round_up(size_t len){
+    return (len + FS_BLOCK_SIZE - 1) / FS_BLOCK_SIZE * FS_BLOCK_SIZE;
+}
+
+// Comprime cluster a cluster. Um cluster só fica comprimido se economizar pelo menos um bloco.
+static int blocks_alloc_compressed(FCB* fcb, const char* data, size_t len){
+    size_t clusters = (len + FS_CLUSTER_SIZE - 1) / FS_CLUSTER_SIZE;
+    if (clusters == 0 || clusters > FCB_MAX_CLUSTERS){
+        return -1;
+    }
+
+    char physical[FCB_MAX_CLUSTERS * FS_CLUSTER_SIZE];
+    unsigned short sizes[FCB_MAX_CLUSTERS];
+    size_t used = 0;
+    int any_compressed = 0;
+
+    for (size_t c = 0; c < clusters; c++){
+        size_t offset  = c * FS_CLUSTER_SIZE;
+        size_t logical = len - offset < FS_CLUSTER_SIZE ? len - offset : FS_CLUSTER_SIZE;
+        size_t raw     = blocks_round_up(logical);
+
+        // Cada cluster começa em um bloco novo: a leitura aleatória acha o cluster direto
+        size_t room = sizeof(physical) - used;
+        size_t cap  = raw - FS_BLOCK_SIZE < room ? raw - FS_BLOCK_SIZE : room;
+        size_t packed = cap > 0 ? lz_compress(data + offset, logical, physical + used, cap) : 0;
+
+        if (packed > 0){
+            sizes[c] = (unsigned short)packed;
+            any_compressed = 1;
+        } else {
+            if (raw > room) return -1; // Nem cru cabe nos blocos do FCB
+            memcpy(physical + used, data + offset, logical);
+            packed = logical;
+            sizes[c] = (unsigned short)logical;
+        }
+
+        size_t padded = blocks_round_up(packed);
+        memset(physical + used + packed, 0, padded - packed);
+        used += padded;
+    }
+
+    if (blocks_store(fcb, physical, used) != 0){
+        return -1;
+    }
+
+    // Nenhum cluster encolheu: o layout físico é o mesmo de um arquivo cru
+    if (any_compressed){
+        fcb->compressed = 1;
+        memcpy(fcb->cluster_bytes, sizes, clusters * sizeof(unsigned short));
+    }
+    return 0;
+}
+
+int blocks_alloc_for_file(FCB* fcb, const char* data, size_t len){
+    if (!fcb) return -1;
+
+    if (blocks_inline_fits(len)){
+        blocks_reserve_for_file(fcb, len);
+        memcpy(fcb->inline_data, data, len);
+        return 0;
+    }
+
+    // Arquivos maiores que FCB_MAX_CLUSTERS clusters ficam crus
+    if (fs_compress && len > 0 && len <= (size_t)FCB_MAX_CLUSTERS * FS_CLUSTER_SIZE){
+        return blocks_alloc_compressed(fcb, data, len);
+    }
+    return blocks_store(fcb, data, len);
+}
+
+int blocks_place_file(FCB* fcb, const char* data, size_t len){
+    if (!fcb) return -1;
+
+    size_t blocks_needed = (len + FS_BLOCK_SIZE - 1) / FS_BLOCK_SIZE;
+    if (blocks_inline_fits(len) || (int)blocks_needed > FS_MAX_FILE_BLOCKS){
+        return blocks_alloc_for_file(fcb, data, len);
+    }
+
+    blocks_free_for_file(fcb);
+    if (fcb_map_reserve(fcb, (int)blocks_needed) != 0) return -1;
+    char present[FS_MAX_FILE_BLOCKS];
+    int count = blocks_scan_data(data, len, present);
+    int first = count > 0 ? blocks_reserve_run(count) : 0;
+    if (first < 0){
+        return blocks_store(fcb, data, len); // Disco fragmentado: blocos soltos
+    }
+    int* map = fcb_blocks(fcb);
+
+    // Os blocos com dados ficam seguidos na faixa; os de zeros viram buracos no mapa
+    int next = first;
+    for (int i = 0; i < (int)blocks_needed; i++){
+        size_t offset = (size_t)i * FS_BLOCK_SIZE;
+        size_t chunk  = len - offset < FS_BLOCK_SIZE ? len - offset : FS_BLOCK_SIZE;
+        if (!present[i]){
+            map[i] = FS_BLOCK_HOLE;
+            continue;
+        }
+
+        char* base = &fs_disk[(size_t)next * FS_BLOCK_SIZE];
+        memcpy(base, data + offset, chunk);
+        memset(base + chunk, 0, FS_BLOCK_SIZE - chunk);
+        map[i] = next++;
+    }
+    fcb->block_count = (int)blocks_needed;
+    blocks_persist_file(fcb);
+    return 0;
+}
+
+// Zera o bloco da posição i a partir de keep bytes (novo fim no meio do bloco).
+// Um bloco compartilhado (snapshot, deduplicação) é trocado por uma cópia própria
+static int blocks_cut_block(FCB* fcb, int i, size_t keep){
+    int* map = fcb_blocks(fcb);
+    int idx = map[i];
+    if (idx < 0 || idx >= fs_total_blocks) return -1;
+
+    if (blocks_fetch(&idx, 1) != 0) return -1;
+
+    char chunk[FS_BLOCK_SIZE];
+    memcpy(chunk, &fs_disk[(size_t)idx * FS_BLOCK_SIZE], keep);
+    memset(chunk + keep, 0, FS_BLOCK_SIZE - keep);
+    if (blocks_is_zero(chunk, keep)){
+        blocks_release(idx); // Sobrou só zero: o bloco vira buraco
+        map[i] = FS_BLOCK_HOLE;
+        return 0;
+    }
+
+    if (fs_block_used[idx] > 1){
+        int own = blocks_take_free();
+        if (own < 0) return -1;
+        blocks_release(idx);
+        idx = own;
+        map[i] = own;
+    } else {
+        dedup_forget(idx); // O conteúdo muda: o índice não pode mais achá-lo
+    }
+
+    memcpy(&fs_disk[(size_t)idx * FS_BLOCK_SIZE], chunk, FS_BLOCK_SIZE);
+    blocks_unseal(idx);
+    blocks_persist(&idx, 1);
+    return 0;
+}
+
+// Regrava o arquivo inteiro com o novo tamanho (inline, comprimido ou com alocação adiada)
+static int blocks_rewrite_sized(FCB* fcb, size_t size){
+    size_t old_size = fcb->size;
+    if (old_size > blocks_max_file_size() || size > blocks_max_file_size()) return -1;
+
+    // O que passa do tamanho antigo já está zerado: o mesmo buffer serve às duas versões
+    char* data = (char*)calloc(old_size > size ? old_size : size, 1);
+    if (!data) return -1;
+    int result = -1;
+    if (blocks_read_file(fcb, 0, data, old_size) == (ssize_t)old_size){
+        result = blocks_alloc_for_file(fcb, data, size);
+        if (result != 0 && old_size > 0 && blocks_alloc_for_file(fcb, data, old_size) != 0){
+            blocks_free_for_file(fcb); // Nem a versão anterior coube
+            fcb->size = 0;
+        }
+    }
+    free(data);
+    return result;
+}
+
+int blocks_truncate_file(FCB* fcb, size_t size){
+    if (!fcb || size > blocks_max_file_size()) return -1;
+    if (size == fcb->size) return 0;
+
+    int in_place = !fcb->inlined && !fcb->compressed && !fcb->delalloc && !blocks_inline_fits(size);
+    if (size == 0){
+        blocks_free_for_file(fcb);
+    } else if (!in_place){
+        if (blocks_rewrite_sized(fcb, size) != 0) return -1;
+    } else {
+        // Só o mapa muda: blocos depois do novo fim saem e as posições novas são buracos
+        int old_count = fcb->block_count;
+        int count = (int)((size + FS_BLOCK_SIZE - 1) / FS_BLOCK_SIZE);
+        size_t keep = size % FS_BLOCK_SIZE;
+        if (fcb_map_reserve(fcb, count) != 0) return -1;
+        int* map = fcb_blocks(fcb);
+        if (size < fcb->size && keep != 0 && map[count - 1] != FS_BLOCK_HOLE &&
+            blocks_cut_block(fcb, count - 1, keep) != 0){
+            return -1;
+        }
+
+        for (int i = count; i < old_count; i++){
+            blocks_release(map[i]);
+            map[i] = FS_BLOCK_HOLE;
+        }
+        for (int i = old_count; i < count; i++){
+            map[i] = FS_BLOCK_HOLE;
+        }
+        fcb->block_count = count;
+    }
+
+    size_t old_size = fcb->size;
+    fcb->size = size;
+
+    // A cópia em memória acompanha: corta ou completa com zeros
+    if (fcb->content){
+        char* content = (char*)mem_realloc(MEM_CONTENT, fcb->content, size + 1);
+        if (!content){
+            mem_free(MEM_CONTENT, fcb->content);
+            fcb->content = NULL;
+            return 0;
+        }
+        if (size > old_size) memset(content + old_size, 0, size - old_size);
+        content[size] = '\0';
+        fcb->content = content;
+    }
+    return 0;
+}
+
+size_t blocks_physical_size(const FCB* fcb){
+    if (!fcb || fcb->inlined || fcb->delalloc) return 0;
+    if (!fcb->compressed){
+        // Buracos não ocupam nada: só os blocos alocados contam
+        const int* map = fcb_blocks(fcb);
+        size_t total = 0;
+        for (int i = 0; i < fcb->block_count; i++){
+            if (map[i] == FS_BLOCK_HOLE) continue;
+            size_t offset = (size_t)i * FS_BLOCK_SIZE;
+            if (offset < fcb->size) total += fcb->size - offset < FS_BLOCK_SIZE ? fcb->size - offset : FS_BLOCK_SIZE;
+        }
+        return total;
+    }
+
+    size_t clusters = (fcb->size + FS_CLUSTER_SIZE - 1) / FS_CLUSTER_SIZE;
+    size_t total = 0;
+    for (size_t c = 0; c < clusters; c++){
+        total += blocks_round_up(fcb->cluster_bytes[c]);
+    }
+    return total;
+}
+
+// Copia o trecho [offset, offset + len) dos bytes físicos do arquivo
+static int blocks_read_physical(const FCB* fcb, size_t offset, char* out, size_t len){
+    if (len == 0) return 0;
+
+    // Traz de uma vez os blocos que cobrem o trecho (o CRC é conferido na volta da imagem)
+    int first = (int)(offset / FS_BLOCK_SIZE);
+    int last  = (int)((offset + len - 1) / FS_BLOCK_SIZE);
+    if (last >= fcb->block_count) return -1;
+    if (blocks_fetch_file(fcb, first, last + 1) != 0) return -1;
+
+    const int* map = fcb_blocks(fcb);
+    while (len > 0){
+        int i = (int)(offset / FS_BLOCK_SIZE);
+        if (i >= fcb->block_count) return -1;
+        int idx = map[i];
+        if (idx != FS_BLOCK_HOLE && (idx < 0 || idx >= fs_total_blocks)) return -1;
+
+        size_t within = offset % FS_BLOCK_SIZE;
+        size_t chunk  = FS_BLOCK_SIZE - within < len ? FS_BLOCK_SIZE - within : len;
+        if (idx == FS_BLOCK_HOLE){
+            memset(out, 0, chunk); // Buraco: lê como zeros
+        } else {
+            memcpy(out, &fs_disk[(size_t)idx * FS_BLOCK_SIZE + within], chunk);
+        }
+        out    += chunk;
+        offset += chunk;
+        len    -= chunk;
+    }
+    return 0;
+}
+
+ssize_t blocks_read_file(const FCB* fcb, size_t offset, char* buf, size_t len){
+    if (!fcb || !buf) return -1;
+    if (offset >= fcb->size) return 0;
+    if (len > fcb->size - offset) len = fcb->size - offset;
+
+    if (fcb->inlined){
+        memcpy(buf, fcb->inline_data + offset, len);
+        return (ssize_t)len;
+    }
+    if (fcb->delalloc){
+        if (!fcb->content) return -1;
+        memcpy(buf, fcb->content + offset, len); // Ainda sem blocos: a cópia em memória vale
+        return (ssize_t)len;
+    }
+
+    if (!fcb->compressed){
+        return blocks_read_physical(fcb, offset, buf, len) == 0 ? (ssize_t)len : -1;
+    }
+
+    // Localiza o primeiro cluster pedido somando os tamanhos físicos anteriores
+    size_t first = offset / FS_CLUSTER_SIZE;
+    size_t base  = 0;
+    for (size_t c = 0; c < first; c++){
+        base += blocks_round_up(fcb->cluster_bytes[c]);
+    }
+
+    size_t done = 0;
+    for (size_t c = first; done < len && c < FCB_MAX_CLUSTERS; c++){
+        size_t logical = fcb->size - c * FS_CLUSTER_SIZE;
+        if (logical > FS_CLUSTER_SIZE) logical = FS_CLUSTER_SIZE;
+        size_t stored = fcb->cluster_bytes[c];
+
+        char packed[FS_CLUSTER_SIZE];
+        char plain[FS_CLUSTER_SIZE];
+        if (stored > FS_CLUSTER_SIZE || blocks_read_physical(fcb, base, packed, stored) != 0){
+            return -1;
+        }
+
+        const char* src = packed;
+        if (stored != logical){
+            if (lz_decompress(packed, stored, plain, logical) != (long)logical){
+                return -1; // Cluster corrompido
+            }
+            src = plain;
+        }
+
+        size_t within = (c == first) ? offset % FS_CLUSTER_SIZE : 0;
+        size_t chunk  = logical - within < len - done ? logical - within : len - done;
+        memcpy(buf + done, src + within, chunk);
+        done += chunk;
+        base += blocks_round_up(stored);
+    }
+    return (ssize_t)done;
+}
+
+int blocks_copy_file(FCB* dst, const FCB* src){
+    if (!dst || !src) return -1;
+
+    if (src->inlined){
+        blocks_free_for_file(dst);
+        memcpy(dst->inline_data, src->inline_data, src->size);
+        dst->inlined = 1;
+        return 0;
+    }
+
+    // Origem sem blocos ainda: a cópia também só reserva (o chamador copia o conteúdo)
+    if (src->delalloc){
+        return delalloc_defer(dst, src->size);
+    }
+
+    size_t physical = blocks_physical_size(src);
+    if ((size_t)src->block_count * FS_BLOCK_SIZE < physical){
+        return -1; // Origem sem blocos suficientes
+    }
+
+    // Com deduplicação a cópia só compartilha os blocos da origem
+    const int* from = fcb_blocks(src);
+    if (dedup_enabled()){
+        blocks_free_for_file(dst);
+        if (fcb_map_reserve(dst, src->block_count) != 0) return -1;
+        int* map = fcb_blocks(dst);
+        memcpy(map, from, (size_t)src->block_count * sizeof(int));
+        dst->block_count = src->block_count;
+        blocks_retain_file(dst);
+        for (int i = 0; i < dst->block_count; i++){
+            if (map[i] != FS_BLOCK_HOLE) dedup_note_share(map[i]);
+        }
+    } else {
+        blocks_ra_wait();
+        blocks_free_for_file(dst);
+        if (fcb_map_reserve(dst, src->block_count) != 0) return -1;
+        int indexes[FS_MAX_FILE_BLOCKS];
+        if (blocks_take_list(blocks_allocated(src), indexes) != 0){
+            fcb_map_release(dst);
+            return -1;
+        }
+        if (blocks_fetch_file(src, 0, src->block_count) != 0){
+            for (int i = 0; i < blocks_allocated(src); i++) blocks_release(indexes[i]);
+            fcb_map_release(dst);
+            return -1;
+        }
+
+        // Copia bloco a bloco dentro do próprio disco (clusters comprimidos seguem comprimidos
+        // e buracos seguem buracos)
+        int* map = fcb_blocks(dst);
+        int next = 0;
+        for (int i = 0; i < src->block_count; i++){
+            if (from[i] == FS_BLOCK_HOLE){
+                map[i] = FS_BLOCK_HOLE;
+                continue;
+            }
+            map[i] = indexes[next++];
+            memcpy(&fs_disk[(size_t)map[i] * FS_BLOCK_SIZE],
+                   &fs_disk[(size_t)from[i] * FS_BLOCK_SIZE], FS_BLOCK_SIZE);
+            // Mesmos bytes, mesmo CRC: se a origem ainda não tem o seu, a cópia também não. O CRC
+            // só é lido de um bloco SEALED; em SEALING a descarga ainda o está escrevendo
+            unsigned char sealed = atomic_load_explicit(&fs_block_seal[from[i]], memory_order_acquire);
+            if (sealed == BLOCK_SEALED) fs_block_crc[map[i]] = fs_block_crc[from[i]];
+            atomic_store_explicit(&fs_block_seal[map[i]],
+                                  sealed == BLOCK_SEALED ? BLOCK_SEALED : BLOCK_STALE, memory_order_release);
+        }
+        dst->block_count = src->block_count;
+        blocks_persist_file(dst);
+    }
+
+    dst->compressed = src->compressed;
+    memcpy(dst->cluster_bytes, src->cluster_bytes, sizeof(dst->cluster_bytes));
+    return 0;
+}
+
+void blocks_dedup_file(FCB* fcb){
+    if (!fcb || !dedup_enabled()) return;
+
+    int* map = fcb_blocks(fcb);
+    for (int i = 0; i < fcb->block_count; i++){
+        int idx = map[i];
+        if (idx < 0 || idx >= fs_total_blocks) continue;
+
+        int same = dedup_lookup(&fs_disk[(size_t)idx * FS_BLOCK_SIZE]);
+        if (same >= 0 && same != idx){
+            fs_block_used[same]++;
+            dedup_note_share(same);
+            blocks_release(idx); // O bloco recém-gravado volta a ficar livre
+            map[i] = same;
+        } else if (same < 0){
+            dedup_insert(idx);
+        }
+    }
+}
+
+void blocks_punch_holes(FCB* fcb){
+    if (!fcb || fcb->inlined || fcb->delalloc) return;
+
+    int* map = fcb_blocks(fcb);
+    for (int i = 0; i < fcb->block_count; i++){
+        int idx = map[i];
+        if (idx < 0 || idx >= fs_total_blocks) continue;
+        if (blocks_is_zero(&fs_disk[(size_t)idx * FS_BLOCK_SIZE], FS_BLOCK_SIZE)){
+            blocks_release(idx);
+            map[i] = FS_BLOCK_HOLE;
+        }
+    }
+}
+
+void blocks_dump_file(const FCB* fcb) {
+    if (!fcb) return;
+
+    if (fcb->inlined) {
+        printf("(dados inline no FCB)\n");
+        return;
+    }
+    if (fcb->delalloc) {
+        printf("(alocacao adiada: %zu blocos reservados)\n",
+               (fcb->size + FS_BLOCK_SIZE - 1) / FS_BLOCK_SIZE);
+        return;
+    }
+
+    const int* map = fcb_blocks(fcb);
+    printf("blocos: ");
+    for (int i = 0; i < fcb->block_count; i++) {
+        if (map[i] == FS_BLOCK_HOLE) {
+            printf("- "); // Buraco: nenhum bloco no disco
+        } else {
+            printf("%d ", map[i]); // Imprime cada bloco alocado ao arquivo
+        }
+    }
+    if (fcb->block_count == 0) {
+        printf("(nenhum bloco alocado)");
+    }
+    printf("\n");
+}
+
+int blocks_file_iov(const FCB* fcb, struct iovec* iov, int max_iov){
+    if (!fcb || !iov || max_iov <= 0) return -1;
+    if (fcb->compressed) return -1; // Os blocos não guardam os bytes do arquivo
+
+    if (fcb->inlined || fcb->delalloc){
+        if (fcb->size == 0) return 0;
+        // Dados no próprio FCB ou ainda só na cópia em memória: uma única faixa
+        const char* data = fcb->inlined ? fcb->inline_data : fcb->content;
+        if (!data) return -1;
+        iov[0].iov_base = (void*)data;
+        iov[0].iov_len  = fcb->size;
+        return 1;
+    }
+
+    size_t remaining = fcb->size;
+    if ((size_t)fcb->block_count * FS_BLOCK_SIZE < remaining){
+        return -1; // Alocação incompleta: os blocos não têm o arquivo inteiro
+    }
+
+    const int* map = fcb_blocks(fcb);
+    int count = 0;
+    for (int i = 0; i < fcb->block_count && remaining > 0; i++){
+        int idx = map[i];
+        if (idx != FS_BLOCK_HOLE && (idx < 0 || idx >= fs_total_blocks)) return -1;
+
+        // Buracos apontam para a área de zeros na mesma posição (em ciclo): buracos seguidos
+        // também se unem
+        size_t chunk = remaining < FS_BLOCK_SIZE ? remaining : FS_BLOCK_SIZE;
+        char*  base  = idx == FS_BLOCK_HOLE ? (char*)&blocks_zeros[(size_t)(i % FCB_MAX_BLOCKS) * FS_BLOCK_SIZE]
+                                            : &fs_disk[(size_t)idx * FS_BLOCK_SIZE];
+
+        // Bloco fisicamente seguido do anterior: estende a mesma faixa
+        if (count > 0 && (char*)iov[count - 1].iov_base + iov[count - 1].iov_len == base){
+            iov[count - 1].iov_len += chunk;
+        } else {
+            if (count == max_iov) return -1;
+            iov[count].iov_base = base;
+            iov[count].iov_len  = chunk;
+            count++;
+        }
+        remaining -= chunk;
+    }
+    return count;
+}
+
+// Normalmente sai em uma única chamada (no máximo BLOCKS_IOV_MAX faixas por vez); escritas
+// parciais avançam o vetor
+static ssize_t blocks_writev_all(int fd, struct iovec* iov, int count){
+    ssize_t total = 0;
+    struct iovec* cur = iov;
+    while (count > 0){
+        ssize_t written = writev(fd, cur, count < BLOCKS_IOV_MAX ? count : BLOCKS_IOV_MAX);
+        if (written < 0){
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        total += written;
+
+        while (count > 0 && (size_t)written >= cur->iov_len){
+            written -= (ssize_t)cur->iov_len;
+            cur++;
+            count--;
+        }
+        if (count > 0){
+            cur->iov_base = (char*)cur->iov_base + written;
+            cur->iov_len -= (size_t)written;
+        }
+    }
+    return total;
+}
+
+// Vetor para as faixas de um arquivo (+ extra): o local, ou um alocado para arquivos com
+// mais de FCB_MAX_BLOCKS blocos. *max_iov recebe quantas faixas do arquivo cabem
+static struct iovec* blocks_iov_for(const FCB* fcb, struct iovec* local, int extra, int* max_iov){
+    int needed = fcb && fcb->block_count > FCB_MAX_BLOCKS ? fcb->block_count : FCB_MAX_BLOCKS;
+    *max_iov = needed;
+    if (needed == FCB_MAX_BLOCKS) return local;
+    return (struct iovec*)malloc((size_t)(needed + extra) * sizeof(struct iovec));
+}
+
+static ssize_t blocks_writev_into(const FCB* fcb, int fd, const char* trailer, size_t trailer_len,
+                                  struct iovec* iov, int max_iov){
+    char plain[FCB_MAX_CLUSTERS * FS_CLUSTER_SIZE];
+    int count;
+
+    if (fcb && fcb->compressed){
+        // Descomprime para um buffer local e escreve de uma vez
+        ssize_t got = blocks_read_file(fcb, 0, plain, sizeof(plain));
+        if (got < 0 || (size_t)got != fcb->size) return -1;
+        iov[0].iov_base = plain;
+        iov[0].iov_len  = (size_t)got;
+        count = 1;
+    } else {
+        count = blocks_file_iov(fcb, iov, max_iov);
+        if (count < 0) return -1;
+        if (!fcb->inlined && !fcb->delalloc && blocks_fetch_file(fcb, 0, fcb->block_count) != 0){
+            return -1; // Bloco corrompido (errno = EIO): nada é escrito
+        }
+    }
+
+    if (trailer && trailer_len > 0){
+        iov[count].iov_base = (void*)trailer;
+        iov[count].iov_len  = trailer_len;
+        count++;
+    }
+    return blocks_writev_all(fd, iov, count);
+}
+
+ssize_t blocks_writev_file(const FCB* fcb, int fd, const char* trailer, size_t trailer_len){
+    struct iovec local[FCB_MAX_BLOCKS + 1];
+    int max_iov;
+    struct iovec* iov = blocks_iov_for(fcb, local, 1, &max_iov);
+    if (!iov) return -1;
+
+    ssize_t written = blocks_writev_into(fcb, fd, trailer, trailer_len, iov, max_iov);
+    if (iov != local) free(iov);
+    return written;
+}
+
+void blocks_stats(int* total_blocks, int* used_blocks, int* free_blocks){
+    blocks_stats_refs(total_blocks, used_blocks, free_blocks, NULL);
+}
+
+int blocks_reserved(void){
+    return fs_reserved;
+}
+
+void blocks_stats_refs(int* total_blocks, int* used_blocks, int* free_blocks, long* references){
+    if(total_blocks) { *total_blocks = fs_total_blocks; } 
+
+    int used = 0;
+    long refs = 0;
+    // Conta quantos blocos estão marcados como usados 
+    for (int i = 0; i < fs_total_blocks; i++){
+        if(fs_block_used[i]){
+            used++;
+            refs += fs_block_used[i];
+        }
+    }
+
+    if (used_blocks) { *used_blocks = used; }
+    if (references)  { *references = refs; }
+
+    // A capacidade reservada pela alocação adiada já não está livre
+    if (free_blocks) { *free_blocks = fs_total_blocks - used - fs_reserved; }
+}
+
+int blocks_reserve_run(int count){
+    if (count <= 0 || count > blocks_available()) return -1;
+    blocks_ra_wait();
+
+    // Procura a primeira sequência de 'count' blocos livres consecutivos
+    int run_start = -1;
+    int run_len   = 0;
+    for (int i = 0; i < fs_total_blocks; i++){
+        if (fs_block_used[i]){
+            run_len = 0;
+            continue;
+        }
+        if (run_len == 0) run_start = i;
+        if (++run_len == count){
+            for (int j = run_start; j < run_start + count; j++){
+                fs_block_used[j] = 1; // Marca a faixa inteira de uma vez
+                blocks_claim(j);
+            }
+            fs_used_count += count;
+            TRACE_EVENT(TRACE_BLOCK_RUN, NULL, run_start, count);
+            return run_start;
+        }
+    }
+    return -1;
+}
+
+int blocks_assign_run(FCB* fcb, int first_block, size_t len){
+    if (!fcb) return -1;
+
+    size_t blocks_needed = (len + FS_BLOCK_SIZE - 1) / FS_BLOCK_SIZE;
+    if ((int)blocks_needed > FS_MAX_FILE_BLOCKS || first_block < 0 ||
+        first_block + (int)blocks_needed > fs_total_blocks ||
+        fcb_map_reserve(fcb, (int)blocks_needed) != 0){
+        return -1;
+    }
+
+    int* map = fcb_blocks(fcb);
+    for (int i = 0; i < (int)blocks_needed; i++){
+        map[i] = first_block + i;
+    }
+    fcb->block_count = (int)blocks_needed;
+
+    size_t tail = len % FS_BLOCK_SIZE;
+    if (tail != 0){
+        size_t base = (size_t)(first_block + (int)blocks_needed - 1) * FS_BLOCK_SIZE;
+        memset(&fs_disk[base + tail], 0, FS_BLOCK_SIZE - tail);
+        blocks_unseal(first_block + (int)blocks_needed - 1);
+    }
+    return 0;
+}
+
+ssize_t blocks_readv_file(FCB* fcb, int fd){
+    struct iovec local[FCB_MAX_BLOCKS];
+    if (!fcb->inlined && !fcb->delalloc && blocks_allocated(fcb) < fcb->block_count){
+        return -1; // Os buracos apontam para a área de zeros, que não pode ser escrita
+    }
+
+    int max_iov;
+    struct iovec* iov = blocks_iov_for(fcb, local, 0, &max_iov);
+    if (!iov) return -1;
+    int count = blocks_file_iov(fcb, iov, max_iov);
+    if (count < 0){
+        if (iov != local) free(iov);
+        return -1;
+    }
+
+    ssize_t total = 0;
+    struct iovec* cur = iov;
+    while (count > 0){
+        ssize_t got = readv(fd, cur, count < BLOCKS_IOV_MAX ? count : BLOCKS_IOV_MAX);
+        if (got < 0){
+            if (errno == EINTR) continue;
+            if (iov != local) free(iov);
+            return -1;
+        }
+        if (got == 0){
+            break; // A origem terminou antes do esperado
+        }
+        total += got;
+
+        while (count > 0 && (size_t)got >= cur->iov_len){
+            got -= (ssize_t)cur->iov_len;
+            cur++;
+            count--;
+        }
+        if (count > 0){
+            cur->iov_base = (char*)cur->iov_base + got;
+            cur->iov_len -= (size_t)got;
+        }
+    }
+
+    // Se a origem encolheu no meio da leitura, zera o que não foi preenchido
+    while (count > 0){
+        memset(cur->iov_base, 0, cur->iov_len);
+        cur++;
+        count--;
+    }
+    if (iov != local) free(iov);
+    blocks_unseal_file(fcb);
+    blocks_persist_file(fcb);
+    return total;
+}
+
+int blocks_load_run(int first_block, int count, int fd, off_t offset, uint32_t* crc){
+    if (first_block < 0 || count < 0 || first_block + count > fs_total_blocks){
+        errno = EINVAL;
+        return -1;
+    }
+
+    char* base = &fs_disk[(size_t)first_block * FS_BLOCK_SIZE];
+    size_t len = (size_t)count * FS_BLOCK_SIZE;
+    size_t done = 0;
+    while (done < len){
+        ssize_t got = pread(fd, base + done, len - done, offset + (off_t)done);
+        if (got < 0){
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (got == 0){
+            errno = EIO; // A origem terminou antes da área de blocos
+            return -1;
+        }
+        done += (size_t)got;
+    }
+    if (crc) *crc = crc32c(0, base, len);
+
+    // A faixa foi reservada sem CRC (ele fica para a descarga ou o scrub) e, com imagem,
+    // os blocos vão para a descarga em lotes
+    int indices[WB_BATCH];
+    for (int start = first_block; start < first_block + count; start += WB_BATCH){
+        int n = first_block + count - start < WB_BATCH ? first_block + count - start : WB_BATCH;
+        for (int i = 0; i < n; i++) indices[i] = start + i;
+        blocks_persist(indices, n);
+    }
+    return 0;
+}
@@ -0,0 +1,840 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include "fs.h"
+#include "fs_helpers.h"
+#include "fcb_helpers.h"
+#include "fs_name.h"
+#include "blocks.h"
+#include "delalloc.h"
+#include "fs_time.h"
+#include "fs_usage.h"
+#include "fs_walk.h"
+#include "crc32c.h"
+#include "thread_pool.h"
+#include "checkpoint.h"
+
+#define CHECKPOINT_MAGIC   "MINIFSCK"
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_STAGE   (256 * 1024)   // Buffer de saída da área de blocos
+
+// Inteiros de 64 bits do cabeçalho, nesta ordem
+enum {
+    HDR_VERSION,
+    HDR_NODES,
+    HDR_CHUNK_NODES,
+    HDR_TABLE_BYTES,
+    HDR_BLOCKS,
+    HDR_INODE_HIGH,
+    HDR_USER_QUOTAS    // (blocos, inodes) de cada classe de usuário
+};
+#define CHECKPOINT_FIELDS (HDR_USER_QUOTAS + 2 * (USER_OTHER + 1))
+// Assinatura, campos e os CRCs da tabela e da área de blocos
+#define CHECKPOINT_HEADER (8 + CHECKPOINT_FIELDS * 8 + 2 * 4)
+
+// Bits de tipo de um registro de nó
+#define NODE_REC_FILE       1
+#define NODE_REC_INLINE     2
+#define NODE_REC_COMPRESSED 4
+
+
+// Buffer de saída que cresce sob demanda
+typedef struct {
+    unsigned char* data;
+    size_t len;
+    size_t cap;
+    int    failed;
+} CkptBuf;
+
+// Leitura com limites de um trecho da tabela
+typedef struct {
+    const unsigned char* p;
+    const unsigned char* end;
+    int failed;
+} CkptReader;
+
+// Blocos do disco na ordem em que aparecem nos FCBs (gravação)
+typedef struct {
+    int* remap;       // Bloco do disco -> posição na área (-1 = ainda não visto)
+    int* order;       // Posição na área -> bloco do disco
+    int* refs;        // Referências de cada posição
+    int  count;
+    int  total;
+} CkptBlockMap;
+
+// Estado da restauração compartilhado pelas tarefas
+typedef struct {
+    FsNode** nodes;   // Nó de cada posição da tabela
+    size_t*  parents; // Posição do pai
+    int      first_block;
+    uint64_t blocks;
+} CkptRestore;
+
+// Uma fatia da tabela de nós, decodificada por uma tarefa
+typedef struct {
+    CkptRestore* ctx;
+    const unsigned char* start;
+    const unsigned char* end;
+    size_t bytes;     // Tamanho da fatia na tabela
+    size_t first;
+    size_t count;
+    long   dirs;
+    long   files;
+    long   refs;      // Entradas de bloco nos FCBs da fatia
+    int    failed;
+} CkptChunk;
+
+
+static double ckpt_now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned char* ckpt_room(CkptBuf* buf, size_t extra){
+    if (buf->failed) return NULL;
+    if (buf->len + extra > buf->cap){
+        size_t cap = buf->cap ? buf->cap : 64 * 1024;
+        while (cap < buf->len + extra) cap *= 2;
+
+        unsigned char* grown = (unsigned char*)realloc(buf->data, cap);
+        if (!grown){
+            buf->failed = 1;
+            return NULL;
+        }
+        buf->data = grown;
+        buf->cap = cap;
+    }
+    return buf->data + buf->len;
+}
+
+// Varint: 7 bits por byte, o bit alto indica que há mais bytes
+static void ckpt_put_u(CkptBuf* buf, uint64_t value){
+    unsigned char* p = ckpt_room(buf, 10);
+    if (!p) return;
+
+    unsigned char* start = p;
+    while (value >= 0x80){
+        *p++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = (unsigned char)value;
+    buf->len += (size_t)(p - start);
+}
+
+// Inteiro com sinal em zigzag: valores pequenos, positivos ou negativos, ocupam poucos bytes
+static void ckpt_put_s(CkptBuf* buf, int64_t value){
+    ckpt_put_u(buf, value < 0 ? ~((uint64_t)value << 1) : (uint64_t)value << 1);
+}
+
+static void ckpt_put_bytes(CkptBuf* buf, const void* data, size_t len){
+    unsigned char* p = ckpt_room(buf, len);
+    if (!p) return;
+    memcpy(p, data, len);
+    buf->len += len;
+}
+
+static uint64_t ckpt_get_u(CkptReader* r){
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64 && r->p < r->end; shift += 7){
+        unsigned char byte = *r->p++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    r->failed = 1;
+    return 0;
+}
+
+// Varint que não pode passar de max (checkpoint corrompido)
+static uint64_t ckpt_get_max(CkptReader* r, uint64_t max){
+    uint64_t value = ckpt_get_u(r);
+    if (value > max) r->failed = 1;
+    return value;
+}
+
+static int64_t ckpt_get_s(CkptReader* r){
+    uint64_t value = ckpt_get_u(r);
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static const unsigned char* ckpt_get_bytes(CkptReader* r, size_t len){
+    if (r->failed || (size_t)(r->end - r->p) < len){
+        r->failed = 1;
+        return NULL;
+    }
+    const unsigned char* p = r->p;
+    r->p += len;
+    return p;
+}
+
+static void ckpt_put_le(unsigned char* p, uint64_t value, int bytes){
+    for (int i = 0; i < bytes; i++) p[i] = (unsigned char)(value >> (8 * i));
+}
+
+static uint64_t ckpt_get_le(const unsigned char* p, int bytes){
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) value |= (uint64_t)p[i] << (8 * i);
+    return value;
+}
+
+static int ckpt_write_all(int fd, const void* data, size_t len){
+    const char* p = (const char*)data;
+    while (len > 0){
+        ssize_t written = write(fd, p, len);
+        if (written < 0){
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += written;
+        len -= (size_t)written;
+    }
+    return 0;
+}
+
+static int ckpt_read_at(int fd, void* data, size_t len, off_t offset){
+    char* p = (char*)data;
+    while (len > 0){
+        ssize_t got = pread(fd, p, len, offset);
+        if (got < 0){
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (got == 0){
+            errno = EBADMSG; // Arquivo menor que o cabeçalho promete
+            return -1;
+        }
+        p += got;
+        len -= (size_t)got;
+        offset += got;
+    }
+    return 0;
+}
+
+
+// ---------------------------------------------------------------------------
+// Gravação
+
+static void ckpt_put_fcb(CkptBuf* out, const FCB* fcb, CkptBlockMap* map){
+    ckpt_put_u(out, fcb->size);
+    ckpt_put_u(out, (uint64_t)fcb->type);
+    // Os horários costumam estar próximos: só a criação vai inteira
+    ckpt_put_s(out, (int64_t)fcb->created_at);
+    ckpt_put_s(out, (int64_t)fcb->modified_at - (int64_t)fcb->created_at);
+    ckpt_put_s(out, (int64_t)fcb->accessed_at - (int64_t)fcb->modified_at);
+    ckpt_put_u(out, (uint64_t)fcb->inode);
+    ckpt_put_u(out, fcb->permissions & 0777);
+    ckpt_put_u(out, (uint64_t)fcb->owner);
+
+    if (fcb->inlined){
+        ckpt_put_bytes(out, fcb->inline_data, fcb->size);
+        return;
+    }
+
+    // Blocos pela posição na área (+1; 0 = buraco)
+    ckpt_put_u(out, (uint64_t)fcb->block_count);
+    const int* blocks = fcb_blocks(fcb);
+    for (int i = 0; i < fcb->block_count; i++){
+        int block = blocks[i];
+        if (block < 0 || block >= map->total){
+            ckpt_put_u(out, 0); // Buraco (ou índice inválido, que vira buraco como no fsck -r)
+            continue;
+        }
+        if (map->remap[block] < 0){
+            map->remap[block] = map->count;
+            map->order[map->count++] = block;
+        }
+        map->refs[map->remap[block]]++;
+        ckpt_put_u(out, (uint64_t)map->remap[block] + 1);
+    }
+
+    if (fcb->compressed){
+        size_t clusters = (fcb->size + FS_CLUSTER_SIZE - 1) / FS_CLUSTER_SIZE;
+        for (size_t c = 0; c < clusters && c < FCB_MAX_CLUSTERS; c++){
+            ckpt_put_u(out, fcb->cluster_bytes[c]);
+        }
+    }
+}
+
+static void ckpt_put_node(CkptBuf* out, const FsNode* node, uint64_t parent_delta, CkptBlockMap* map){
+    const FCB* fcb = node->type == NODE_FILE ? node->fcb : NULL;
+    unsigned int flags = 0;
+    if (node->type == NODE_FILE){
+        flags = NODE_REC_FILE;
+        if (fcb && fcb->inlined)    flags |= NODE_REC_INLINE;
+        if (fcb && fcb->compressed) flags |= NODE_REC_COMPRESSED;
+    }
+
+    ckpt_put_u(out, parent_delta);
+    ckpt_put_u(out, flags);
+    size_t name_len = strlen(node->name);
+    ckpt_put_u(out, name_len);
+    ckpt_put_bytes(out, node->name, name_len);
+
+    if (node->type == NODE_DIR){
+        ckpt_put_u(out, node->usage ? (uint64_t)node->usage->max_blocks : 0);
+        ckpt_put_u(out, node->usage ? (uint64_t)node->usage->max_inodes : 0);
+        return;
+    }
+
+    if (!fcb){
+        FCB empty;
+        memset(&empty, 0, sizeof(empty));
+        empty.permissions = 0644;
+        ckpt_put_fcb(out, &empty, map);
+        return;
+    }
+    ckpt_put_fcb(out, fcb, map);
+}
+
+// Monta a tabela (fatias, nós e mapa de blocos) em memória
+static int ckpt_encode(CkptBuf* chunks, CkptBuf* nodes, CkptBuf* refs, CkptBlockMap* map,
+                       uint64_t* node_count, CheckpointStats* stats){
+    size_t* path = NULL;    // Posição de cada ancestral do nó atual, por profundidade
+    size_t path_cap = 0;
+    size_t chunk_start = 0;
+    uint64_t count = 0;
+
+    FsWalk walk;
+    fs_walk_begin(&walk, fs_root, FS_WALK_PREORDER);
+    FsNode* node;
+    while ((node = fs_walk_next(&walk)) != NULL){
+        size_t depth = (size_t)fs_walk_depth(&walk);
+        if (depth >= path_cap){
+            size_t cap = path_cap ? path_cap * 2 : 64;
+            size_t* grown = (size_t*)realloc(path, cap * sizeof(size_t));
+            if (!grown){
+                free(path);
+                errno = ENOMEM;
+                return -1;
+            }
+            path = grown;
+            path_cap = cap;
+        }
+        path[depth] = (size_t)count;
+
+        if (count > 0 && count % CHECKPOINT_CHUNK_NODES == 0){
+            ckpt_put_u(chunks, nodes->len - chunk_start);
+            chunk_start = nodes->len;
+        }
+        ckpt_put_node(nodes, node, depth > 0 ? count - path[depth - 1] : 0, map);
+
+        if (node->type == NODE_FILE){
+            stats->files++;
+        } else if (depth > 0){
+            stats->dirs++;
+        }
+        count++;
+    }
+    free(path);
+    ckpt_put_u(chunks, nodes->len - chunk_start);
+
+    for (int i = 0; i < map->count; i++){
+        ckpt_put_u(refs, (uint64_t)map->refs[i]);
+    }
+
+    *node_count = count;
+    if (chunks->failed || nodes->failed || refs->failed){
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+// Grava cabeçalho provisório, tabela e área de blocos; o cabeçalho final leva o CRC dos blocos
+static int ckpt_write(int fd, unsigned char* header, const CkptBuf* parts[3], const CkptBlockMap* map){
+    if (ckpt_write_all(fd, header, CHECKPOINT_HEADER) != 0) return -1;
+    for (int i = 0; i < 3; i++){
+        if (ckpt_write_all(fd, parts[i]->data, parts[i]->len) != 0) return -1;
+    }
+
+    char* stage = (char*)malloc(CHECKPOINT_STAGE);
+    if (!stage){
+        errno = ENOMEM;
+        return -1;
+    }
+    uint32_t crc = 0;
+    size_t staged = 0;
+    int result = 0;
+    for (int i = 0; i <= map->count && result == 0; i++){
+        if (staged == CHECKPOINT_STAGE || (i == map->count && staged > 0)){
+            crc = crc32c(crc, stage, staged);
+            result = ckpt_write_all(fd, stage, staged);
+            staged = 0;
+        }
+        if (i == map->count) break;
+        memcpy(stage + staged, blocks_data(map->order[i]), FS_BLOCK_SIZE);
+        staged += FS_BLOCK_SIZE;
+    }
+    free(stage);
+    if (result != 0) return -1;
+
+    ckpt_put_le(header + CHECKPOINT_HEADER - 4, crc, 4);
+    if (pwrite(fd, header, CHECKPOINT_HEADER, 0) != CHECKPOINT_HEADER) return -1;
+    return 0;
+}
+
+int checkpoint_save(const char* path, CheckpointStats* stats){
+    CheckpointStats local;
+    memset(&local, 0, sizeof(local));
+    if (stats) memset(stats, 0, sizeof(*stats));
+    if (!path || !fs_root){
+        errno = EINVAL;
+        return -1;
+    }
+    double start = ckpt_now();
+
+    // Acessos pendentes vão para os FCBs e os arquivos adiados recebem blocos
+    fs_time_flush();
+    delalloc_flush();
+    int pending = 0;
+    delalloc_stats(&pending, NULL, NULL, NULL);
+    if (pending > 0){
+        errno = ENOSPC;
+        return -1;
+    }
+
+    CkptBlockMap map;
+    memset(&map, 0, sizeof(map));
+    map.total = blocks_total();
+    blocks_fetch_range(0, map.total); // Com imagem, os blocos vêm para a memória em lotes
+    size_t slots = map.total > 0 ? (size_t)map.total : 1;
+    map.remap = (int*)malloc(slots * sizeof(int));
+    map.order = (int*)malloc(slots * sizeof(int));
+    map.refs  = (int*)calloc(slots, sizeof(int));
+
+    CkptBuf chunks, nodes, refs;
+    memset(&chunks, 0, sizeof(chunks));
+    memset(&nodes, 0, sizeof(nodes));
+    memset(&refs, 0, sizeof(refs));
+
+    uint64_t node_count = 0;
+    int result = -1;
+    if (!map.remap || !map.order || !map.refs){
+        errno = ENOMEM;
+    } else {
+        memset(map.remap, 0xff, slots * sizeof(int));
+        result = ckpt_encode(&chunks, &nodes, &refs, &map, &node_count, &local);
+    }
+
+    if (result == 0){
+        uint64_t fields[CHECKPOINT_FIELDS];
+        memset(fields, 0, sizeof(fields));
+        fields[HDR_VERSION]     = CHECKPOINT_VERSION;
+        fields[HDR_NODES]       = node_count;
+        fields[HDR_CHUNK_NODES] = CHECKPOINT_CHUNK_NODES;
+        fields[HDR_TABLE_BYTES] = chunks.len + nodes.len + refs.len;
+        fields[HDR_BLOCKS]      = (uint64_t)map.count;
+        fields[HDR_INODE_HIGH]  = (uint64_t)fcb_inode_high_water();
+        for (int u = USER_OWNER; u <= USER_OTHER; u++){
+            FsUsage usage;
+            fs_usage_user((UserClass)u, &usage);
+            fields[HDR_USER_QUOTAS + 2 * u]     = (uint64_t)usage.max_blocks;
+            fields[HDR_USER_QUOTAS + 2 * u + 1] = (uint64_t)usage.max_inodes;
+        }
+
+        unsigned char header[CHECKPOINT_HEADER];
+        memcpy(header, CHECKPOINT_MAGIC, 8);
+        for (int i = 0; i < CHECKPOINT_FIELDS; i++){
+            ckpt_put_le(header + 8 + i * 8, fields[i], 8);
+        }
+        uint32_t table_crc = crc32c(0, chunks.data, chunks.len);
+        table_crc = crc32c(table_crc, nodes.data, nodes.len);
+        table_crc = crc32c(table_crc, refs.data, refs.len);
+        ckpt_put_le(header + 8 + CHECKPOINT_FIELDS * 8, table_crc, 4);
+        ckpt_put_le(header + 8 + CHECKPOINT_FIELDS * 8 + 4, 0, 4);
+
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0){
+            result = -1;
+        } else {
+            const CkptBuf* parts[3] = { &chunks, &nodes, &refs };
+            result = ckpt_write(fd, header, parts, &map);
+            int saved = errno;
+            if (close(fd) != 0 && result == 0){
+                saved = errno;
+                result = -1;
+            }
+            errno = saved;
+        }
+        local.blocks = map.count;
+        local.bytes  = CHECKPOINT_HEADER + (size_t)fields[HDR_TABLE_BYTES] + (size_t)map.count * FS_BLOCK_SIZE;
+    }
+
+    int saved = errno;
+    free(chunks.data);
+    free(nodes.data);
+    free(refs.data);
+    free(map.remap);
+    free(map.order);
+    free(map.refs);
+    errno = saved;
+
+    local.seconds = ckpt_now() - start;
+    if (stats && result == 0) *stats = local;
+    return result;
+}
+
+
+// ---------------------------------------------------------------------------
+// Restauração
+
+static int ckpt_get_fcb(CkptReader* r, FCB* fcb, unsigned int flags, const CkptRestore* ctx, long* refs){
+    fcb->size = (size_t)ckpt_get_max(r, (uint64_t)FS_MAX_FILE_BLOCKS * FS_BLOCK_SIZE);
+    fcb->type = (FileType)ckpt_get_max(r, FILETYPE_PROGRAM);
+    int64_t created  = ckpt_get_s(r);
+    int64_t modified = created + ckpt_get_s(r);
+    int64_t accessed = modified + ckpt_get_s(r);
+    fcb->created_at  = (time_t)created;
+    fcb->modified_at = (time_t)modified;
+    fcb->accessed_at = (time_t)accessed;
+    fcb->inode       = (int)ckpt_get_max(r, INT_MAX);
+    fcb->permissions = (unsigned int)ckpt_get_max(r, 0777);
+    fcb->owner       = (UserClass)ckpt_get_max(r, USER_OTHER);
+    if (r->failed) return -1;
+
+    if (flags & NODE_REC_INLINE){
+        if ((flags & NODE_REC_COMPRESSED) || fcb->size > FCB_INLINE_MAX) return -1;
+        const unsigned char* data = ckpt_get_bytes(r, fcb->size);
+        if (!data) return -1;
+        memset(fcb->inline_data, 0, FCB_INLINE_MAX);
+        memcpy(fcb->inline_data, data, fcb->size);
+        fcb->inlined = 1;
+        return 0;
+    }
+
+    int count = (int)ckpt_get_max(r, FS_MAX_FILE_BLOCKS);
+    if (r->failed || fcb_map_reserve(fcb, count) != 0) return -1;
+    int* blocks = fcb_blocks(fcb);
+    for (int i = 0; i < count && !r->failed; i++){
+        uint64_t entry = ckpt_get_max(r, ctx->blocks);
+        blocks[i] = entry ? ctx->first_block + (int)(entry - 1) : FS_BLOCK_HOLE;
+        *refs += entry != 0;
+    }
+    fcb->block_count = r->failed ? 0 : count;
+
+    if (flags & NODE_REC_COMPRESSED){
+        size_t clusters = (fcb->size + FS_CLUSTER_SIZE - 1) / FS_CLUSTER_SIZE;
+        if (clusters > FCB_MAX_CLUSTERS) return -1;
+        for (size_t c = 0; c < clusters; c++){
+            fcb->cluster_bytes[c] = (unsigned short)ckpt_get_max(r, FS_CLUSTER_SIZE);
+        }
+        fcb->compressed = 1;
+    }
+    return r->failed ? -1 : 0;
+}
+
+// Recria os nós de uma fatia, ainda soltos: o encadeamento acontece depois de todas as fatias
+static void ckpt_restore_chunk(void* arg){
+    CkptChunk* chunk = (CkptChunk*)arg;
+    CkptRestore* ctx = chunk->ctx;
+    CkptReader r = { chunk->start, chunk->end, 0 };
+
+    for (size_t i = chunk->first; i < chunk->first + chunk->count && !r.failed; i++){
+        uint64_t delta = ckpt_get_max(&r, i);
+        unsigned int flags = (unsigned int)ckpt_get_max(&r, NODE_REC_FILE | NODE_REC_INLINE | NODE_REC_COMPRESSED);
+        size_t name_len = (size_t)ckpt_get_max(&r, MAX_NAME_LEN - 1);
+        const unsigned char* name_bytes = ckpt_get_bytes(&r, name_len);
+        if (r.failed) break;
+
+        // Só a raíz (posição 0) não tem pai; ela já existe e só recebe a cota
+        if ((i == 0) != (delta == 0) || (i == 0 && flags != 0)){
+            r.failed = 1;
+            break;
+        }
+        ctx->parents[i] = i - (size_t)delta;
+
+        long max_blocks = 0, max_inodes = 0;
+        if (!(flags & NODE_REC_FILE)){
+            if (flags != 0){
+                r.failed = 1;
+                break;
+            }
+            max_blocks = (long)ckpt_get_max(&r, LONG_MAX);
+            max_inodes = (long)ckpt_get_max(&r, LONG_MAX);
+            if (r.failed) break;
+            if (i == 0){
+                fs_usage_set_quota(fs_root, max_blocks, max_inodes);
+                ctx->nodes[0] = fs_root;
+                continue;
+            }
+        }
+
+        char name[MAX_NAME_LEN];
+        memcpy(name, name_bytes, name_len);
+        name[name_len] = '\0';
+        if (name_len == 0 || strlen(name) != name_len || strchr(name, '/') ||
+            strcmp(name, ".") == 0 || strcmp(name, "..") == 0){
+            r.failed = 1;
+            break;
+        }
+
+        if (!(flags & NODE_REC_FILE)){
+            FsNode* dir = fs_create_node(name, NODE_DIR, NULL);
+            fs_usage_set_quota(dir, max_blocks, max_inodes);
+            ctx->nodes[i] = dir;
+            chunk->dirs++;
+            continue;
+        }
+
+        FsNode* node = fs_create_node(name, NODE_FILE, NULL);
+        node->fcb = create_fcb_interned(node->name, FILETYPE_BINARY);
+        ctx->nodes[i] = node;
+        if (ckpt_get_fcb(&r, node->fcb, flags, ctx, &chunk->refs) != 0){
+            r.failed = 1;
+            break;
+        }
+        chunk->files++;
+    }
+
+    if (!r.failed && r.p != r.end) r.failed = 1; // Sobrou ou faltou registro na fatia
+    chunk->failed = r.failed;
+}
+
+// Nós recriados de uma restauração que falhou: nada chegou à árvore, então os blocos
+// voltam de uma vez pela faixa inteira
+static void ckpt_discard(CkptRestore* ctx, uint64_t node_count){
+    for (uint64_t i = 1; i < node_count; i++){
+        FsNode* node = ctx->nodes[i];
+        if (!node) continue;
+        if (node->fcb) node->fcb->block_count = 0;
+        fs_free_node(node);
+    }
+    for (uint64_t k = 0; k < ctx->blocks; k++){
+        blocks_set_refcount(ctx->first_block + (int)k, 0);
+    }
+}
+
+// Confere o mapa de blocos contra as entradas dos FCBs e aplica as referências
+static int ckpt_apply_refs(CkptReader* r, const CkptRestore* ctx, long refs){
+    CkptReader check = *r;
+    long total = 0;
+    for (uint64_t k = 0; k < ctx->blocks && !check.failed; k++){
+        uint64_t count = ckpt_get_max(&check, INT_MAX);
+        if (count == 0) check.failed = 1;
+        total += (long)count;
+    }
+    if (check.failed || check.p != check.end || total != refs) return -1;
+
+    // A faixa reservada já vale 1 por bloco: só os compartilhados mudam
+    for (uint64_t k = 0; k < ctx->blocks; k++){
+        int count = (int)ckpt_get_u(r);
+        if (count != 1) blocks_set_refcount(ctx->first_block + (int)k, count);
+    }
+    return 0;
+}
+
+// Encadeia os nós: o pai sempre vem antes na tabela e os irmãos saem na ordem gravada
+static int ckpt_link(CkptRestore* ctx, uint64_t node_count){
+    for (uint64_t i = 1; i < node_count; i++){
+        if (ctx->nodes[ctx->parents[i]]->type != NODE_DIR) return -1;
+    }
+
+    FsNode** tails = (FsNode**)calloc((size_t)node_count, sizeof(FsNode*));
+    if (!tails) return -1;
+    for (uint64_t i = 1; i < node_count; i++){
+        size_t p = ctx->parents[i];
+        FsNode* node = ctx->nodes[i];
+        node->parent = ctx->nodes[p];
+        if (tails[p]){
+            tails[p]->next_sibling = node;
+        } else {
+            ctx->nodes[p]->first_child = node;
+        }
+        tails[p] = node;
+    }
+    free(tails);
+    return 0;
+}
+
+static int ckpt_restore_fd(int fd, int threads, CheckpointStats* stats){
+    unsigned char header[CHECKPOINT_HEADER];
+    if (ckpt_read_at(fd, header, CHECKPOINT_HEADER, 0) != 0) return -1;
+
+    uint64_t fields[CHECKPOINT_FIELDS];
+    for (int i = 0; i < CHECKPOINT_FIELDS; i++){
+        fields[i] = ckpt_get_le(header + 8 + i * 8, 8);
+    }
+    uint32_t table_crc  = (uint32_t)ckpt_get_le(header + 8 + CHECKPOINT_FIELDS * 8, 4);
+    uint32_t blocks_crc = (uint32_t)ckpt_get_le(header + 8 + CHECKPOINT_FIELDS * 8 + 4, 4);
+
+    // O tamanho do arquivo precisa bater com o que o cabeçalho descreve
+    struct stat st;
+    if (fstat(fd, &st) != 0) return -1;
+    uint64_t node_count  = fields[HDR_NODES];
+    uint64_t chunk_nodes = fields[HDR_CHUNK_NODES];
+    uint64_t table_bytes = fields[HDR_TABLE_BYTES];
+    uint64_t blocks      = fields[HDR_BLOCKS];
+    if (memcmp(header, CHECKPOINT_MAGIC, 8) != 0 || fields[HDR_VERSION] != CHECKPOINT_VERSION ||
+        node_count == 0 || node_count > (uint64_t)INT_MAX || chunk_nodes == 0 ||
+        blocks > (uint64_t)(INT_MAX - blocks_total()) || fields[HDR_INODE_HIGH] > (uint64_t)INT_MAX ||
+        table_bytes > (uint64_t)st.st_size || node_count > table_bytes ||
+        (uint64_t)st.st_size != CHECKPOINT_HEADER + table_bytes + blocks * FS_BLOCK_SIZE){
+        errno = EBADMSG;
+        return -1;
+    }
+    stats->bytes = (size_t)st.st_size;
+
+    unsigned char* table = (unsigned char*)malloc(table_bytes ? (size_t)table_bytes : 1);
+    if (!table){
+        errno = ENOMEM;
+        return -1;
+    }
+    if (ckpt_read_at(fd, table, (size_t)table_bytes, CHECKPOINT_HEADER) != 0){
+        free(table);
+        return -1;
+    }
+    if (crc32c(0, table, (size_t)table_bytes) != table_crc){
+        free(table);
+        errno = EBADMSG;
+        return -1;
+    }
+
+    // Onde começa cada fatia: os tamanhos vêm antes dos registros
+    size_t chunk_count = (size_t)((node_count + chunk_nodes - 1) / chunk_nodes);
+    CkptRestore ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.blocks   = blocks;
+    ctx.nodes    = (FsNode**)calloc((size_t)node_count, sizeof(FsNode*));
+    ctx.parents  = (size_t*)malloc((size_t)node_count * sizeof(size_t));
+    CkptChunk* chunks = (CkptChunk*)calloc(chunk_count, sizeof(CkptChunk));
+    if (!ctx.nodes || !ctx.parents || !chunks){
+        free(ctx.nodes);
+        free(ctx.parents);
+        free(chunks);
+        free(table);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    CkptReader r = { table, table + table_bytes, 0 };
+    uint64_t lengths = 0;
+    for (size_t c = 0; c < chunk_count && !r.failed; c++){
+        chunks[c].bytes = (size_t)ckpt_get_max(&r, table_bytes);
+        lengths += chunks[c].bytes;
+    }
+    int result = 0;
+    if (r.failed || lengths > (uint64_t)(r.end - r.p)){
+        errno = EBADMSG;
+        result = -1;
+    }
+
+    const unsigned char* records = r.p;
+    for (size_t c = 0; c < chunk_count && result == 0; c++){
+        chunks[c].ctx   = &ctx;
+        chunks[c].start = records;
+        chunks[c].end   = records + chunks[c].bytes;
+        chunks[c].first = c * (size_t)chunk_nodes;
+        chunks[c].count = c + 1 < chunk_count ? (size_t)chunk_nodes
+                                              : (size_t)(node_count - chunks[c].first);
+        records += chunks[c].bytes;
+    }
+
+    // Uma única faixa para todos os blocos, como no --build
+    ctx.first_block = -1;
+    if (result == 0 && blocks > 0){
+        ctx.first_block = blocks_reserve_run((int)blocks);
+        if (ctx.first_block < 0 && blocks_resize(blocks_total() + (int)blocks) == 0){
+            ctx.first_block = blocks_reserve_run((int)blocks);
+        }
+        if (ctx.first_block < 0){
+            errno = ENOMEM;
+            result = -1;
+        }
+    }
+
+    if (result == 0){
+        fs_name_reserve((long)node_count); // A tabela de nomes não cresce aos poucos durante as fatias
+
+        // As fatias são recriadas no pool enquanto esta thread lê a área de blocos
+        ThreadPool* pool = tp_create(threads);
+        for (size_t c = 0; c < chunk_count; c++){
+            if (!pool || tp_submit(pool, ckpt_restore_chunk, &chunks[c]) != 0){
+                ckpt_restore_chunk(&chunks[c]);
+            }
+        }
+
+        uint32_t crc = 0;
+        int loaded = blocks == 0 ? 0 : blocks_load_run(ctx.first_block, (int)blocks, fd,
+                                                       (off_t)(CHECKPOINT_HEADER + table_bytes), &crc);
+        int saved = errno;
+        if (pool){
+            tp_wait(pool);
+            tp_destroy(pool);
+        }
+
+        long refs = 0;
+        for (size_t c = 0; c < chunk_count; c++){
+            if (chunks[c].failed) result = -1;
+            refs         += chunks[c].refs;
+            stats->dirs  += chunks[c].dirs;
+            stats->files += chunks[c].files;
+        }
+
+        CkptReader map = { records, table + table_bytes, 0 };
+        if (loaded != 0){
+            errno = saved;
+            result = -1;
+        } else if (result != 0 || crc != blocks_crc || ckpt_apply_refs(&map, &ctx, refs) != 0 ||
+                   ckpt_link(&ctx, node_count) != 0){
+            errno = EBADMSG;
+            result = -1;
+        }
+
+        if (result != 0){
+            saved = errno;
+            ckpt_discard(&ctx, node_count);
+            fs_usage_set_quota(fs_root, 0, 0);
+            errno = saved;
+        }
+    }
+
+    if (result == 0){
+        for (int u = USER_OWNER; u <= USER_OTHER; u++){
+            fs_usage_set_user_quota((UserClass)u, (long)fields[HDR_USER_QUOTAS + 2 * u],
+                                    (long)fields[HDR_USER_QUOTAS + 2 * u + 1]);
+        }
+        fcb_reserve_inodes((int)fields[HDR_INODE_HIGH]);
+        fs_usage_rebuild(fs_root); // Totais dos diretórios em uma passada
+        stats->blocks = (long)blocks;
+    }
+
+    free(ctx.nodes);
+    free(ctx.parents);
+    free(chunks);
+    free(table);
+    return result;
+}
+
+int checkpoint_restore(const char* path, int threads, CheckpointStats* stats){
+    CheckpointStats local;
+    memset(&local, 0, sizeof(local));
+    if (stats) memset(stats, 0, sizeof(*stats));
+    if (!path || !fs_root){
+        errno = EINVAL;
+        return -1;
+    }
+    if (fs_root->first_child){
+        errno = ENOTEMPTY;
+        return -1;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    double start = ckpt_now();
+    int result = ckpt_restore_fd(fd, threads, &local);
+    int saved = errno;
+    close(fd);
+    errno = saved;
+
+    local.seconds = ckpt_now() - start;
+    if (stats && result == 0) *stats = local;
+    return result;
+}
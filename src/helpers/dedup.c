@@ -0,0 +1,228 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "fs.h"
+#include "blocks.h"
+#include "dedup.h"
+#include "mem.h"
+
+
+// Índice em tabela hash com encadeamento por índices de bloco
+static int       dedup_on = 0;
+static int*      dedup_heads = NULL;     // Primeiro bloco de cada balde (-1 = vazio)
+static size_t    dedup_mask = 0;
+static int*      dedup_next = NULL;      // Próximo bloco no mesmo balde
+static uint64_t* dedup_fp = NULL;        // Impressão digital de cada bloco indexado
+static unsigned char* dedup_indexed = NULL;
+static int       dedup_capacity = 0;
+static long      dedup_hit_count = 0;
+
+// Referências criadas pela deduplicação em cada bloco (sobrevivem ao dedup off: os
+// blocos continuam compartilhados). Snapshots e rollback não entram aqui
+static int*      dedup_shared = NULL;
+static int       dedup_shared_capacity = 0;
+static long      dedup_shared_total = 0;
+
+
+int dedup_enabled(void){
+    return dedup_on;
+}
+
+static uint64_t dedup_rotl(uint64_t x, int r){
+    return (x << r) | (x >> (64 - r));
+}
+
+// Hash de 64 bits processando 8 bytes por vez, com mistura final (fmix64)
+uint64_t dedup_fingerprint(const char* data, size_t len){
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ (uint64_t)len;
+    size_t i = 0;
+
+    for (; i + 8 <= len; i += 8){
+        uint64_t w;
+        memcpy(&w, data + i, sizeof(w));
+        h ^= w * 0xFF51AFD7ED558CCDULL;
+        h = dedup_rotl(h, 31) * 0xC4CEB9FE1A85EC53ULL;
+    }
+    for (; i < len; i++){
+        h ^= (unsigned char)data[i];
+        h *= 0x100000001B3ULL;
+    }
+
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static void dedup_free_index(void){
+    mem_free(MEM_INDEX, dedup_heads);
+    mem_free(MEM_INDEX, dedup_next);
+    mem_free(MEM_INDEX, dedup_fp);
+    mem_free(MEM_INDEX, dedup_indexed);
+    dedup_heads = NULL;
+    dedup_next = NULL;
+    dedup_fp = NULL;
+    dedup_indexed = NULL;
+    dedup_capacity = 0;
+    dedup_mask = 0;
+}
+
+// (Re)cria o índice vazio para total_blocks blocos
+static int dedup_alloc_index(int total_blocks){
+    size_t buckets = 16;
+    while (buckets < (size_t)total_blocks) buckets <<= 1;
+
+    int* heads = (int*)mem_alloc(MEM_INDEX, buckets * sizeof(int));
+    int* next  = (int*)mem_alloc(MEM_INDEX, (size_t)total_blocks * sizeof(int));
+    uint64_t* fp = (uint64_t*)mem_alloc(MEM_INDEX, (size_t)total_blocks * sizeof(uint64_t));
+    unsigned char* indexed = (unsigned char*)mem_calloc(MEM_INDEX, (size_t)total_blocks, 1);
+    if (!heads || !next || !fp || !indexed){
+        mem_free(MEM_INDEX, heads); mem_free(MEM_INDEX, next);
+        mem_free(MEM_INDEX, fp); mem_free(MEM_INDEX, indexed);
+        return -1;
+    }
+
+    memset(heads, 0xFF, buckets * sizeof(int)); // -1 em todos os baldes
+
+    dedup_free_index();
+    dedup_heads    = heads;
+    dedup_next     = next;
+    dedup_fp       = fp;
+    dedup_indexed  = indexed;
+    dedup_mask     = buckets - 1;
+    dedup_capacity = total_blocks;
+    return 0;
+}
+
+static void dedup_index_used_blocks(void){
+    int total = blocks_total();
+    for (int i = 0; i < total; i++){
+        if (blocks_refcount(i) > 0){
+            dedup_insert(i);
+        }
+    }
+}
+
+int dedup_enable(void){
+    if (dedup_on) return 0;
+
+    if (dedup_alloc_index(blocks_total()) != 0){
+        return -1;
+    }
+    dedup_on = 1;
+    dedup_index_used_blocks(); // Blocos já gravados também podem ser reaproveitados
+    return 0;
+}
+
+void dedup_disable(void){
+    // Blocos já compartilhados continuam compartilhados (contagem de referências)
+    dedup_on = 0;
+    dedup_free_index();
+}
+
+// Acompanha o tamanho do disco (o vetor pode existir com a deduplicação desligada)
+static int dedup_shared_resize(int total_blocks){
+    if (total_blocks <= dedup_shared_capacity) return 0;
+
+    int* grown = (int*)mem_realloc(MEM_INDEX, dedup_shared, (size_t)total_blocks * sizeof(int));
+    if (!grown) return -1;
+    memset(grown + dedup_shared_capacity, 0, (size_t)(total_blocks - dedup_shared_capacity) * sizeof(int));
+    dedup_shared = grown;
+    dedup_shared_capacity = total_blocks;
+    return 0;
+}
+
+int dedup_resize(int total_blocks){
+    if (dedup_shared) dedup_shared_resize(total_blocks);
+    if (!dedup_on || total_blocks <= dedup_capacity) return 0;
+
+    // O disco cresceu: reconstrói o índice com mais baldes
+    if (dedup_alloc_index(total_blocks) != 0){
+        dedup_on = 0;
+        return -1;
+    }
+    dedup_index_used_blocks();
+    return 0;
+}
+
+int dedup_lookup(const char* block_data){
+    if (!dedup_on) return -1;
+
+    uint64_t fp = dedup_fingerprint(block_data, FS_BLOCK_SIZE);
+    for (int b = dedup_heads[fp & dedup_mask]; b >= 0; b = dedup_next[b]){
+        // Hash igual não basta: confirma byte a byte
+        if (dedup_fp[b] == fp && memcmp(blocks_data(b), block_data, FS_BLOCK_SIZE) == 0){
+            dedup_hit_count++;
+            return b;
+        }
+    }
+    return -1;
+}
+
+void dedup_insert(int block_index){
+    if (!dedup_on || block_index < 0 || block_index >= dedup_capacity) return;
+    if (dedup_indexed[block_index]) return;
+
+    uint64_t fp = dedup_fingerprint(blocks_data(block_index), FS_BLOCK_SIZE);
+    size_t bucket = fp & dedup_mask;
+
+    dedup_fp[block_index]   = fp;
+    dedup_next[block_index] = dedup_heads[bucket];
+    dedup_heads[bucket]     = block_index;
+    dedup_indexed[block_index] = 1;
+}
+
+void dedup_forget(int block_index){
+    if (!dedup_on || block_index < 0 || block_index >= dedup_capacity) return;
+    if (!dedup_indexed[block_index]) return;
+
+    int* link = &dedup_heads[dedup_fp[block_index] & dedup_mask];
+    while (*link >= 0 && *link != block_index){
+        link = &dedup_next[*link];
+    }
+    if (*link == block_index){
+        *link = dedup_next[block_index];
+    }
+    dedup_indexed[block_index] = 0;
+}
+
+long dedup_hits(void){
+    return dedup_hit_count;
+}
+
+void dedup_note_share(int block_index){
+    if (!dedup_on || block_index < 0) return;
+    if (block_index >= dedup_shared_capacity && dedup_shared_resize(blocks_total()) != 0) return;
+    if (block_index >= dedup_shared_capacity) return;
+
+    dedup_shared[block_index]++;
+    dedup_shared_total++;
+}
+
+void dedup_note_release(int block_index, int refcount){
+    if (block_index < 0 || block_index >= dedup_shared_capacity) return;
+
+    // Não dá para saber qual dono soltou o bloco: as referências da deduplicação
+    // nunca passam das extras (todas menos a primeira)
+    int extra = refcount > 1 ? refcount - 1 : 0;
+    if (dedup_shared[block_index] > extra){
+        dedup_shared_total -= dedup_shared[block_index] - extra;
+        dedup_shared[block_index] = extra;
+    }
+}
+
+long dedup_saved_blocks(void){
+    return dedup_shared_total;
+}
+
+void dedup_shutdown(void){
+    dedup_disable();
+    dedup_hit_count = 0;
+    mem_free(MEM_INDEX, dedup_shared);
+    dedup_shared = NULL;
+    dedup_shared_capacity = 0;
+    dedup_shared_total = 0;
+}
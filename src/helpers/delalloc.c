@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "fs.h"
+#include "blocks.h"
+#include "dedup.h"
+#include "delalloc.h"
+#include "mem.h"
+
+
+// Arquivos com alocação pendente, na ordem da gravação. fcb->delalloc guarda a posição + 1
+typedef struct {
+    FCB* fcb;
+    int  reserved;      // Blocos de capacidade reservados
+    long since_ms;      // Quando a pendência começou
+} DelallocEntry;
+
+static DelallocEntry* da_entries = NULL;
+static int  da_count = 0;
+static int  da_capacity = 0;
+static int  da_reserved = 0;
+static long da_flushed = 0;
+static long da_cancelled = 0;
+
+
+static long delalloc_now_ms(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Só arquivos crus em blocos: inline não usa blocos, a compressão precisa do tamanho
+// físico já na gravação e a deduplicação é feita em linha
+static int delalloc_applies(size_t len){
+    return len > 0 && !blocks_inline_fits(len) && !blocks_compression_enabled() &&
+           !dedup_enabled() && len <= (size_t)FS_MAX_FILE_BLOCKS * FS_BLOCK_SIZE;
+}
+
+// Tira a entrada da lista (a última ocupa o lugar) e solta a reserva
+static void delalloc_remove(FCB* fcb){
+    int slot = fcb->delalloc - 1;
+    if (slot < 0 || slot >= da_count || da_entries[slot].fcb != fcb) return;
+
+    blocks_unreserve_capacity(da_entries[slot].reserved);
+    da_reserved -= da_entries[slot].reserved;
+
+    da_entries[slot] = da_entries[--da_count];
+    if (slot < da_count){
+        da_entries[slot].fcb->delalloc = slot + 1;
+    }
+    fcb->delalloc = 0;
+}
+
+// Escolhe os blocos de um arquivo cuja entrada já saiu da lista
+static int delalloc_place(FCB* fcb){
+    if (!fcb->content || blocks_place_file(fcb, fcb->content, fcb->size) != 0){
+        fprintf(stderr, "delalloc: Falha ao alocar blocos para o inode %d\n", fcb->inode);
+        return -1;
+    }
+    da_flushed++;
+    return 0;
+}
+
+int delalloc_defer(FCB* fcb, size_t len){
+    if (!fcb) return -1;
+
+    blocks_free_for_file(fcb); // Solta os blocos (ou a reserva) da versão anterior
+    if (len == 0) return 0;
+
+    int needed = (int)((len + FS_BLOCK_SIZE - 1) / FS_BLOCK_SIZE);
+    if (needed > FS_MAX_FILE_BLOCKS || blocks_reserve_capacity(needed) != 0){
+        return -1; // Arquivo muito grande ou disco cheio
+    }
+
+    if (da_count == da_capacity){
+        int grown = da_capacity ? da_capacity * 2 : 64;
+        DelallocEntry* entries = (DelallocEntry*)mem_realloc(MEM_INDEX, da_entries,
+                                                             (size_t)grown * sizeof(DelallocEntry));
+        if (!entries){
+            blocks_unreserve_capacity(needed);
+            return -1;
+        }
+        da_entries  = entries;
+        da_capacity = grown;
+    }
+
+    da_entries[da_count].fcb      = fcb;
+    da_entries[da_count].reserved = needed;
+    da_entries[da_count].since_ms = delalloc_now_ms();
+    da_count++;
+    da_reserved += needed;
+    fcb->delalloc = da_count;
+    return 0;
+}
+
+int delalloc_write(FCB* fcb){
+    if (!fcb) return -1;
+
+    if (!delalloc_applies(fcb->size)){
+        return blocks_alloc_for_file(fcb, fcb->content, fcb->size);
+    }
+    return delalloc_defer(fcb, fcb->size);
+}
+
+int delalloc_grow(FCB* fcb, size_t len){
+    if (!fcb) return -1;
+    if (!delalloc_applies(len)) return 1;
+
+    int slot = fcb->delalloc - 1;
+    if (slot < 0 || slot >= da_count || da_entries[slot].fcb != fcb){
+        return delalloc_defer(fcb, len); // Uma vez por descarga: depois só cresce a reserva
+    }
+
+    int needed = (int)((len + FS_BLOCK_SIZE - 1) / FS_BLOCK_SIZE);
+    int extra  = needed - da_entries[slot].reserved;
+    if (extra <= 0) return 0;
+    if (blocks_reserve_capacity(extra) != 0) return -1;
+
+    da_entries[slot].reserved = needed;
+    da_reserved += extra;
+    return 0;
+}
+
+void delalloc_cancel(FCB* fcb){
+    if (!fcb || !fcb->delalloc) return;
+    delalloc_remove(fcb);
+    da_cancelled++;
+}
+
+int delalloc_commit(FCB* fcb){
+    if (!fcb || !fcb->delalloc) return 0;
+    delalloc_remove(fcb);
+    return delalloc_place(fcb);
+}
+
+int delalloc_flush(void){
+    if (da_count == 0) return 0;
+
+    // Todas as reservas saem antes: a capacidade liberada vira as faixas definitivas
+    int count = da_count;
+    blocks_unreserve_capacity(da_reserved);
+    da_reserved = 0;
+    da_count = 0;
+
+    int flushed = 0;
+    for (int i = 0; i < count; i++){
+        FCB* fcb = da_entries[i].fcb;
+        fcb->delalloc = 0;
+        if (delalloc_place(fcb) == 0){
+            flushed++;
+        }
+    }
+    return flushed;
+}
+
+void delalloc_tick(void){
+    if (da_count == 0) return;
+
+    int total = blocks_total();
+    int expired = delalloc_now_ms() - da_entries[0].since_ms >= DELALLOC_EXPIRE_MS;
+    int pressure = total > 0 && (long)da_reserved * 100 >= (long)total * DELALLOC_RESERVE_RATIO;
+
+    // A entrada 0 é a mais antiga, exceto depois de remoções (a aproximação basta)
+    if (expired || pressure){
+        delalloc_flush();
+    }
+}
+
+void delalloc_stats(int* pending, int* reserved, long* flushed, long* cancelled){
+    if (pending)   *pending   = da_count;
+    if (reserved)  *reserved  = da_reserved;
+    if (flushed)   *flushed   = da_flushed;
+    if (cancelled) *cancelled = da_cancelled;
+}
+
+void delalloc_shutdown(void){
+    for (int i = 0; i < da_count; i++){
+        da_entries[i].fcb->delalloc = 0;
+    }
+    if (da_reserved > 0) blocks_unreserve_capacity(da_reserved);
+    mem_free(MEM_INDEX, da_entries);
+    da_entries = NULL;
+    da_count = da_capacity = da_reserved = 0;
+    da_flushed = da_cancelled = 0;
+}
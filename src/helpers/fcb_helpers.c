@@ -1,52 +1,126 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <time.h>
-#include "fs.h"
-#include "fcb_helpers.h"
-
-
-static int next_inode = 1; // contador de inodes
-
-FCB* create_fcb(const char* name, FileType type){
-    FCB* fcb = (FCB*)malloc(sizeof(FCB));
-    if(!fcb){
-        fprintf(stderr, "Erro ao alocar memoria para FCB\n");
-        exit(EXIT_FAILURE);
-    }
-
-    strncpy(fcb->name, name, MAX_NAME_LEN -1);
-    fcb->name[MAX_NAME_LEN -1] = '\0';
-    fcb->size = 0;
-    fcb->type = type;
-
-    time_t now = time(NULL);
-    fcb->created_at = now;
-    fcb->modified_at = now;
-    fcb->accessed_at = now;
-
-    fcb->inode = next_inode++;
-    fcb->permissions = 0644;                   // (rw-r--r--) por enquanto
-    fcb->owner = fs_current_user_class;        // proprietário padrão
-
-    fcb->block_count = 0;                      // Nenhum bloco alocado
-    for (int i = 0; i < FCB_MAX_BLOCKS; i++)
-    {
-        fcb->blocks[i] = -1;                     // Inicializa todos os blocos como não alocados
-    }
-    
-
-
-    fcb->content = NULL;                       // Conteúdo vazio
-
-    return fcb;
-}
-
-void free_fcb(FCB* fcb) {
-    if (!fcb) return;
-
-    if (fcb->content) {
-        free(fcb->content);
-    }
-    free(fcb);
-}
\ No newline at end of file
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+#include "fs.h"
+#include "fcb_helpers.h"
+#include "fs_name.h"
+#include "fs_time.h"
+#include "mem.h"
+
+
+static atomic_int next_inode = 1; // contador de inodes (atômico: o construtor em lote cria FCBs em paralelo)
+
+// Preenche um FCB novo que já recebeu sua referência ao nome internado
+static FCB* fcb_init(const char* interned, FileType type){
+    FCB* fcb = (FCB*)mem_alloc(MEM_FCB, sizeof(FCB));
+    if(!fcb){
+        fprintf(stderr, "Erro ao alocar memoria para FCB\n");
+        exit(EXIT_FAILURE);
+    }
+
+    fcb->name = interned;
+    fcb->size = 0;
+    fcb->type = type;
+
+    time_t now = fs_clock_now();
+    fcb->created_at = now;
+    fcb->modified_at = now;
+    fcb->accessed_at = now;
+
+    fcb->inode = fcb_next_inode();
+    fcb->permissions = 0644;                   // (rw-r--r--) por enquanto
+    fcb->owner = fs_current_user_class;        // proprietário padrão
+
+    fcb->block_count = 0;                      // Nenhum bloco alocado
+    for (int i = 0; i < FCB_MAX_BLOCKS; i++)
+    {
+        fcb->direct_blocks[i] = -1;              // Inicializa todos os blocos como não alocados
+    }
+    fcb->block_map = NULL;                     // O mapa cabe no próprio FCB
+    fcb->inlined = 0;                          // Dados nos blocos (ou arquivo vazio)
+    fcb->compressed = 0;                       // Blocos guardam os dados crus
+    memset(fcb->cluster_bytes, 0, sizeof(fcb->cluster_bytes));
+    fcb->delalloc = 0;                         // Sem alocação adiada pendente
+    fcb->usage_bytes = 0;                      // Nada somado nos diretórios ainda (fs_usage.h)
+    fcb->usage_blocks = 0;
+    
+
+
+    fcb->content = NULL;                       // Conteúdo vazio
+
+    return fcb;
+}
+
+FCB* create_fcb(const char* name, FileType type){
+    return fcb_init(fs_name_intern(name), type); // Compartilha o registro do nó de mesmo nome
+}
+
+FCB* create_fcb_interned(const char* name, FileType type){
+    return fcb_init(fs_name_retain(name), type);
+}
+
+void free_fcb(FCB* fcb) {
+    if (!fcb) return;
+
+    if (fcb->content) {
+        mem_free(MEM_CONTENT, fcb->content);
+    }
+    mem_free(MEM_FCB, fcb->block_map);
+    fs_name_release(fcb->name);
+    mem_free(MEM_FCB, fcb);
+}
+
+int* fcb_blocks(const FCB* fcb){
+    return fcb->block_map ? fcb->block_map : (int*)fcb->direct_blocks;
+}
+
+int fcb_map_capacity(const FCB* fcb){
+    if (!fcb->block_map) return FCB_MAX_BLOCKS;
+    // A capacidade é a do bloco entregue pelo malloc: só realoca quando ela acaba
+    size_t cap = mem_capacity(fcb->block_map) / sizeof(int);
+    return cap < FS_MAX_FILE_BLOCKS ? (int)cap : FS_MAX_FILE_BLOCKS;
+}
+
+int fcb_map_reserve(FCB* fcb, int count){
+    if (count > FS_MAX_FILE_BLOCKS) return -1;
+    int have = fcb_map_capacity(fcb);
+    if (count <= have) return 0;
+
+    int cap = have;
+    while (cap < count) cap *= 2;
+    if (cap > FS_MAX_FILE_BLOCKS) cap = FS_MAX_FILE_BLOCKS;
+
+    int* map = (int*)mem_realloc(MEM_FCB, fcb->block_map, (size_t)cap * sizeof(int));
+    if (!map) return -1;
+    if (!fcb->block_map) memcpy(map, fcb->direct_blocks, sizeof(fcb->direct_blocks));
+    fcb->block_map = map;
+
+    cap = fcb_map_capacity(fcb);
+    for (int i = have; i < cap; i++) map[i] = -1;
+    return 0;
+}
+
+void fcb_map_release(FCB* fcb){
+    if (fcb->block_map){
+        mem_free(MEM_FCB, fcb->block_map);
+        fcb->block_map = NULL;
+    }
+    for (int i = 0; i < FCB_MAX_BLOCKS; i++) fcb->direct_blocks[i] = -1;
+}
+
+int fcb_inode_high_water(void){
+    return atomic_load(&next_inode) - 1;
+}
+
+int fcb_next_inode(void){
+    return atomic_fetch_add(&next_inode, 1);
+}
+
+void fcb_reserve_inodes(int high_water){
+    int next = atomic_load(&next_inode);
+    while (next <= high_water){
+        if (atomic_compare_exchange_weak(&next_inode, &next, high_water + 1)) break;
+    }
+}
@@ -0,0 +1,265 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "fs.h"
+#include "fs_glob.h"
+
+
+int fs_glob_has_magic(const char* text){
+    return text && strpbrk(text, "*?[") != NULL;
+}
+
+// Avalia uma classe "[...]" (p aponta para '[') contra o caractere c.
+// Retorna o ponteiro logo após o ']' ou NULL se a classe não fecha.
+static const char* glob_class(const char* p, unsigned char c, int* matched){
+    const char* q = p + 1;
+    int negate = 0;
+    int found  = 0;
+    int first  = 1;
+
+    if (*q == '!' || *q == '^'){
+        negate = 1;
+        q++;
+    }
+
+    // Um ']' logo no início faz parte da classe
+    while (*q && (*q != ']' || first)){
+        unsigned char lo = (unsigned char)*q;
+        if (q[1] == '-' && q[2] && q[2] != ']'){
+            unsigned char hi = (unsigned char)q[2]; // Intervalo a-z
+            if (c >= lo && c <= hi) found = 1;
+            q += 3;
+        } else {
+            if (c == lo) found = 1;
+            q++;
+        }
+        first = 0;
+    }
+
+    if (*q != ']'){
+        return NULL;
+    }
+    *matched = found ^ negate;
+    return q + 1;
+}
+
+// Compara um único token do padrão com o caractere c.
+// Retorna o ponteiro para o próximo token, ou NULL se não casar.
+static const char* glob_step(const char* p, unsigned char c){
+    if (*p == '?'){
+        return p + 1;
+    }
+    if (*p == '['){
+        int matched = 0;
+        const char* next = glob_class(p, c, &matched);
+        if (next){
+            return matched ? next : NULL;
+        }
+        // Classe sem ']' é tratada como '[' literal
+    }
+    return ((unsigned char)*p == c) ? p + 1 : NULL;
+}
+
+// Depois de um '*', pula direto para a próxima ocorrência do literal seguinte.
+// strchr da libc é vetorizado, então a varredura é feita em blocos de bytes.
+static const char* glob_skip_to(const char* p, const char* s){
+    if (*p != '?' && *p != '['){
+        return strchr(s, *p);
+    }
+    return s;
+}
+
+// Casamento genérico iterativo, retrocedendo apenas até o último '*'
+static int glob_match_generic(const char* p, const char* s){
+    const char* star_p = NULL;
+    const char* star_s = NULL;
+
+    while (*s){
+        if (*p == '*'){
+            while (*p == '*') p++;
+            if (*p == '\0') return 1; // '*' final casa com o resto
+
+            s = glob_skip_to(p, s);
+            if (!s) return 0;
+            star_p = p;
+            star_s = s;
+            continue;
+        }
+
+        const char* next = glob_step(p, (unsigned char)*s);
+        if (*p && next){
+            p = next;
+            s++;
+            continue;
+        }
+
+        if (!star_p){
+            return 0;
+        }
+
+        // O último '*' absorve mais um caractere e tenta de novo
+        p = star_p;
+        s = glob_skip_to(p, star_s + 1);
+        if (!s) return 0;
+        star_s = s;
+    }
+
+    while (*p == '*') p++;
+    return *p == '\0';
+}
+
+int fs_glob_compile(FsGlob* glob, const char* pattern){
+    if (!glob || !pattern) return -1;
+
+    size_t len = strlen(pattern);
+    if (len == 0 || len >= MAX_NAME_LEN){
+        return -1;
+    }
+
+    memcpy(glob->text, pattern, len + 1);
+    glob->text_len   = len;
+    glob->prefix_len = 0;
+    glob->suffix_len = 0;
+    glob->literal[0] = '\0';
+
+    if (!strpbrk(pattern, "?[")){
+        int stars = 0;
+        const char* first_star = NULL;
+        for (const char* c = pattern; *c; c++){
+            if (*c == '*'){
+                if (!first_star) first_star = c;
+                stars++;
+            }
+        }
+
+        if (stars == 0){
+            glob->kind = GLOB_LITERAL;
+            return 0;
+        }
+
+        if (stars == 1){
+            // "prefixo*sufixo": guarda as duas partes em sequência
+            size_t prefix = (size_t)(first_star - pattern);
+            size_t suffix = len - prefix - 1;
+            memcpy(glob->literal, pattern, prefix);
+            memcpy(glob->literal + prefix, first_star + 1, suffix);
+            glob->literal[prefix + suffix] = '\0';
+            glob->prefix_len = prefix;
+            glob->suffix_len = suffix;
+
+            if (prefix == 0 && suffix == 0)  glob->kind = GLOB_ANY;
+            else if (suffix == 0)            glob->kind = GLOB_PREFIX;
+            else if (prefix == 0)            glob->kind = GLOB_SUFFIX;
+            else                             glob->kind = GLOB_PREFIX_SUFFIX;
+            return 0;
+        }
+
+        if (stars == 2 && pattern[0] == '*' && pattern[len - 1] == '*'){
+            // "*meio*": busca de substring
+            size_t middle = len - 2;
+            memcpy(glob->literal, pattern + 1, middle);
+            glob->literal[middle] = '\0';
+            glob->suffix_len = middle;
+            glob->kind = (middle == 0) ? GLOB_ANY : GLOB_CONTAINS;
+            return 0;
+        }
+    }
+
+    glob->kind = GLOB_GENERIC;
+    return 0;
+}
+
+// Procura a substring usando memchr no primeiro byte e memcmp no restante
+static int glob_contains(const char* name, const char* needle, size_t needle_len){
+    size_t name_len = strlen(name);
+    if (needle_len > name_len) return 0;
+
+    const char* cur  = name;
+    const char* last = name + (name_len - needle_len);
+    while (cur <= last){
+        cur = memchr(cur, needle[0], (size_t)(last - cur) + 1);
+        if (!cur) return 0;
+        if (memcmp(cur, needle, needle_len) == 0) return 1;
+        cur++;
+    }
+    return 0;
+}
+
+int fs_glob_match(const FsGlob* glob, const char* name){
+    if (!glob || !name) return 0;
+
+    switch (glob->kind){
+        case GLOB_LITERAL:
+            return strcmp(name, glob->text) == 0;
+
+        case GLOB_ANY:
+            return 1;
+
+        case GLOB_PREFIX:
+            return strncmp(name, glob->literal, glob->prefix_len) == 0;
+
+        case GLOB_SUFFIX:
+        case GLOB_PREFIX_SUFFIX: {
+            size_t name_len = strlen(name);
+            if (name_len < glob->prefix_len + glob->suffix_len) return 0;
+            if (memcmp(name, glob->literal, glob->prefix_len) != 0) return 0;
+            return memcmp(name + name_len - glob->suffix_len,
+                          glob->literal + glob->prefix_len, glob->suffix_len) == 0;
+        }
+
+        case GLOB_CONTAINS:
+            return glob_contains(name, glob->literal, glob->suffix_len);
+
+        case GLOB_GENERIC:
+        default:
+            return glob_match_generic(glob->text, name);
+    }
+}
+
+int fs_globset_compile(FsGlobSet* set, char** patterns, int count){
+    if (!set) return -1;
+
+    set->globs = NULL;
+    set->hits  = NULL;
+    set->count = 0;
+
+    if (count <= 0) return 0;
+
+    set->globs = (FsGlob*)malloc(sizeof(FsGlob) * (size_t)count);
+    set->hits  = (int*)calloc((size_t)count, sizeof(int));
+    if (!set->globs || !set->hits){
+        fs_globset_free(set);
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++){
+        if (fs_glob_compile(&set->globs[i], patterns[i]) != 0){
+            fs_globset_free(set);
+            return -1;
+        }
+    }
+    set->count = count;
+    return 0;
+}
+
+int fs_globset_match(FsGlobSet* set, const char* name){
+    int first = -1;
+
+    for (int i = 0; i < set->count; i++){
+        if (fs_glob_match(&set->globs[i], name)){
+            set->hits[i]++;
+            if (first < 0) first = i;
+        }
+    }
+    return first;
+}
+
+void fs_globset_free(FsGlobSet* set){
+    if (!set) return;
+
+    free(set->globs);
+    free(set->hits);
+    set->globs = NULL;
+    set->hits  = NULL;
+    set->count = 0;
+}
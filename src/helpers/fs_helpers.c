@@ -1,185 +1,280 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-
-#include "fs.h"
-#include "fs_helpers.h"
-#include "fcb_helpers.h"
-#include "blocks.h"
-
-
-
-// Cria um novo nó do sistema de arquivos
-FsNode* fs_create_node(const char* name, NodeType type, FsNode* parent){
-    FsNode* node = (FsNode*)malloc(sizeof(FsNode));
-
-    if(!node){
-        fprintf(stderr, "Erro ao alocar memoria para nó do sistema de arquivos\n");
-        exit(EXIT_FAILURE);
-    }
-
-    strncpy(node->name, name, MAX_NAME_LEN -1);
-    node->name[MAX_NAME_LEN -1] = '\0';
-    node->type = type;
-
-    node->parent = parent;
-    node->first_child = NULL;
-    node->next_sibling = NULL;
-
-    node->fcb = NULL; // se for arquivo, vamos atribuir depois
-
-    return node;
-}
-
-// Procura filho por nome
-FsNode* fs_find_child(FsNode* dir, const char* name){
-    if (!dir || dir->type != NODE_DIR) {
-        return NULL; // Sem filhos para procurar
-    }
-
-    // Aponta o primeiro filho
-    FsNode* child = dir->first_child; 
-
-
-    // Percorre os filhos
-    while(child){
-        if(strcmp(child->name, name) == 0){ // Se as strings forem iguais. Retorna 0
-            return child;
-        }
-        child = child->next_sibling; // Proximo irmão
-    }
-    return NULL;
-}
-
-// Adiciona um nó filho a um diretório
-void fs_add_child(FsNode* dir, FsNode* child){
-
-    if (!dir || dir->type != NODE_DIR) {
-        fprintf(stderr, "Erro: Tentativa de adicionar filho a um nó que não é diretório\n");
-        return;
-    }
-
-    // Define o diretório como pai do novo nó
-    child->parent = dir;
-
-    if (!dir->first_child){ // Se nao tiver filho
-        dir->first_child = child; // Primeiro filho
-    } else {
-        // Se já tem filho
-        FsNode* last = dir->first_child;
-        while(last->next_sibling){
-            last = last->next_sibling; // Percorre até chegar no último irmão 
-        }
-        last->next_sibling = child; // Novo nó vira o próximo irmão 
-    }
-}
-
-// Remove um filho específico de um diretório e libera memória
-void fs_remove_child(FsNode* dir, FsNode* child){
-    if (!dir || !child) {
-        return; // Nada a fazer
-    }
-
-    FsNode* prev = NULL;
-    FsNode* curr = dir->first_child;
-
-    // Procura o filho na lista
-    while(curr){
-        if (curr == child){
-            // Encontrou o filho
-            if (prev){
-                prev->next_sibling = curr->next_sibling; // Remove da lista
-            } else {
-                dir->first_child = curr->next_sibling; // Atualiza o primeiro filho
-            }
-            curr->next_sibling = NULL; // Desconecta
-            fs_free_tree(curr); // Libera o nó e seus filhos
-            return;
-        }
-        prev = curr;
-        curr = curr->next_sibling;
-    }
-}
-
-static void fs_free_tree_internal(FsNode* node) {
-    if (!node) return;
-
-    FsNode* child = node->first_child;
-    while (child) {
-        FsNode* next = child->next_sibling;
-        fs_free_tree_internal(child);
-        child = next;
-    }
-
-    if (node->fcb) {
-        blocks_free_for_file(node->fcb);
-        if (node->fcb->content) {
-            free(node->fcb->content);
-    }
-    free(node->fcb);
-}
-
-    free(node);
-}
-
-void fs_free_tree(FsNode* node) {
-    fs_free_tree_internal(node); 
-}
-
-void fs_get_path(FsNode* node, char* buffer, size_t size){
-    if(!node){
-        snprintf(buffer, size, "?"); // Inválido
-        return;
-    }
-
-    if (node == fs_root){
-        snprintf(buffer, size, "/"); // Raíz
-        return;
-    }
-
-    // Guarda o caminho do pai temporariamente
-    char temp[PATH_MAX_LEN];
-
-    // Se tiver pai, chama recursivamente
-    if (node->parent){
-        fs_get_path(node->parent, temp, sizeof(temp));
-    } else {
-        snprintf(temp, sizeof(temp), "/"); // Sem pai, é raíz
-    }
-    // Se o pai for raíz
-    if (strcmp(temp, "/") == 0){ 
-        snprintf(buffer, size, "/%s", node->name); // Evita duplicar barra
-    } else {
-        snprintf(buffer, size, "%s/%s", temp, node->name); // Caminho completo
-    }
-}
-
-void fs_move_node(FsNode* node, FsNode* new_parent){
-    if (!node || !new_parent || new_parent->type != NODE_DIR) {
-        fprintf(stderr, "Erro: Movimento inválido de nó\n");
-        return;
-    }
-
-    FsNode* old_parent = node->parent;
-    if (!old_parent) {
-        return;
-    }
-
-    FsNode* prev = NULL;
-    FsNode* curr = old_parent->first_child;
-
-    while (curr){
-        if(curr == node){
-            if (prev){
-                prev->next_sibling = curr->next_sibling; // Remove da lista do antigo pai
-            } else {
-                old_parent->first_child = curr->next_sibling; // Atualiza o primeiro filho
-            }
-            curr->next_sibling = NULL; // Desconecta
-            break;
-        }
-        prev = curr;
-        curr = curr->next_sibling;
-    }
-    fs_add_child(new_parent, node); // Adiciona ao novo pai
-}
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fs.h"
+#include "fs_helpers.h"
+#include "fcb_helpers.h"
+#include "fs_name.h"
+#include "blocks.h"
+#include "fs_walk.h"
+#include "snapshot.h"
+#include "fs_time.h"
+#include "mem.h"
+#include "trace.h"
+#include "minifs.h"
+#include "fs_usage.h"
+
+
+
+// Cria um novo nó do sistema de arquivos
+FsNode* fs_create_node(const char* name, NodeType type, FsNode* parent){
+    FsNode* node = (FsNode*)mem_alloc(MEM_NODE, sizeof(FsNode));
+
+    if(!node){
+        fprintf(stderr, "Erro ao alocar memoria para nó do sistema de arquivos\n");
+        exit(EXIT_FAILURE);
+    }
+
+    node->name = fs_name_intern(name);
+    node->type = type;
+
+    node->parent = parent;
+    node->first_child = NULL;
+    node->next_sibling = NULL;
+
+    node->fcb = NULL; // se for arquivo, vamos atribuir depois
+    node->usage = NULL;
+    if (type == NODE_DIR){
+        node->usage = (FsUsage*)mem_calloc(MEM_USAGE, 1, sizeof(FsUsage)); // Totais da subárvore, zerados
+        if (!node->usage){
+            fprintf(stderr, "Erro ao alocar memoria para nó do sistema de arquivos\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    node->born_epoch = snap_current_epoch();
+    node->snap_epoch = node->born_epoch;
+    node->lazy_atime = 0;
+
+    TRACE_EVENT(TRACE_NODE_CREATE, node->name, type == NODE_DIR, 0);
+
+    return node;
+}
+
+// Procura filho por nome
+FsNode* fs_find_child(FsNode* dir, const char* name){
+    if (!dir || dir->type != NODE_DIR) {
+        return NULL; // Sem filhos para procurar
+    }
+
+    // O hash do nome procurado é calculado uma vez; cada filho compara hash e tamanho antes dos bytes
+    size_t   len  = strlen(name);
+    uint32_t hash = fs_name_hash_text(name, len);
+
+    // Aponta o primeiro filho
+    FsNode* child = dir->first_child; 
+
+
+    // Percorre os filhos
+    while(child){
+        if(fs_name_equals(child->name, name, len, hash)){
+            return child;
+        }
+        child = child->next_sibling; // Proximo irmão
+    }
+    return NULL;
+}
+
+// Encadeia um nó no fim da lista de filhos de um diretório
+static void fs_link_child(FsNode* dir, FsNode* child){
+    // Define o diretório como pai do novo nó
+    snap_touch(child);
+    child->parent = dir;
+
+    if (!dir->first_child){ // Se nao tiver filho
+        snap_touch(dir);
+        dir->first_child = child; // Primeiro filho
+    } else {
+        // Se já tem filho
+        FsNode* last = dir->first_child;
+        while(last->next_sibling){
+            last = last->next_sibling; // Percorre até chegar no último irmão 
+        }
+        snap_touch(last);
+        last->next_sibling = child; // Novo nó vira o próximo irmão 
+    }
+    fs_usage_attach(child); // Totais dos diretórios acima
+}
+
+// Adiciona um nó filho a um diretório
+void fs_add_child(FsNode* dir, FsNode* child){
+
+    if (!dir || dir->type != NODE_DIR) {
+        fprintf(stderr, "Erro: Tentativa de adicionar filho a um nó que não é diretório\n");
+        return;
+    }
+
+    fs_link_child(dir, child);
+    snap_node_created(child);
+}
+
+// Remove um filho específico de um diretório e libera memória
+void fs_remove_child(FsNode* dir, FsNode* child){
+    if (!dir || !child) {
+        return; // Nada a fazer
+    }
+
+    FsNode* prev = NULL;
+    FsNode* curr = dir->first_child;
+
+    // Procura o filho na lista
+    while(curr){
+        if (curr == child){
+            // Encontrou o filho
+            fs_remove_child_after(dir, prev, curr);
+            return;
+        }
+        prev = curr;
+        curr = curr->next_sibling;
+    }
+}
+
+// Remove um filho sem percorrer a lista, usando o irmão anterior
+void fs_remove_child_after(FsNode* dir, FsNode* prev, FsNode* child){
+    if (!dir || !child) {
+        return;
+    }
+
+    snap_touch(prev ? prev : dir);
+    snap_touch(child);
+    mfs_node_unlinked(child); // Leituras de diretório (libminifs) paradas nele avançam
+    fs_usage_detach(child, 1);
+
+    if (prev) {
+        prev->next_sibling = child->next_sibling;
+    } else {
+        dir->first_child = child->next_sibling;
+    }
+    child->next_sibling = NULL; // Desconecta
+
+    // Se algum snapshot ainda enxerga o nó, a liberação fica para depois
+    if (!snap_retire(child)) {
+        fs_free_tree(child);
+    }
+}
+
+// Libera um único nó (e seu FCB), sem olhar para os filhos
+void fs_free_node(FsNode* node) {
+    TRACE_EVENT(TRACE_NODE_FREE, node->name, 0, 0);
+    fs_time_forget(node);
+    mfs_node_freed(node);
+    if (node->fcb) {
+        blocks_free_for_file(node->fcb);
+        if (node->fcb->content) {
+            mem_free(MEM_CONTENT, node->fcb->content);
+        }
+        fs_name_release(node->fcb->name);
+        mem_free(MEM_FCB, node->fcb);
+    }
+    fs_name_release(node->name);
+    mem_free(MEM_USAGE, node->usage);
+    mem_free(MEM_NODE, node);
+}
+
+// Libera a árvore em pós-ordem: cada nó só é liberado depois dos filhos.
+// O percurso é iterativo, então árvores profundas não estouram a pilha.
+static void fs_free_tree_internal(FsNode* node) {
+    if (!node) return;
+
+    FsWalk walk;
+    fs_walk_begin(&walk, node, FS_WALK_POSTORDER);
+
+    FsNode* curr;
+    while ((curr = fs_walk_next(&walk)) != NULL) {
+        fs_free_node(curr);
+    }
+}
+
+void fs_free_tree(FsNode* node) {
+    fs_free_tree_internal(node); 
+}
+
+// Monta o caminho subindo pelos pais, preenchendo o buffer de trás para frente.
+// Não usa recursão nem buffers temporários por nível.
+void fs_get_path(FsNode* node, char* buffer, size_t size){
+    if (!buffer || size == 0) {
+        return;
+    }
+
+    if(!node){
+        snprintf(buffer, size, "?"); // Inválido
+        return;
+    }
+
+    if (node == fs_root || !node->parent){
+        snprintf(buffer, size, "/"); // Raíz
+        return;
+    }
+
+    // Primeiro mede o tamanho total do caminho
+    size_t len = 0;
+    for (FsNode* n = node; n->parent; n = n->parent) {
+        len += 1 + fs_name_len(n->name); // "/" + nome
+    }
+
+    // Depois copia cada nome na sua posição final.
+    // Se não couber, o caminho é truncado no final (como o snprintf faria).
+    size_t limit = size - 1;
+    size_t pos = len;
+    for (FsNode* n = node; n->parent; n = n->parent) {
+        size_t name_len = fs_name_len(n->name);
+        pos -= name_len;
+        for (size_t i = 0; i < name_len && pos + i < limit; i++) {
+            buffer[pos + i] = n->name[i];
+        }
+        pos--;
+        if (pos < limit) {
+            buffer[pos] = '/';
+        }
+    }
+
+    buffer[len < limit ? len : limit] = '\0';
+}
+
+void fs_rename_node(FsNode* node, const char* new_name){
+    const char* name = fs_name_intern(new_name);
+
+    // Nó e FCB passam a apontar para o mesmo registro; o antigo perde as duas referências
+    fs_name_release(node->name);
+    node->name = name;
+    if (node->fcb){
+        fs_name_release(node->fcb->name);
+        node->fcb->name = fs_name_retain(name);
+    }
+}
+
+void fs_move_node(FsNode* node, FsNode* new_parent){
+    if (!node || !new_parent || new_parent->type != NODE_DIR) {
+        fprintf(stderr, "Erro: Movimento inválido de nó\n");
+        return;
+    }
+
+    FsNode* old_parent = node->parent;
+    if (!old_parent) {
+        return;
+    }
+    TRACE_EVENT(TRACE_NODE_MOVE, node->name, 0, 0);
+
+    FsNode* prev = NULL;
+    FsNode* curr = old_parent->first_child;
+
+    while (curr){
+        if(curr == node){
+            snap_touch(prev ? prev : old_parent);
+            snap_touch(node);
+            mfs_node_unlinked(node);
+            fs_usage_detach(node, 0);
+            if (prev){
+                prev->next_sibling = curr->next_sibling; // Remove da lista do antigo pai
+            } else {
+                old_parent->first_child = curr->next_sibling; // Atualiza o primeiro filho
+            }
+            curr->next_sibling = NULL; // Desconecta
+            break;
+        }
+        prev = curr;
+        curr = curr->next_sibling;
+    }
+    fs_link_child(new_parent, node); // Adiciona ao novo pai
+}
@@ -0,0 +1,215 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "fs.h"
+#include "fs_list.h"
+#include "fs_name.h"
+#include "permissions.h"
+
+
+#define LIST_BUFFER_SIZE (256 * 1024)
+// Maior linha possível: permissões, dono, tamanho (20 dígitos), nome, barra e '\n'
+#define LIST_LINE_MAX (10 + 8 + 21 + MAX_NAME_LEN + 2)
+
+typedef struct {
+    char*  data;
+    size_t len;
+    int    fd;
+    int    failed;
+} ListOut;
+
+// Chave de ordenação já ajustada para ordem crescente, com o nó correspondente
+typedef struct {
+    uint64_t key;
+    const FsNode* node;
+} ListEntry;
+
+static const char*  list_owner_names[] = { "owner", "group", "other" };
+static const size_t list_owner_lens[]  = { 5, 5, 5 };
+
+
+static void list_flush(ListOut* out){
+    size_t done = 0;
+    while (done < out->len && !out->failed){
+        ssize_t written = write(out->fd, out->data + done, out->len - done);
+        if (written < 0){
+            if (errno == EINTR) continue;
+            out->failed = 1;
+            break;
+        }
+        done += (size_t)written;
+    }
+    out->len = 0;
+}
+
+// Escreve o número em decimal em p e devolve o fim
+static char* list_utoa(char* p, size_t value){
+    char digits[24];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (n > 0) *p++ = digits[--n];
+    return p;
+}
+
+static void list_render(ListOut* out, const FsNode* node, int long_format){
+    if (out->len > LIST_BUFFER_SIZE - LIST_LINE_MAX) list_flush(out);
+
+    char* p = out->data + out->len;
+    size_t name_len = fs_name_len(node->name);
+
+    if (long_format && node->fcb){
+        const FCB* fcb = node->fcb;
+        memcpy(p, perms_string(fcb->permissions), 9);
+        p[9] = ' ';
+        p += 10;
+
+        if ((unsigned)fcb->owner <= USER_OTHER){
+            memcpy(p, list_owner_names[fcb->owner], list_owner_lens[fcb->owner]);
+            p += list_owner_lens[fcb->owner];
+        } else {
+            memcpy(p, "unknown", 7);
+            p += 7;
+        }
+        *p++ = ' ';
+        p = list_utoa(p, fcb->size);
+        *p++ = ' ';
+        memcpy(p, node->name, name_len);
+        p += name_len;
+    } else {
+        memcpy(p, node->name, name_len);
+        p += name_len;
+        if (node->type == NODE_DIR) *p++ = '/'; // Ganha uma barra para identificar como diretório
+    }
+    *p++ = '\n';
+    out->len = (size_t)(p - out->data);
+}
+
+static int list_open(ListOut* out, int fd){
+    out->data = (char*)malloc(LIST_BUFFER_SIZE);
+    out->len = 0;
+    out->fd = fd;
+    out->failed = 0;
+    return out->data ? 0 : -1;
+}
+
+static int list_close(ListOut* out){
+    list_flush(out);
+    free(out->data);
+    return out->failed ? -1 : 0;
+}
+
+// Valor ordenado de um nó (diretórios sem FCB valem 0: vão para o fim)
+static uint64_t list_value(const FsNode* node, FsListSort sort){
+    if (!node->fcb) return 0;
+    if (sort == FS_LIST_SORT_SIZE) return (uint64_t)node->fcb->size;
+    return node->fcb->modified_at > 0 ? (uint64_t)node->fcb->modified_at : 0;
+}
+
+// Radix sort LSD de 8 bits, estável: empates mantêm a ordem do diretório.
+// Só roda as passadas dos bytes que de fato variam. Devolve o vetor ordenado (a ou tmp)
+static ListEntry* list_radix_sort(ListEntry* a, ListEntry* tmp, size_t n){
+    uint64_t bits = 0;
+    for (size_t i = 0; i < n; i++) bits |= a[i].key;
+
+    for (int shift = 0; shift < 64 && (bits >> shift) != 0; shift += 8){
+        size_t count[257] = {0};
+        for (size_t i = 0; i < n; i++) count[((a[i].key >> shift) & 0xff) + 1]++;
+        for (int d = 0; d < 256; d++) count[d + 1] += count[d];
+        for (size_t i = 0; i < n; i++) tmp[count[(a[i].key >> shift) & 0xff]++] = a[i];
+
+        ListEntry* swap = a;
+        a = tmp;
+        tmp = swap;
+    }
+    return a;
+}
+
+// Coleta as entradas que passam no filtro, ordena pelos índices e escreve a janela pedida
+static long list_sorted(const FsNode* dir, const FsListOptions* opt, FsListFilter filter, void* arg,
+                        ListOut* out){
+    size_t cap = 1024, n = 0;
+    ListEntry* entries = (ListEntry*)malloc(cap * sizeof(ListEntry));
+    if (!entries) return -1;
+
+    uint64_t max = 0;
+    for (const FsNode* child = dir->first_child; child; child = child->next_sibling){
+        if (filter && !filter(child, arg)) continue;
+        if (n == cap){
+            ListEntry* grown = (ListEntry*)realloc(entries, cap * 2 * sizeof(ListEntry));
+            if (!grown){
+                free(entries);
+                return -1;
+            }
+            entries = grown;
+            cap *= 2;
+        }
+        entries[n].key  = list_value(child, opt->sort);
+        entries[n].node = child;
+        if (entries[n].key > max) max = entries[n].key;
+        n++;
+    }
+
+    // Maior primeiro: a chave crescente é a distância até o máximo
+    for (size_t i = 0; i < n; i++) entries[i].key = max - entries[i].key;
+
+    ListEntry* tmp = (ListEntry*)malloc((n ? n : 1) * sizeof(ListEntry));
+    if (!tmp){
+        free(entries);
+        return -1;
+    }
+    ListEntry* sorted = list_radix_sort(entries, tmp, n);
+
+    size_t end = opt->limit && opt->offset + opt->limit < n ? opt->offset + opt->limit : n;
+    long listed = 0;
+    for (size_t i = opt->offset; i < end; i++){
+        list_render(out, sorted[i].node, opt->long_format);
+        listed++;
+    }
+    free(entries);
+    free(tmp);
+    return listed;
+}
+
+long fs_list_dir(const FsNode* dir, const FsListOptions* opt, FsListFilter filter, void* arg, int fd){
+    if (!dir || !opt) return -1;
+
+    ListOut out;
+    if (list_open(&out, fd) != 0) return -1;
+
+    long listed = 0;
+    if (opt->sort != FS_LIST_SORT_NONE){
+        listed = list_sorted(dir, opt, filter, arg, &out);
+    } else {
+        // Sem ordenação a listagem é um fluxo: para assim que a janela termina
+        size_t seen = 0;
+        for (const FsNode* child = dir->first_child; child; child = child->next_sibling){
+            if (filter && !filter(child, arg)) continue;
+            if (seen++ < opt->offset) continue;
+            if (opt->limit && (size_t)listed == opt->limit){
+                if (!filter) break;
+                continue; // O filtro ainda precisa ver o resto (padrões sem nenhuma entrada)
+            }
+            list_render(&out, child, opt->long_format);
+            listed++;
+        }
+    }
+
+    if (list_close(&out) != 0) return -1;
+    return listed;
+}
+
+int fs_list_node(const FsNode* node, int long_format, int fd){
+    if (!node) return -1;
+
+    char line[LIST_LINE_MAX];
+    ListOut out = { line, 0, fd, 0 };
+    list_render(&out, node, long_format);
+    list_flush(&out);
+    return out.failed ? -1 : 0;
+}
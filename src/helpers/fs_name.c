@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "fs.h"
+#include "fs_name.h"
+#include "mem.h"
+
+
+// Registro de um nome: cabeçalho com tamanho e hash seguido do texto
+typedef struct NameRec {
+    struct NameRec* next;     // Próximo no balde (ou na lista de livres)
+    atomic_int refs;
+    uint32_t hash;
+    unsigned char len;
+    unsigned char size_class; // Tamanho do registro / 8 (lista de livres de origem)
+    char text[];
+} NameRec;
+
+#define NAME_CHUNK_MIN  (4 * 1024)    // Primeiro pedaço da arena; cada novo dobra até o máximo
+#define NAME_CHUNK_MAX  (64 * 1024)
+#define NAME_ALIGN      8
+#define NAME_CLASSES    ((offsetof(NameRec, text) + MAX_NAME_LEN + NAME_ALIGN - 1) / NAME_ALIGN + 1)
+
+// Uma trava para a tabela e a arena: o --build interna nomes de várias threads,
+// mas cada nome entra uma vez só e o trecho protegido é curto
+static pthread_mutex_t name_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static NameRec** name_buckets = NULL;
+static size_t    name_mask = 0;
+static long      name_count = 0;
+static long      name_bytes = 0;
+
+static char*     name_chunks = NULL;  // Lista de pedaços da arena (o primeiro ponteiro encadeia)
+static char*     name_cursor = NULL;
+static size_t    name_left = 0;
+static size_t    name_chunk_size = NAME_CHUNK_MIN;
+static NameRec*  name_free[NAME_CLASSES]; // Registros devolvidos, por tamanho
+
+
+static NameRec* fs_name_rec(const char* name){
+    return (NameRec*)(uintptr_t)(name - offsetof(NameRec, text));
+}
+
+// FNV-1a de 32 bits
+uint32_t fs_name_hash_text(const char* text, size_t len){
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++){
+        h ^= (unsigned char)text[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void fs_name_out_of_memory(void){
+    fprintf(stderr, "Erro ao alocar memoria para nomes\n");
+    exit(EXIT_FAILURE);
+}
+
+// Dobra a tabela quando há mais nomes que baldes
+static void fs_name_grow_table(void){
+    size_t buckets = name_buckets ? (name_mask + 1) * 2 : 64;
+    NameRec** table = (NameRec**)mem_calloc(MEM_NAME, buckets, sizeof(NameRec*));
+    if (!table) fs_name_out_of_memory();
+
+    if (name_buckets){
+        for (size_t b = 0; b <= name_mask; b++){
+            NameRec* rec = name_buckets[b];
+            while (rec){
+                NameRec* next = rec->next;
+                rec->next = table[rec->hash & (buckets - 1)];
+                table[rec->hash & (buckets - 1)] = rec;
+                rec = next;
+            }
+        }
+        mem_free(MEM_NAME, name_buckets);
+    }
+    name_buckets = table;
+    name_mask = buckets - 1;
+}
+
+// Pega um registro da lista de livres do tamanho certo ou do fim da arena
+static NameRec* fs_name_take(size_t size_class){
+    NameRec* rec = name_free[size_class];
+    if (rec){
+        name_free[size_class] = rec->next;
+        return rec;
+    }
+
+    size_t size = size_class * NAME_ALIGN;
+    if (name_left < size){
+        char* chunk = (char*)mem_alloc(MEM_NAME, name_chunk_size);
+        if (!chunk) fs_name_out_of_memory();
+        *(char**)chunk = name_chunks;
+        name_chunks = chunk;
+        name_cursor = chunk + NAME_ALIGN;
+        name_left   = name_chunk_size - NAME_ALIGN;
+        if (name_chunk_size < NAME_CHUNK_MAX) name_chunk_size *= 2;
+    }
+    rec = (NameRec*)(void*)name_cursor;
+    name_cursor += size;
+    name_left   -= size;
+    return rec;
+}
+
+const char* fs_name_intern_len(const char* text, size_t len){
+    if (len > MAX_NAME_LEN - 1) len = MAX_NAME_LEN - 1;
+    uint32_t hash = fs_name_hash_text(text, len);
+
+    pthread_mutex_lock(&name_lock);
+    if (!name_buckets) fs_name_grow_table();
+
+    for (NameRec* rec = name_buckets[hash & name_mask]; rec; rec = rec->next){
+        if (rec->hash == hash && rec->len == len && memcmp(rec->text, text, len) == 0){
+            atomic_fetch_add_explicit(&rec->refs, 1, memory_order_relaxed);
+            pthread_mutex_unlock(&name_lock);
+            return rec->text;
+        }
+    }
+
+    size_t size_class = (offsetof(NameRec, text) + len + 1 + NAME_ALIGN - 1) / NAME_ALIGN;
+    NameRec* rec = fs_name_take(size_class);
+    atomic_init(&rec->refs, 1);
+    rec->hash = hash;
+    rec->len  = (unsigned char)len;
+    rec->size_class = (unsigned char)size_class;
+    memcpy(rec->text, text, len);
+    rec->text[len] = '\0';
+
+    rec->next = name_buckets[hash & name_mask];
+    name_buckets[hash & name_mask] = rec;
+    name_count++;
+    name_bytes += (long)(size_class * NAME_ALIGN);
+    if ((size_t)name_count > name_mask + 1) fs_name_grow_table();
+
+    pthread_mutex_unlock(&name_lock);
+    return rec->text;
+}
+
+void fs_name_reserve(long count){
+    pthread_mutex_lock(&name_lock);
+    if (!name_buckets) fs_name_grow_table();
+    while ((size_t)(name_count + count) > name_mask + 1) fs_name_grow_table();
+    pthread_mutex_unlock(&name_lock);
+}
+
+const char* fs_name_intern(const char* text){
+    return fs_name_intern_len(text, strlen(text));
+}
+
+const char* fs_name_retain(const char* name){
+    if (name) atomic_fetch_add_explicit(&fs_name_rec(name)->refs, 1, memory_order_relaxed);
+    return name;
+}
+
+void fs_name_release(const char* name){
+    if (!name) return;
+    NameRec* rec = fs_name_rec(name);
+
+    pthread_mutex_lock(&name_lock);
+    if (atomic_fetch_sub_explicit(&rec->refs, 1, memory_order_relaxed) == 1){
+        // Última referência: sai da tabela e o espaço fica para o próximo nome do mesmo tamanho
+        NameRec** link = &name_buckets[rec->hash & name_mask];
+        while (*link && *link != rec) link = &(*link)->next;
+        if (*link) *link = rec->next;
+
+        rec->next = name_free[rec->size_class];
+        name_free[rec->size_class] = rec;
+        name_count--;
+        name_bytes -= (long)(rec->size_class * NAME_ALIGN);
+    }
+    pthread_mutex_unlock(&name_lock);
+}
+
+size_t fs_name_len(const char* name){
+    return fs_name_rec(name)->len;
+}
+
+uint32_t fs_name_hash(const char* name){
+    return fs_name_rec(name)->hash;
+}
+
+int fs_name_equals(const char* name, const char* text, size_t len, uint32_t hash){
+    const NameRec* rec = fs_name_rec(name);
+    return rec->hash == hash && rec->len == len && memcmp(rec->text, text, len) == 0;
+}
+
+void fs_name_stats(long* distinct, long* references, long* bytes){
+    long refs = 0;
+
+    pthread_mutex_lock(&name_lock);
+    for (size_t b = 0; name_buckets && b <= name_mask; b++){
+        for (NameRec* rec = name_buckets[b]; rec; rec = rec->next){
+            refs += atomic_load_explicit(&rec->refs, memory_order_relaxed);
+        }
+    }
+    if (distinct) *distinct = name_count;
+    if (bytes)    *bytes    = name_bytes;
+    pthread_mutex_unlock(&name_lock);
+
+    if (references) *references = refs;
+}
+
+void fs_name_shutdown(void){
+    pthread_mutex_lock(&name_lock);
+    while (name_chunks){
+        char* next = *(char**)name_chunks;
+        mem_free(MEM_NAME, name_chunks);
+        name_chunks = next;
+    }
+    mem_free(MEM_NAME, name_buckets);
+    name_buckets = NULL;
+    name_mask = 0;
+    name_count = 0;
+    name_bytes = 0;
+    name_cursor = NULL;
+    name_left = 0;
+    name_chunk_size = NAME_CHUNK_MIN;
+    memset(name_free, 0, sizeof(name_free));
+    pthread_mutex_unlock(&name_lock);
+}
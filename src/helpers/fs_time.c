@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "fs.h"
+#include "fs_time.h"
+#include "snapshot.h"
+
+// Sem o relógio grosso do Linux, usa o relógio comum
+#ifdef CLOCK_REALTIME_COARSE
+#define FS_CLOCK_ID CLOCK_REALTIME_COARSE
+#else
+#define FS_CLOCK_ID CLOCK_REALTIME
+#endif
+
+
+static AtimeMode fs_atime_mode = ATIME_STRICT;
+static int       fs_lazytime   = 0;
+
+// Escrito só entre comandos (thread principal); os construtores em paralelo apenas leem
+static time_t fs_clock = 0;
+
+// Nós com acesso ainda não gravado no FCB
+static FsNode* fs_lazy_nodes[FS_LAZYTIME_BATCH];
+static int     fs_lazy_count = 0;
+
+
+int fs_time_set_options(const char* options){
+    AtimeMode mode = fs_atime_mode;
+    int lazy = fs_lazytime;
+
+    char buffer[128];
+    if (!options || strlen(options) >= sizeof(buffer)) return -1;
+    strcpy(buffer, options);
+
+    for (char* opt = strtok(buffer, ","); opt; opt = strtok(NULL, ",")){
+        if      (strcmp(opt, "strictatime") == 0) mode = ATIME_STRICT;
+        else if (strcmp(opt, "relatime") == 0)    mode = ATIME_RELATIME;
+        else if (strcmp(opt, "noatime") == 0)     mode = ATIME_NOATIME;
+        else if (strcmp(opt, "lazytime") == 0)    lazy = 1;
+        else if (strcmp(opt, "nolazytime") == 0)  lazy = 0;
+        else return -1;
+    }
+
+    if (fs_lazytime && !lazy) fs_time_flush();
+    fs_atime_mode = mode;
+    fs_lazytime   = lazy;
+    return 0;
+}
+
+void fs_time_describe(char* buffer, size_t size){
+    const char* mode = fs_atime_mode == ATIME_NOATIME  ? "noatime"  :
+                       fs_atime_mode == ATIME_RELATIME ? "relatime" : "strictatime";
+    snprintf(buffer, size, "%s%s", mode, fs_lazytime ? ",lazytime" : "");
+}
+
+void fs_clock_tick(void){
+    struct timespec ts;
+    if (clock_gettime(FS_CLOCK_ID, &ts) == 0){
+        fs_clock = ts.tv_sec;
+    } else {
+        fs_clock = time(NULL);
+    }
+}
+
+time_t fs_clock_now(void){
+    if (fs_clock == 0) fs_clock_tick(); // Antes do primeiro comando
+    return fs_clock;
+}
+
+time_t fs_time_accessed(const FsNode* node){
+    if (node->lazy_atime) return node->lazy_atime;
+    return node->fcb ? node->fcb->accessed_at : 0;
+}
+
+// relatime: só vale a pena gravar se o acesso anterior não mostra que o arquivo foi lido
+static int fs_time_needs_access(const FsNode* node, time_t now){
+    switch (fs_atime_mode){
+        case ATIME_NOATIME:
+            return 0;
+        case ATIME_RELATIME: {
+            time_t atime = fs_time_accessed(node);
+            return atime <= node->fcb->modified_at || now - atime >= FS_RELATIME_WINDOW;
+        }
+        case ATIME_STRICT:
+        default:
+            return 1;
+    }
+}
+
+void fs_time_access(FsNode* node){
+    if (!node || !node->fcb) return;
+
+    time_t now = fs_clock_now();
+    if (!fs_time_needs_access(node, now)) return;
+
+    if (!fs_lazytime){
+        snap_touch(node); // O acesso altera o FCB
+        node->fcb->accessed_at = now;
+        return;
+    }
+
+    // lazytime: o horário fica no nó em memória; o FCB só é alterado na gravação em lote
+    if (!node->lazy_atime){
+        if (fs_lazy_count == FS_LAZYTIME_BATCH) fs_time_flush();
+        fs_lazy_nodes[fs_lazy_count++] = node;
+    }
+    node->lazy_atime = now;
+}
+
+void fs_time_modify(FCB* fcb){
+    time_t now = fs_clock_now();
+    fcb->modified_at = now;
+    fcb->accessed_at = now;
+}
+
+// Tira o nó da lista de pendentes, sem gravar
+static void fs_time_unlink(FsNode* node){
+    for (int i = 0; i < fs_lazy_count; i++){
+        if (fs_lazy_nodes[i] == node){
+            fs_lazy_nodes[i] = fs_lazy_nodes[--fs_lazy_count];
+            break;
+        }
+    }
+    node->lazy_atime = 0;
+}
+
+static void fs_time_write_back(FsNode* node){
+    time_t atime = node->lazy_atime;
+    node->lazy_atime = 0;   // Antes do snap_touch, que volta a chamar a gravação
+    if (!node->fcb) return;
+
+    snap_touch(node);
+    if (atime > node->fcb->accessed_at) node->fcb->accessed_at = atime;
+}
+
+void fs_time_flush_node(FsNode* node){
+    if (!node || !node->lazy_atime) return;
+
+    time_t atime = node->lazy_atime;
+    fs_time_unlink(node);
+    node->lazy_atime = atime;
+    fs_time_write_back(node);
+}
+
+int fs_time_flush(void){
+    int written = fs_lazy_count;
+
+    // Esvazia a lista antes: a gravação passa pelo snap_touch
+    FsNode* nodes[FS_LAZYTIME_BATCH];
+    memcpy(nodes, fs_lazy_nodes, (size_t)written * sizeof(FsNode*));
+    fs_lazy_count = 0;
+
+    for (int i = 0; i < written; i++){
+        fs_time_write_back(nodes[i]);
+    }
+    return written;
+}
+
+void fs_time_forget(FsNode* node){
+    if (node && node->lazy_atime) fs_time_unlink(node);
+}
+
+int fs_time_pending(void){
+    return fs_lazy_count;
+}
@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "fs.h"
+#include "blocks.h"
+#include "fs_usage.h"
+
+
+#define USER_CLASSES (USER_OTHER + 1)
+
+// Arquivos na árvore por classe de proprietário (diretórios não têm dono), com as cotas
+static FsUsage user_usage[USER_CLASSES];
+
+
+long fs_usage_file_blocks(const FCB* fcb){
+    if (!fcb || fcb->inlined) return 0;
+    if (fcb->delalloc){
+        // A descarga grava só os blocos com dados da cópia em memória: o total não muda nela
+        return fcb->content ? blocks_count_data(fcb->content, fcb->size)
+                            : (long)((fcb->size + FS_BLOCK_SIZE - 1) / FS_BLOCK_SIZE);
+    }
+    return blocks_allocated(fcb); // Buracos não ocupam o disco
+}
+
+long fs_usage_estimate_blocks(size_t len){
+    if (len == 0 || blocks_inline_fits(len)) return 0;
+    return (long)((len + FS_BLOCK_SIZE - 1) / FS_BLOCK_SIZE);
+}
+
+long fs_usage_truncate_blocks(const FCB* fcb, size_t size){
+    if (!fcb || size <= fcb->size) return 0; // Encolher só solta blocos
+
+    // Estender só cria buracos; no pior caso os dados atuais saem do FCB (inline) para blocos
+    long current = (long)((fcb->size + FS_BLOCK_SIZE - 1) / FS_BLOCK_SIZE);
+    return current - fs_usage_file_blocks(fcb);
+}
+
+// Soma a diferença em dir e em todos os diretórios acima dele
+static void usage_add(FsNode* dir, long bytes, long blocks, long inodes){
+    for (; dir; dir = dir->parent){
+        if (!dir->usage) continue;
+        dir->usage->bytes  += bytes;
+        dir->usage->blocks += blocks;
+        dir->usage->inodes += inodes;
+    }
+}
+
+static void usage_owner_add(const FCB* fcb, long sign){
+    FsUsage* u = &user_usage[fcb->owner];
+    u->bytes  += sign * fcb->usage_bytes;
+    u->blocks += sign * fcb->usage_blocks;
+    u->inodes += sign;
+}
+
+// Contribuição de um nó para os totais do pai
+static void usage_of(const FsNode* node, long* bytes, long* blocks, long* inodes){
+    if (node->usage){
+        *bytes  = node->usage->bytes;
+        *blocks = node->usage->blocks;
+        *inodes = node->usage->inodes + 1;
+    } else if (node->fcb && node->fcb->usage_blocks != FS_USAGE_DETACHED){
+        *bytes  = node->fcb->usage_bytes;
+        *blocks = node->fcb->usage_blocks;
+        *inodes = 1;
+    } else {
+        *bytes = *blocks = 0;
+        *inodes = 1;
+    }
+}
+
+void fs_usage_attach(FsNode* node){
+    if (!node) return;
+
+    FCB* fcb = node->fcb;
+    if (!node->usage && fcb){
+        // O arquivo passa a valer o que ocupa agora (cp e import chegam com os blocos prontos)
+        fcb->usage_bytes  = (long)fcb->size;
+        fcb->usage_blocks = fs_usage_file_blocks(fcb);
+        usage_owner_add(fcb, 1);
+    }
+
+    long bytes, blocks, inodes;
+    usage_of(node, &bytes, &blocks, &inodes);
+    usage_add(node->parent, bytes, blocks, inodes);
+}
+
+// Tira da contagem por proprietário os arquivos de uma subárvore que deixa de existir
+static void usage_forget_files(FsNode* node){
+    if (node->fcb && node->fcb->usage_blocks != FS_USAGE_DETACHED){
+        usage_owner_add(node->fcb, -1);
+        node->fcb->usage_blocks = FS_USAGE_DETACHED;
+    }
+    for (FsNode* child = node->first_child; child; child = child->next_sibling){
+        usage_forget_files(child);
+    }
+}
+
+void fs_usage_detach(FsNode* node, int removing){
+    if (!node) return;
+
+    long bytes, blocks, inodes;
+    usage_of(node, &bytes, &blocks, &inodes);
+    usage_add(node->parent, -bytes, -blocks, -inodes);
+
+    if (node->usage){
+        if (removing) usage_forget_files(node);
+    } else if (node->fcb && node->fcb->usage_blocks != FS_USAGE_DETACHED){
+        // Um arquivo sai das contas até voltar (mv) ou para sempre (rm)
+        usage_owner_add(node->fcb, -1);
+        node->fcb->usage_blocks = FS_USAGE_DETACHED;
+    }
+}
+
+void fs_usage_refresh(FsNode* node){
+    if (!node || !node->fcb) return;
+
+    FCB* fcb = node->fcb;
+    if (fcb->usage_blocks == FS_USAGE_DETACHED) return; // Fora da árvore (descritor de um arquivo apagado)
+
+    long bytes  = (long)fcb->size;
+    long blocks = fs_usage_file_blocks(fcb);
+    long d_bytes  = bytes - fcb->usage_bytes;
+    long d_blocks = blocks - fcb->usage_blocks;
+    if (d_bytes == 0 && d_blocks == 0) return;
+
+    usage_owner_add(fcb, -1);
+    fcb->usage_bytes  = bytes;
+    fcb->usage_blocks = blocks;
+    usage_owner_add(fcb, 1);
+    usage_add(node->parent, d_bytes, d_blocks, 0);
+}
+
+// Recalcula os totais de dir a partir dos filhos (fresh = contagem por dono zerada antes)
+static void usage_recount(FsNode* dir, int fresh){
+    FsUsage* u = dir->usage;
+    u->bytes = u->blocks = u->inodes = 0;
+
+    for (FsNode* child = dir->first_child; child; child = child->next_sibling){
+        FCB* fcb = child->fcb;
+        if (child->usage){
+            usage_recount(child, fresh);
+        } else if (fcb){
+            if (!fresh && fcb->usage_blocks != FS_USAGE_DETACHED) usage_owner_add(fcb, -1);
+            fcb->usage_bytes  = (long)fcb->size;
+            fcb->usage_blocks = fs_usage_file_blocks(fcb);
+            usage_owner_add(fcb, 1);
+        }
+
+        long bytes, blocks, inodes;
+        usage_of(child, &bytes, &blocks, &inodes);
+        u->bytes  += bytes;
+        u->blocks += blocks;
+        u->inodes += inodes;
+    }
+}
+
+void fs_usage_rebuild(FsNode* dir){
+    if (!dir || !dir->usage) return;
+
+    FsUsage before = *dir->usage;
+    int whole = dir->parent == NULL;
+    if (whole){
+        // Árvore inteira (rollback): as cargas guardadas nos FCBs podem ser de outra época
+        for (int i = 0; i < USER_CLASSES; i++){
+            user_usage[i].bytes = user_usage[i].blocks = user_usage[i].inodes = 0;
+        }
+    }
+    usage_recount(dir, whole);
+
+    if (!whole){
+        usage_add(dir->parent, dir->usage->bytes - before.bytes, dir->usage->blocks - before.blocks,
+                  dir->usage->inodes - before.inodes);
+    }
+}
+
+static int usage_exceeds(const FsUsage* u, long blocks, long inodes){
+    return (u->max_blocks > 0 && blocks > 0 && u->blocks + blocks > u->max_blocks) ||
+           (u->max_inodes > 0 && inodes > 0 && u->inodes + inodes > u->max_inodes);
+}
+
+static const FsNode* usage_check_chain(const FsNode* dir, long blocks, long inodes){
+    for (; dir; dir = dir->parent){
+        if (dir->usage && usage_exceeds(dir->usage, blocks, inodes)) return dir;
+    }
+    return NULL;
+}
+
+int fs_usage_check(const FsNode* dir, UserClass owner, long blocks, long inodes, const FsNode** over){
+    if (over) *over = NULL;
+    if (blocks <= 0 && inodes <= 0) return 0;
+
+    // Diretórios não têm dono: a cota do usuário só conta arquivos
+    if (owner != FS_USAGE_NO_OWNER && usage_exceeds(&user_usage[owner], blocks, inodes)) return -1;
+
+    const FsNode* full = usage_check_chain(dir, blocks, inodes);
+    if (over) *over = full;
+    return full ? -1 : 0;
+}
+
+int fs_usage_check_move(FsNode* node, FsNode* new_parent, const FsNode** over){
+    if (over) *over = NULL;
+
+    long bytes, blocks, inodes;
+    usage_of(node, &bytes, &blocks, &inodes);
+
+    // Tira a subárvore dos ancestrais atuais só durante a conferência: os ancestrais
+    // comuns aos dois caminhos não ganham nada com o mv
+    usage_add(node->parent, -bytes, -blocks, -inodes);
+    const FsNode* full = usage_check_chain(new_parent, blocks, inodes);
+    usage_add(node->parent, bytes, blocks, inodes);
+
+    if (over) *over = full;
+    return full ? -1 : 0;
+}
+
+void fs_usage_get(const FsNode* node, FsUsage* out){
+    memset(out, 0, sizeof(*out));
+    if (!node) return;
+
+    if (node->usage){
+        *out = *node->usage;
+    } else if (node->fcb){
+        out->bytes  = (long)node->fcb->size;
+        out->blocks = fs_usage_file_blocks(node->fcb);
+        out->inodes = 1;
+    }
+}
+
+void fs_usage_set_quota(FsNode* dir, long max_blocks, long max_inodes){
+    if (!dir || !dir->usage) return;
+    dir->usage->max_blocks = max_blocks > 0 ? max_blocks : 0;
+    dir->usage->max_inodes = max_inodes > 0 ? max_inodes : 0;
+}
+
+void fs_usage_set_user_quota(UserClass owner, long max_blocks, long max_inodes){
+    user_usage[owner].max_blocks = max_blocks > 0 ? max_blocks : 0;
+    user_usage[owner].max_inodes = max_inodes > 0 ? max_inodes : 0;
+}
+
+void fs_usage_user(UserClass owner, FsUsage* out){
+    *out = user_usage[owner];
+}
+
+void fs_usage_shutdown(void){
+    memset(user_usage, 0, sizeof(user_usage));
+}
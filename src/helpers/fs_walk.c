@@ -0,0 +1,107 @@
+#include <stddef.h>
+
+#include "fs.h"
+#include "fs_walk.h"
+
+
+// Desce sempre pelo primeiro filho até chegar em uma folha
+static FsNode* walk_leftmost_leaf(FsNode* node, int* depth){
+    while (node->first_child){
+        node = node->first_child;
+        (*depth)++;
+    }
+    return node;
+}
+
+void fs_walk_begin(FsWalk* walk, FsNode* root, FsWalkOrder order){
+    walk->root       = root;
+    walk->current    = NULL;
+    walk->next       = NULL;
+    walk->order      = order;
+    walk->depth      = 0;
+    walk->next_depth = 0;
+    walk->prune      = 0;
+    walk->started    = 0;
+
+    if (root && order == FS_WALK_POSTORDER){
+        walk->next = walk_leftmost_leaf(root, &walk->next_depth); // Primeiro nó a ser entregue
+    }
+}
+
+// Pré-ordem: calcula o próximo nó a partir do último entregue
+static FsNode* walk_next_preorder(FsWalk* walk){
+    if (!walk->started){
+        walk->started = 1;
+        walk->current = walk->root;
+        walk->depth   = 0;
+        return walk->current;
+    }
+
+    FsNode* node = walk->current;
+    if (!node){
+        return NULL; // Percurso já terminou
+    }
+
+    // Desce para o primeiro filho, a menos que o chamador tenha podado
+    if (!walk->prune && node->first_child){
+        walk->current = node->first_child;
+        walk->depth++;
+        return walk->current;
+    }
+    walk->prune = 0;
+
+    // Sem filhos: procura o próximo irmão subindo pelos pais
+    while (node != walk->root){
+        if (node->next_sibling){
+            walk->current = node->next_sibling;
+            return walk->current;
+        }
+        node = node->parent;
+        walk->depth--;
+    }
+
+    walk->current = NULL;
+    return NULL;
+}
+
+// Pós-ordem: o sucessor é calculado antes de entregar o nó,
+// assim o chamador pode liberar o nó recebido com segurança
+static FsNode* walk_next_postorder(FsWalk* walk){
+    FsNode* node = walk->next;
+    if (!node){
+        walk->current = NULL;
+        return NULL;
+    }
+
+    walk->current = node;
+    walk->depth   = walk->next_depth;
+
+    if (node == walk->root){
+        walk->next = NULL; // A raíz é sempre o último nó
+    } else if (node->next_sibling){
+        walk->next = walk_leftmost_leaf(node->next_sibling, &walk->next_depth);
+    } else {
+        walk->next = node->parent;
+        walk->next_depth--;
+    }
+    return node;
+}
+
+FsNode* fs_walk_next(FsWalk* walk){
+    if (!walk || !walk->root) return NULL;
+
+    if (walk->order == FS_WALK_POSTORDER){
+        return walk_next_postorder(walk);
+    }
+    return walk_next_preorder(walk);
+}
+
+void fs_walk_prune(FsWalk* walk){
+    if (walk && walk->order == FS_WALK_PREORDER){
+        walk->prune = 1;
+    }
+}
+
+int fs_walk_depth(const FsWalk* walk){
+    return walk ? walk->depth : 0;
+}
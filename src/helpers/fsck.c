@@ -0,0 +1,406 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "fs.h"
+#include "blocks.h"
+#include "fcb_helpers.h"
+#include "snapshot.h"
+#include "delalloc.h"
+#include "thread_pool.h"
+#include "fsck.h"
+#include "fs_usage.h"
+#include "mem.h"
+
+#define FSCK_TASKS_PER_THREAD 8   // Subárvores por thread (equilíbrio de carga)
+
+
+// FCB que precisa de reparo (guardado durante o percurso paralelo)
+typedef struct {
+    FCB* fcb;
+    int  kind;
+} FsckIssue;
+
+enum { FSCK_ISSUE_SHORT, FSCK_ISSUE_DUP_INODE, FSCK_ISSUE_BAD_REF };
+
+typedef struct {
+    atomic_int*     expected;     // Donos de cada bloco, reconstruídos a partir dos FCBs
+    int             total_blocks;
+    _Atomic uint64_t* inode_seen; // Mapa de bits dos inodes já vistos
+    int             max_inode;
+    int             repair;
+
+    atomic_long     nodes, dirs, files;
+    atomic_long     bad_block_refs, short_files, duplicate_inodes, bad_inodes, bad_links;
+    atomic_long     relinked;     // Ponteiros parent corrigidos durante o percurso
+
+    pthread_mutex_t lock;         // Protege a lista de reparos
+    FsckIssue*      issues;
+    size_t          issue_count;
+    size_t          issue_cap;
+} FsckCtx;
+
+typedef struct {
+    FsckCtx* ctx;
+    FsNode*  dir;
+} FsckJob;
+
+
+static double fsck_now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void fsck_note(FsckCtx* ctx, FCB* fcb, int kind){
+    if (!ctx->repair) return;
+
+    pthread_mutex_lock(&ctx->lock);
+    if (ctx->issue_count == ctx->issue_cap){
+        size_t cap = ctx->issue_cap ? ctx->issue_cap * 2 : 64;
+        FsckIssue* grown = (FsckIssue*)realloc(ctx->issues, cap * sizeof(FsckIssue));
+        if (!grown){
+            pthread_mutex_unlock(&ctx->lock);
+            return; // Sem memória: o problema é contado, mas não reparado
+        }
+        ctx->issues = grown;
+        ctx->issue_cap = cap;
+    }
+    ctx->issues[ctx->issue_count].fcb  = fcb;
+    ctx->issues[ctx->issue_count].kind = kind;
+    ctx->issue_count++;
+    pthread_mutex_unlock(&ctx->lock);
+}
+
+// Conta os donos dos blocos de um FCB
+static void fsck_count_blocks(FsckCtx* ctx, const FCB* fcb, int* bad_ref){
+    if (fcb->inlined) return;
+
+    int count = fcb->block_count;
+    int capacity = fcb_map_capacity(fcb);
+    if (count < 0 || count > capacity){
+        *bad_ref = 1;
+        count = count < 0 ? 0 : capacity;
+    }
+
+    const int* blocks = fcb_blocks(fcb);
+    for (int i = 0; i < count; i++){
+        int idx = blocks[i];
+        if (idx == FS_BLOCK_HOLE) continue; // Buraco de arquivo esparso: nenhum bloco
+        if (idx < 0 || idx >= ctx->total_blocks){
+            *bad_ref = 1;
+            continue;
+        }
+        atomic_fetch_add_explicit(&ctx->expected[idx], 1, memory_order_relaxed);
+    }
+}
+
+static void fsck_check_fcb(FsckCtx* ctx, FCB* fcb){
+    int bad_ref = 0;
+    fsck_count_blocks(ctx, fcb, &bad_ref);
+    if (bad_ref){
+        atomic_fetch_add(&ctx->bad_block_refs, 1);
+        fsck_note(ctx, fcb, FSCK_ISSUE_BAD_REF);
+    }
+
+    // O mapa precisa cobrir o arquivo (falha de alocação deixa o FCB sem dados)
+    size_t mapped = fcb->compressed ? blocks_physical_size(fcb) : fcb->size;
+    int covered = fcb->inlined ? fcb->size <= (size_t)FCB_INLINE_MAX
+                               : (size_t)fcb->block_count * FS_BLOCK_SIZE >= mapped;
+    if (!covered){
+        atomic_fetch_add(&ctx->short_files, 1);
+        fsck_note(ctx, fcb, FSCK_ISSUE_SHORT);
+    }
+
+    int inode = fcb->inode;
+    if (inode < 1 || inode > ctx->max_inode){
+        atomic_fetch_add(&ctx->bad_inodes, 1);
+        fsck_note(ctx, fcb, FSCK_ISSUE_DUP_INODE);
+        return;
+    }
+
+    uint64_t bit = (uint64_t)1 << (inode & 63);
+    uint64_t old = atomic_fetch_or_explicit(&ctx->inode_seen[inode >> 6], bit, memory_order_relaxed);
+    if (old & bit){
+        atomic_fetch_add(&ctx->duplicate_inodes, 1);
+        fsck_note(ctx, fcb, FSCK_ISSUE_DUP_INODE);
+    }
+}
+
+// Confere os filhos diretos de um diretório
+static void fsck_check_children(FsckCtx* ctx, FsNode* dir, long* nodes, long* dirs, long* files){
+    for (FsNode* child = dir->first_child; child; child = child->next_sibling){
+        (*nodes)++;
+
+        if (child->parent != dir){
+            atomic_fetch_add(&ctx->bad_links, 1);
+            if (ctx->repair){
+                child->parent = dir; // Cada diretório pertence a uma única tarefa
+                atomic_fetch_add(&ctx->relinked, 1);
+            }
+        }
+
+        if (child->type == NODE_DIR){
+            (*dirs)++;
+        } else {
+            (*files)++;
+            if (child->first_child){
+                atomic_fetch_add(&ctx->bad_links, 1); // Arquivo com filhos
+            }
+            if (child->fcb) fsck_check_fcb(ctx, child->fcb);
+        }
+    }
+}
+
+// Percorre uma subárvore com pilha explícita (não confia nos ponteiros parent)
+static void fsck_walk_subtree(FsckCtx* ctx, FsNode* root){
+    long nodes = 0, dirs = 0, files = 0;
+
+    size_t cap = 64, top = 0;
+    FsNode** stack = (FsNode**)malloc(cap * sizeof(FsNode*));
+    if (!stack) return;
+    stack[top++] = root;
+
+    while (top > 0){
+        FsNode* dir = stack[--top];
+        fsck_check_children(ctx, dir, &nodes, &dirs, &files);
+
+        for (FsNode* child = dir->first_child; child; child = child->next_sibling){
+            if (child->type != NODE_DIR) continue;
+            if (top == cap){
+                FsNode** grown = (FsNode**)realloc(stack, cap * 2 * sizeof(FsNode*));
+                if (!grown) break;
+                stack = grown;
+                cap *= 2;
+            }
+            stack[top++] = child;
+        }
+    }
+    free(stack);
+
+    atomic_fetch_add(&ctx->nodes, nodes);
+    atomic_fetch_add(&ctx->dirs, dirs);
+    atomic_fetch_add(&ctx->files, files);
+}
+
+static void fsck_task(void* arg){
+    FsckJob* job = (FsckJob*)arg;
+    fsck_walk_subtree(job->ctx, job->dir);
+    free(job);
+}
+
+// Desce pela árvore em largura até ter subárvores suficientes para as threads.
+// Os níveis visitados aqui são conferidos pela thread principal.
+static int fsck_split(FsckCtx* ctx, FsNode* root, size_t wanted, FsNode*** out, size_t* out_count){
+    long nodes = 1, dirs = 1, files = 0; // Conta a raiz
+    size_t count = 1, cap = 16;
+    FsNode** level = (FsNode**)malloc(cap * sizeof(FsNode*));
+    if (!level) return -1;
+    level[0] = root;
+
+    while (count > 0 && count < wanted){
+        size_t next_count = 0, next_cap = 16;
+        FsNode** next = (FsNode**)malloc(next_cap * sizeof(FsNode*));
+        if (!next){ free(level); return -1; }
+
+        for (size_t i = 0; i < count; i++){
+            fsck_check_children(ctx, level[i], &nodes, &dirs, &files);
+            for (FsNode* child = level[i]->first_child; child; child = child->next_sibling){
+                if (child->type != NODE_DIR) continue;
+                if (next_count == next_cap){
+                    FsNode** grown = (FsNode**)realloc(next, next_cap * 2 * sizeof(FsNode*));
+                    if (!grown){ free(next); free(level); return -1; }
+                    next = grown;
+                    next_cap *= 2;
+                }
+                next[next_count++] = child;
+            }
+        }
+        free(level);
+        level = next;
+        count = next_count;
+    }
+
+    atomic_fetch_add(&ctx->nodes, nodes);
+    atomic_fetch_add(&ctx->dirs, dirs);
+    atomic_fetch_add(&ctx->files, files);
+
+    *out = level;
+    *out_count = count;
+    return 0;
+}
+
+static void fsck_count_snapshot_fcb(const FCB* fcb, void* arg){
+    int bad_ref = 0;
+    fsck_count_blocks((FsckCtx*)arg, fcb, &bad_ref);
+}
+
+// Troca os índices inválidos do FCB por buracos: os demais blocos continuam na posição
+static void fsck_drop_bad_refs(FCB* fcb, int total_blocks){
+    if (fcb->inlined) return;
+
+    int count = fcb->block_count;
+    int capacity = fcb_map_capacity(fcb);
+    if (count < 0) count = 0;
+    if (count > capacity) count = capacity;
+
+    int* blocks = fcb_blocks(fcb);
+    for (int i = 0; i < count; i++){
+        int idx = blocks[i];
+        if (idx < 0 || idx >= total_blocks) blocks[i] = FS_BLOCK_HOLE;
+    }
+    for (int i = count; i < capacity; i++) blocks[i] = FS_BLOCK_HOLE;
+    fcb->block_count = count;
+}
+
+// Arquivo sem blocos suficientes: regrava a partir da cópia em memória ou trunca
+static void fsck_fix_short_file(FCB* fcb){
+    if (fcb->content && fcb->size <= blocks_max_file_size() &&
+        blocks_alloc_for_file(fcb, fcb->content, fcb->size) == 0){
+        return;
+    }
+
+    // Os blocos passam a valer; a cópia em memória pode não ter o tamanho registrado
+    size_t covered = fcb->compressed ? 0 : (size_t)fcb->block_count * FS_BLOCK_SIZE;
+    if (covered == 0){
+        blocks_free_for_file(fcb);
+    }
+    if (fcb->size > covered) fcb->size = covered;
+    mem_free(MEM_CONTENT, fcb->content);
+    fcb->content = NULL;
+}
+
+long fsck_run(FsNode* root, int threads, int repair, FsckReport* report){
+    if (!root || !report) return -1;
+    memset(report, 0, sizeof(*report));
+    delalloc_flush(); // Arquivos pendentes ainda não têm blocos para conferir
+
+    double start = fsck_now();
+
+    FsckCtx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.total_blocks = blocks_total();
+    ctx.max_inode    = fcb_inode_high_water();
+    ctx.repair       = repair;
+    pthread_mutex_init(&ctx.lock, NULL);
+
+    size_t words = (size_t)ctx.max_inode / 64 + 1;
+    ctx.expected   = (atomic_int*)malloc((size_t)ctx.total_blocks * sizeof(atomic_int));
+    ctx.inode_seen = (_Atomic uint64_t*)malloc(words * sizeof(uint64_t));
+    if (!ctx.expected || !ctx.inode_seen){
+        free(ctx.expected);
+        free((void*)ctx.inode_seen);
+        pthread_mutex_destroy(&ctx.lock);
+        return -1;
+    }
+    for (int i = 0; i < ctx.total_blocks; i++) atomic_init(&ctx.expected[i], 0);
+    for (size_t i = 0; i < words; i++) atomic_init(&ctx.inode_seen[i], 0);
+
+    ThreadPool* pool = tp_create(threads);
+    if (!pool){
+        free(ctx.expected);
+        free((void*)ctx.inode_seen);
+        pthread_mutex_destroy(&ctx.lock);
+        return -1;
+    }
+    report->threads = tp_size(pool);
+
+    // 1) Reconstrói o mapa de donos percorrendo a árvore em paralelo
+    FsNode** subtrees = NULL;
+    size_t subtree_count = 0;
+    long result = 0;
+    if (fsck_split(&ctx, root, (size_t)report->threads * FSCK_TASKS_PER_THREAD,
+                   &subtrees, &subtree_count) != 0){
+        result = -1;
+    }
+
+    for (size_t i = 0; i < subtree_count && result == 0; i++){
+        FsckJob* job = (FsckJob*)malloc(sizeof(FsckJob));
+        if (!job){
+            fsck_walk_subtree(&ctx, subtrees[i]); // Sem memória: confere aqui mesmo
+            continue;
+        }
+        job->ctx = &ctx;
+        job->dir = subtrees[i];
+        if (tp_submit(pool, fsck_task, job) != 0){
+            fsck_task(job);
+        }
+    }
+    tp_wait(pool);
+    tp_destroy(pool);
+    free(subtrees);
+
+    // Os snapshots também são donos de blocos
+    snap_for_each_fcb(fsck_count_snapshot_fcb, &ctx);
+
+    if (result == 0){
+        report->nodes            = atomic_load(&ctx.nodes);
+        report->dirs             = atomic_load(&ctx.dirs);
+        report->files            = atomic_load(&ctx.files);
+        report->bad_block_refs   = atomic_load(&ctx.bad_block_refs);
+        report->short_files      = atomic_load(&ctx.short_files);
+        report->duplicate_inodes = atomic_load(&ctx.duplicate_inodes);
+        report->bad_inodes       = atomic_load(&ctx.bad_inodes);
+        report->bad_links        = atomic_load(&ctx.bad_links);
+        report->blocks           = ctx.total_blocks;
+
+        // 2) Compara com o mapa de ocupação
+        for (int i = 0; i < ctx.total_blocks; i++){
+            int expected = atomic_load_explicit(&ctx.expected[i], memory_order_relaxed);
+            int actual   = blocks_refcount(i);
+            if (expected == actual) continue;
+
+            if (expected == 0)      report->leaked_blocks++;
+            else if (actual == 0)   report->unmarked_blocks++;
+            else                    report->refcount_mismatch++;
+
+            if (repair){
+                blocks_set_refcount(i, expected);
+                report->repaired++;
+            }
+        }
+
+        // 3) Reparos que dependem do mapa já corrigido
+        if (repair){
+            // Um FCB pode aparecer com mais de um problema: índices inválidos saem primeiro
+            static const int order[] = { FSCK_ISSUE_BAD_REF, FSCK_ISSUE_SHORT, FSCK_ISSUE_DUP_INODE };
+            for (int pass = 0; pass < 3; pass++){
+                for (size_t i = 0; i < ctx.issue_count; i++){
+                    if (ctx.issues[i].kind != order[pass]) continue;
+
+                    FCB* fcb = ctx.issues[i].fcb;
+                    switch (order[pass]){
+                        case FSCK_ISSUE_BAD_REF:
+                            fsck_drop_bad_refs(fcb, ctx.total_blocks);
+                            break;
+                        case FSCK_ISSUE_SHORT:
+                            fsck_fix_short_file(fcb);
+                            break;
+                        case FSCK_ISSUE_DUP_INODE:
+                            fcb->inode = fcb_next_inode();
+                            break;
+                    }
+                    report->repaired++;
+                }
+            }
+            report->repaired += atomic_load(&ctx.relinked);
+            if (report->repaired > 0) fs_usage_rebuild(root); // Reparos mudam tamanhos e blocos
+        }
+
+        result = report->leaked_blocks + report->unmarked_blocks + report->refcount_mismatch +
+                 report->bad_block_refs + report->short_files + report->duplicate_inodes +
+                 report->bad_inodes + report->bad_links;
+    }
+
+    free(ctx.issues);
+    free(ctx.expected);
+    free((void*)ctx.inode_seen);
+    pthread_mutex_destroy(&ctx.lock);
+
+    report->seconds = fsck_now() - start;
+    return result;
+}
@@ -0,0 +1,141 @@
+#include <string.h>
+#include <stdint.h>
+
+#include "lz.h"
+
+#define LZ_HASH_BITS 12
+#define LZ_MAX_OFFSET 65535
+
+
+static uint32_t lz_read32(const char* p){
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static unsigned lz_hash(uint32_t v){
+    return (v * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+// Escreve a parte estendida de um comprimento (bytes 255 + resto)
+static int lz_put_length(char** op, const char* end, size_t value){
+    while (value >= 255){
+        if (*op >= end) return -1;
+        *(*op)++ = (char)255;
+        value -= 255;
+    }
+    if (*op >= end) return -1;
+    *(*op)++ = (char)value;
+    return 0;
+}
+
+// Emite uma sequência: literais seguidos (opcionalmente) de um match
+static int lz_emit(char** op, const char* end, const char* lit, size_t lit_len,
+                   size_t offset, size_t match_len){
+    if (*op >= end) return -1;
+
+    size_t match_code = match_len ? match_len - LZ_MIN_MATCH : 0;
+    char* token = (*op)++;
+    *token = (char)(((lit_len < 15 ? lit_len : 15) << 4) | (match_code < 15 ? match_code : 15));
+
+    if (lit_len >= 15 && lz_put_length(op, end, lit_len - 15) != 0) return -1;
+
+    if ((size_t)(end - *op) < lit_len) return -1;
+    memcpy(*op, lit, lit_len);
+    *op += lit_len;
+
+    if (match_len == 0) return 0; // Última sequência: só literais
+
+    if (end - *op < 2) return -1;
+    *(*op)++ = (char)(offset & 0xFF);
+    *(*op)++ = (char)(offset >> 8);
+
+    if (match_code >= 15 && lz_put_length(op, end, match_code - 15) != 0) return -1;
+    return 0;
+}
+
+size_t lz_compress(const char* src, size_t len, char* dst, size_t cap){
+    int table[1 << LZ_HASH_BITS]; // Última posição (+1) vista para cada hash de 4 bytes
+    memset(table, 0, sizeof(table));
+
+    char* op = dst;
+    const char* end = dst + cap;
+    size_t anchor = 0;
+    size_t ip = 0;
+
+    while (ip + LZ_MIN_MATCH <= len){
+        uint32_t seq = lz_read32(src + ip);
+        unsigned h = lz_hash(seq);
+        long ref = (long)table[h] - 1;
+        table[h] = (int)ip + 1;
+
+        if (ref < 0 || ip - (size_t)ref > LZ_MAX_OFFSET || lz_read32(src + ref) != seq){
+            ip++;
+            continue;
+        }
+
+        size_t match_len = LZ_MIN_MATCH;
+        while (ip + match_len < len && src[ref + match_len] == src[ip + match_len]){
+            match_len++;
+        }
+
+        if (lz_emit(&op, end, src + anchor, ip - anchor, ip - (size_t)ref, match_len) != 0){
+            return 0;
+        }
+        ip += match_len;
+        anchor = ip;
+    }
+
+    if (lz_emit(&op, end, src + anchor, len - anchor, 0, 0) != 0){
+        return 0;
+    }
+    return (size_t)(op - dst);
+}
+
+// Lê a parte estendida de um comprimento
+static int lz_get_length(const unsigned char** ip, const unsigned char* end, size_t* value){
+    unsigned char b;
+    do {
+        if (*ip >= end) return -1;
+        b = *(*ip)++;
+        *value += b;
+    } while (b == 255);
+    return 0;
+}
+
+long lz_decompress(const char* src, size_t len, char* dst, size_t cap){
+    const unsigned char* ip  = (const unsigned char*)src;
+    const unsigned char* end = ip + len;
+    size_t out = 0;
+
+    while (ip < end){
+        unsigned token = *ip++;
+
+        size_t lit_len = token >> 4;
+        if (lit_len == 15 && lz_get_length(&ip, end, &lit_len) != 0) return -1;
+        if ((size_t)(end - ip) < lit_len || cap - out < lit_len) return -1;
+        memcpy(dst + out, ip, lit_len);
+        ip  += lit_len;
+        out += lit_len;
+
+        if (ip == end) break; // Última sequência não tem match
+
+        if (end - ip < 2) return -1;
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+
+        size_t match_len = token & 15;
+        if (match_len == 15 && lz_get_length(&ip, end, &match_len) != 0) return -1;
+        match_len += LZ_MIN_MATCH;
+
+        if (offset == 0 || offset > out || cap - out < match_len) return -1;
+
+        // Cópia byte a byte: o match pode sobrepor a própria saída (repetições)
+        const char* ref = dst + out - offset;
+        for (size_t i = 0; i < match_len; i++){
+            dst[out + i] = ref[i];
+        }
+        out += match_len;
+    }
+    return (long)out;
+}
@@ -0,0 +1,80 @@
+#include <stdlib.h>
+#include <malloc.h>
+#include <stdatomic.h>
+
+#include "mem.h"
+
+// Cada categoria em sua própria linha de cache: threads do --build contam nós e FCBs ao mesmo tempo
+typedef struct {
+    _Alignas(64) atomic_long bytes;
+    atomic_long count;
+} MemCounter;
+
+static MemCounter mem_counters[MEM_TAG_COUNT];
+static _Alignas(64) atomic_long mem_total;
+static atomic_long mem_peak;
+
+static const char* mem_tag_names[MEM_TAG_COUNT] = {
+    "nos", "fcbs", "conteudo", "disco", "indice dedup", "snapshots", "trace", "nomes", "totais dir"
+};
+
+
+const char* mem_tag_name(MemTag tag){
+    return (tag >= 0 && tag < MEM_TAG_COUNT) ? mem_tag_names[tag] : "?";
+}
+
+// O tamanho vem do próprio malloc (malloc_usable_size), então não há cabeçalho extra
+static void mem_account(MemTag tag, long bytes, long count){
+    MemCounter* c = &mem_counters[tag];
+    atomic_fetch_add_explicit(&c->bytes, bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->count, count, memory_order_relaxed);
+
+    long total = atomic_fetch_add_explicit(&mem_total, bytes, memory_order_relaxed) + bytes;
+    if (bytes <= 0) return;
+
+    long peak = atomic_load_explicit(&mem_peak, memory_order_relaxed);
+    while (total > peak &&
+           !atomic_compare_exchange_weak_explicit(&mem_peak, &peak, total,
+                                                  memory_order_relaxed, memory_order_relaxed)){
+    }
+}
+
+void* mem_alloc(MemTag tag, size_t size){
+    void* ptr = malloc(size);
+    if (ptr) mem_account(tag, (long)malloc_usable_size(ptr), 1);
+    return ptr;
+}
+
+void* mem_calloc(MemTag tag, size_t count, size_t size){
+    void* ptr = calloc(count, size);
+    if (ptr) mem_account(tag, (long)malloc_usable_size(ptr), 1);
+    return ptr;
+}
+
+void* mem_realloc(MemTag tag, void* ptr, size_t size){
+    long old = ptr ? (long)malloc_usable_size(ptr) : 0;
+    void* grown = realloc(ptr, size);
+    if (!grown) return NULL; // O bloco antigo continua válido e contado
+
+    mem_account(tag, (long)malloc_usable_size(grown) - old, ptr ? 0 : 1);
+    return grown;
+}
+
+void mem_free(MemTag tag, void* ptr){
+    if (!ptr) return;
+    mem_account(tag, -(long)malloc_usable_size(ptr), -1);
+    free(ptr);
+}
+
+size_t mem_capacity(const void* ptr){
+    return ptr ? malloc_usable_size((void*)ptr) : 0;
+}
+
+void mem_stats(MemTagStats stats[MEM_TAG_COUNT], long* total, long* peak){
+    for (int i = 0; i < MEM_TAG_COUNT; i++){
+        stats[i].bytes = atomic_load_explicit(&mem_counters[i].bytes, memory_order_relaxed);
+        stats[i].count = atomic_load_explicit(&mem_counters[i].count, memory_order_relaxed);
+    }
+    if (total) *total = atomic_load_explicit(&mem_total, memory_order_relaxed);
+    if (peak)  *peak  = atomic_load_explicit(&mem_peak, memory_order_relaxed);
+}
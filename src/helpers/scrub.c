@@ -0,0 +1,225 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "fs.h"
+#include "blocks.h"
+#include "thread_pool.h"
+#include "scrub.h"
+
+#define SCRUB_CHUNK 64          // Blocos reservados por vez por cada thread
+#define SCRUB_NAP   0.05        // Maior pausa de uma vez (o cancelamento é visto entre elas)
+
+
+typedef struct {
+    ThreadPool*  pool;          // Vivo do início até o resultado ser recolhido
+    int          started;       // Algum job já foi iniciado
+    int          reported;      // O resultado do último job já foi mostrado
+    int          total;
+    long         rate_limit;
+    double       start;
+    atomic_int   next;          // Próximo bloco ainda não reservado
+    atomic_int   active;        // Threads (e o submissor) que ainda não terminaram
+    atomic_int   cancel;
+    atomic_int   finished;
+    atomic_long  scanned;
+    atomic_long  checked;
+    atomic_long  sealed;
+    atomic_long  errors;
+    pthread_mutex_t lock;       // Protege a lista de blocos corrompidos e o tempo final
+    ScrubStats   result;
+} ScrubCtx;
+
+static ScrubCtx scrub_ctx = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+
+static double scrub_now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Dorme até o instante em que 'done' blocos percorridos estão dentro do limite de vazão
+static void scrub_pace(ScrubCtx* ctx, long done){
+    if (ctx->rate_limit <= 0) return;
+
+    for (;;){
+        double wait = ctx->start + (double)done / (double)ctx->rate_limit - scrub_now();
+        if (wait <= 0.0 || atomic_load(&ctx->cancel)) return;
+        if (wait > SCRUB_NAP) wait = SCRUB_NAP;
+
+        struct timespec ts;
+        ts.tv_sec  = (time_t)wait;
+        ts.tv_nsec = (long)((wait - (double)ts.tv_sec) * 1e9);
+        while (nanosleep(&ts, &ts) != 0 && errno == EINTR){}
+    }
+}
+
+static void scrub_record(ScrubCtx* ctx, int block_index){
+    long n = atomic_fetch_add(&ctx->errors, 1);
+    if (n < SCRUB_MAX_REPORTED){
+        pthread_mutex_lock(&ctx->lock);
+        ctx->result.bad_blocks[n] = block_index;
+        pthread_mutex_unlock(&ctx->lock);
+    }
+}
+
+// Quem sai por último fecha o job
+static void scrub_leave(ScrubCtx* ctx, int count){
+    if (atomic_fetch_sub(&ctx->active, count) != count) return;
+
+    pthread_mutex_lock(&ctx->lock);
+    ctx->result.seconds = scrub_now() - ctx->start;
+    pthread_mutex_unlock(&ctx->lock);
+    atomic_store_explicit(&ctx->finished, 1, memory_order_release);
+}
+
+// Cada thread reserva fatias do disco até acabar (ou o job ser cancelado)
+static void scrub_worker(void* arg){
+    ScrubCtx* ctx = (ScrubCtx*)arg;
+
+    while (!atomic_load(&ctx->cancel)){
+        int first = atomic_fetch_add(&ctx->next, SCRUB_CHUNK);
+        if (first >= ctx->total) break;
+
+        int last = first + SCRUB_CHUNK < ctx->total ? first + SCRUB_CHUNK : ctx->total;
+        long checked = 0, sealed = 0;
+
+        // Nenhum comando muda a fatia enquanto ela é conferida
+        blocks_lock();
+        blocks_fetch_range(first, last - first); // Com imagem: a fatia vem em um lote
+        for (int i = first; i < last; i++){
+            if (blocks_refcount(i) == 0) continue; // Só blocos alocados
+            checked++;
+            int result = blocks_verify_block(i);
+            if (result < 0){
+                scrub_record(ctx, i);
+            } else if (result > 0){
+                sealed++;
+            }
+        }
+        blocks_unlock();
+
+        atomic_fetch_add(&ctx->checked, checked);
+        atomic_fetch_add(&ctx->sealed, sealed);
+        atomic_fetch_add(&ctx->scanned, last - first);
+
+        // Segura a thread (fora da trava) até a vazão acumulada voltar ao limite
+        scrub_pace(ctx, (long)last);
+    }
+    scrub_leave(ctx, 1);
+}
+
+// Espera as threads e libera o pool do job que terminou
+static void scrub_reap(ScrubCtx* ctx){
+    if (!ctx->pool) return;
+    tp_destroy(ctx->pool);
+    ctx->pool = NULL;
+}
+
+static void scrub_fill(ScrubCtx* ctx, ScrubStats* stats){
+    int finished = atomic_load_explicit(&ctx->finished, memory_order_acquire);
+
+    pthread_mutex_lock(&ctx->lock);
+    *stats = ctx->result;
+    pthread_mutex_unlock(&ctx->lock);
+
+    stats->running   = !finished;
+    stats->cancelled = atomic_load(&ctx->cancel);
+    stats->total     = ctx->total;
+    stats->scanned   = atomic_load(&ctx->scanned);
+    stats->checked   = atomic_load(&ctx->checked);
+    stats->sealed    = atomic_load(&ctx->sealed);
+    stats->errors    = atomic_load(&ctx->errors);
+    if (!finished) stats->seconds = scrub_now() - ctx->start;
+}
+
+int scrub_start(int threads, long rate_limit){
+    ScrubCtx* ctx = &scrub_ctx;
+    if (!blocks_checksums_enabled()) return -1;
+
+    if (ctx->pool){
+        if (!atomic_load_explicit(&ctx->finished, memory_order_acquire)) return -1; // Já em andamento
+        scrub_reap(ctx);
+    }
+
+    ThreadPool* pool = tp_create(threads);
+    if (!pool) return -1;
+
+    int workers = tp_size(pool);
+    ctx->pool       = pool;
+    ctx->started    = 1;
+    ctx->reported   = 0;
+    ctx->total      = blocks_total();
+    ctx->rate_limit = rate_limit;
+    ctx->start      = scrub_now();
+    memset(&ctx->result, 0, sizeof(ctx->result));
+    ctx->result.threads = workers;
+    atomic_store(&ctx->next, 0);
+    atomic_store(&ctx->active, workers + 1); // O submissor também conta até terminar de enfileirar
+    atomic_store(&ctx->cancel, 0);
+    atomic_store(&ctx->finished, 0);
+    atomic_store(&ctx->scanned, 0);
+    atomic_store(&ctx->checked, 0);
+    atomic_store(&ctx->sealed, 0);
+    atomic_store(&ctx->errors, 0);
+
+    int submitted = 0;
+    while (submitted < workers && tp_submit(pool, scrub_worker, ctx) == 0){
+        submitted++;
+    }
+    scrub_leave(ctx, workers - submitted + 1);
+
+    if (submitted == 0){
+        scrub_reap(ctx);
+        ctx->started = 0;
+        return -1;
+    }
+    return 0;
+}
+
+int scrub_status(ScrubStats* stats){
+    ScrubCtx* ctx = &scrub_ctx;
+    if (!stats || !ctx->started) return -1;
+
+    if (atomic_load_explicit(&ctx->finished, memory_order_acquire)){
+        scrub_reap(ctx);
+        ctx->reported = 1;
+    }
+    scrub_fill(ctx, stats);
+    return 0;
+}
+
+int scrub_wait(ScrubStats* stats){
+    ScrubCtx* ctx = &scrub_ctx;
+    if (!stats || !ctx->started) return -1;
+
+    scrub_reap(ctx); // tp_destroy espera as threads terminarem
+    ctx->reported = 1;
+    scrub_fill(ctx, stats);
+    return 0;
+}
+
+void scrub_cancel(void){
+    ScrubCtx* ctx = &scrub_ctx;
+    if (ctx->pool && !atomic_load(&ctx->finished)) atomic_store(&ctx->cancel, 1);
+}
+
+int scrub_poll(ScrubStats* stats){
+    ScrubCtx* ctx = &scrub_ctx;
+    if (!stats || !ctx->started || ctx->reported) return 0;
+    if (!atomic_load_explicit(&ctx->finished, memory_order_acquire)) return 0;
+
+    scrub_reap(ctx);
+    ctx->reported = 1;
+    scrub_fill(ctx, stats);
+    return 1;
+}
+
+void scrub_shutdown(void){
+    scrub_cancel();
+    scrub_reap(&scrub_ctx);
+}
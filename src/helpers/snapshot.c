@@ -0,0 +1,427 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fs.h"
+#include "fs_helpers.h"
+#include "fcb_helpers.h"
+#include "blocks.h"
+#include "fs_name.h"
+#include "delalloc.h"
+#include "snapshot.h"
+#include "fs_walk.h"
+#include "fs_usage.h"
+#include "fs_time.h"
+#include "mem.h"
+
+
+// Estado de um nó antes da primeira modificação depois do snapshot
+typedef struct SnapEntry {
+    FsNode* node;               // Nó vivo
+    FsNode  saved;              // Cópia dos campos do nó
+    FCB*    saved_fcb;          // Cópia do FCB (dona do conteúdo e de uma referência aos blocos)
+    struct SnapEntry* next;
+} SnapEntry;
+
+typedef struct SnapNodeList {
+    FsNode* node;
+    struct SnapNodeList* next;
+} SnapNodeList;
+
+typedef struct Snapshot {
+    char name[MAX_NAME_LEN];
+    unsigned int epoch;
+    time_t created_at;
+
+    SnapEntry*    entries;      // Cópias guardadas enquanto este era o snapshot mais novo
+    int           entry_count;
+    SnapNodeList* created;      // Nós criados depois do snapshot
+    SnapNodeList* retired;      // Nós removidos da árvore (liberação adiada)
+
+    struct Snapshot* older;
+    struct Snapshot* newer;
+} Snapshot;
+
+static Snapshot* snap_newest = NULL;
+static Snapshot* snap_oldest = NULL;
+static unsigned int snap_epoch = 0;
+
+
+unsigned int snap_current_epoch(void){
+    return snap_epoch;
+}
+
+static Snapshot* snap_find(const char* name){
+    for (Snapshot* s = snap_newest; s; s = s->older){
+        if (strcmp(s->name, name) == 0) return s;
+    }
+    return NULL;
+}
+
+static int snap_push_node(SnapNodeList** list, FsNode* node){
+    SnapNodeList* item = (SnapNodeList*)mem_alloc(MEM_SNAPSHOT, sizeof(SnapNodeList));
+    if (!item) return -1;
+    item->node = node;
+    item->next = *list;
+    *list = item;
+    return 0;
+}
+
+// Libera uma cópia de FCB (conteúdo e referência aos blocos)
+static void snap_free_fcb_copy(FCB* copy){
+    if (!copy) return;
+    blocks_free_for_file(copy);
+    mem_free(MEM_CONTENT, copy->content);
+    fs_name_release(copy->name);
+    mem_free(MEM_FCB, copy);
+}
+
+static void snap_free_entry(SnapEntry* entry){
+    snap_free_fcb_copy(entry->saved_fcb);
+    fs_name_release(entry->saved.name);
+    mem_free(MEM_SNAPSHOT, entry);
+}
+
+void snap_touch(FsNode* node){
+    // Modificar o nó grava junto o acesso pendente do lazytime
+    if (node && node->lazy_atime){
+        fs_time_flush_node(node);
+    }
+
+    Snapshot* snap = snap_newest;
+    if (!snap || !node) return;
+
+    // Nós criados depois do snapshot somem no rollback; nós já copiados não precisam de nova cópia
+    if (node->born_epoch >= snap->epoch || node->snap_epoch >= snap->epoch){
+        return;
+    }
+
+    SnapEntry* entry = (SnapEntry*)mem_alloc(MEM_SNAPSHOT, sizeof(SnapEntry));
+    if (!entry){
+        fprintf(stderr, "Erro ao alocar memoria para snapshot\n");
+        exit(EXIT_FAILURE);
+    }
+    entry->node      = node;
+    entry->saved     = *node;
+    entry->saved_fcb = NULL;
+    fs_name_retain(node->name); // A cópia guarda o nome da época (mv troca o do nó)
+
+    if (node->fcb){
+        delalloc_commit(node->fcb); // A cópia compartilha blocos: o arquivo precisa ter os seus
+        FCB* copy = (FCB*)mem_alloc(MEM_FCB, sizeof(FCB));
+        if (!copy){
+            fprintf(stderr, "Erro ao alocar memoria para snapshot\n");
+            exit(EXIT_FAILURE);
+        }
+        *copy = *node->fcb;
+        fs_name_retain(copy->name);
+
+        // O mapa de fora do FCB também é duplicado: cada FCB solta o seu
+        if (node->fcb->block_map){
+            copy->block_map = NULL;
+            fcb_map_release(copy);
+            if (fcb_map_reserve(copy, node->fcb->block_count) != 0){
+                fprintf(stderr, "Erro ao alocar memoria para snapshot\n");
+                exit(EXIT_FAILURE);
+            }
+            memcpy(fcb_blocks(copy), node->fcb->block_map, (size_t)node->fcb->block_count * sizeof(int));
+        }
+
+        // Conteúdo em memória é duplicado; os blocos são apenas compartilhados
+        if (node->fcb->content){
+            copy->content = (char*)mem_alloc(MEM_CONTENT, node->fcb->size + 1);
+            if (!copy->content){
+                fprintf(stderr, "Erro ao alocar memoria para snapshot\n");
+                exit(EXIT_FAILURE);
+            }
+            memcpy(copy->content, node->fcb->content, node->fcb->size + 1);
+        }
+        blocks_retain_file(copy);
+        entry->saved_fcb = copy;
+    }
+
+    entry->next   = snap->entries;
+    snap->entries = entry;
+    snap->entry_count++;
+
+    node->snap_epoch = snap->epoch;
+}
+
+void snap_node_created(FsNode* node){
+    if (!node) return;
+
+    node->born_epoch = snap_epoch;
+    node->snap_epoch = snap_epoch;
+
+    if (snap_newest && snap_push_node(&snap_newest->created, node) != 0){
+        fprintf(stderr, "Erro ao alocar memoria para snapshot\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+int snap_retire(FsNode* node){
+    if (!snap_newest || !node) return 0;
+
+    if (snap_push_node(&snap_newest->retired, node) != 0){
+        return 0; // Sem memória: o nó é liberado e o snapshot perde o arquivo
+    }
+    return 1;
+}
+
+// Restaura um nó a partir da cópia, liberando o estado atual
+static void snap_restore_entry(SnapEntry* entry){
+    FsNode* node = entry->node;
+    FCB* live = node->fcb;
+
+    fs_name_release(node->name); // O nó assume a referência guardada na cópia
+    *node = entry->saved;
+
+    if (entry->saved_fcb){
+        FCB* target = node->fcb ? node->fcb : live;
+        blocks_free_for_file(target);
+        mem_free(MEM_CONTENT, target->content);
+        fs_name_release(target->name);
+        *target = *entry->saved_fcb; // Assume o conteúdo e os blocos da cópia
+        node->fcb = target;
+        mem_free(MEM_FCB, entry->saved_fcb);
+        entry->saved_fcb = NULL;
+    } else if (live && !node->fcb){
+        // O FCB foi criado depois do snapshot
+        blocks_free_for_file(live);
+        mem_free(MEM_CONTENT, live->content);
+        fs_name_release(live->name);
+        mem_free(MEM_FCB, live);
+    }
+    mem_free(MEM_SNAPSHOT, entry);
+}
+
+static void snap_free_list(SnapNodeList* list, int free_nodes){
+    while (list){
+        SnapNodeList* next = list->next;
+        if (free_nodes){
+            if (list->node == fs_current_dir){
+                fs_current_dir = fs_root;
+            }
+            fs_free_node(list->node);
+        }
+        mem_free(MEM_SNAPSHOT, list);
+        list = next;
+    }
+}
+
+static void snap_unlink(Snapshot* snap){
+    if (snap->newer) snap->newer->older = snap->older;
+    else             snap_newest = snap->older;
+
+    if (snap->older) snap->older->newer = snap->newer;
+    else             snap_oldest = snap->newer;
+}
+
+// Descarta um snapshot sem vizinho mais antigo: as cópias não são mais necessárias
+static void snap_discard(Snapshot* snap){
+    SnapEntry* entry = snap->entries;
+    while (entry){
+        SnapEntry* next = entry->next;
+        snap_free_entry(entry);
+        entry = next;
+    }
+    snap_free_list(snap->created, 0);
+    snap_free_list(snap->retired, 1); // Nós removidos que só este snapshot segurava
+    mem_free(MEM_SNAPSHOT, snap);
+}
+
+// Conjunto simples de ponteiros (endereçamento aberto) usado na fusão de registros
+typedef struct {
+    FsNode** slots;
+    size_t   mask;
+} SnapPtrSet;
+
+static int snap_set_init(SnapPtrSet* set, int count){
+    size_t cap = 16;
+    while (cap < (size_t)count * 2) cap <<= 1;
+    set->slots = (FsNode**)calloc(cap, sizeof(FsNode*));
+    set->mask  = cap - 1;
+    return set->slots ? 0 : -1;
+}
+
+static size_t snap_set_hash(const FsNode* node, size_t mask){
+    size_t h = (size_t)node;
+    h ^= h >> 17;
+    h *= (size_t)0x9E3779B97F4A7C15ULL;
+    return (h >> 7) & mask;
+}
+
+static void snap_set_add(SnapPtrSet* set, FsNode* node){
+    size_t i = snap_set_hash(node, set->mask);
+    while (set->slots[i] && set->slots[i] != node) i = (i + 1) & set->mask;
+    set->slots[i] = node;
+}
+
+static int snap_set_has(const SnapPtrSet* set, const FsNode* node){
+    size_t i = snap_set_hash(node, set->mask);
+    while (set->slots[i]){
+        if (set->slots[i] == node) return 1;
+        i = (i + 1) & set->mask;
+    }
+    return 0;
+}
+
+// Funde o registro de snap no snapshot imediatamente mais antigo
+static int snap_merge_into_older(Snapshot* snap){
+    Snapshot* older = snap->older;
+
+    SnapPtrSet seen;
+    if (snap_set_init(&seen, older->entry_count) != 0) return -1;
+    for (SnapEntry* e = older->entries; e; e = e->next){
+        snap_set_add(&seen, e->node);
+    }
+
+    SnapEntry* entry = snap->entries;
+    while (entry){
+        SnapEntry* next = entry->next;
+
+        // O mais antigo já tem uma cópia anterior, ou o nó nem existia nele
+        if (snap_set_has(&seen, entry->node) || entry->node->born_epoch >= older->epoch){
+            snap_free_entry(entry);
+        } else {
+            entry->next = older->entries;
+            older->entries = entry;
+            older->entry_count++;
+        }
+        entry = next;
+    }
+    free(seen.slots);
+
+    // Listas de nós criados e removidos passam para o mais antigo
+    SnapNodeList** tail = &older->created;
+    while (*tail) tail = &(*tail)->next;
+    *tail = snap->created;
+
+    tail = &older->retired;
+    while (*tail) tail = &(*tail)->next;
+    *tail = snap->retired;
+
+    mem_free(MEM_SNAPSHOT, snap);
+    return 0;
+}
+
+int snap_create(const char* name){
+    if (!name || strlen(name) == 0 || strlen(name) >= MAX_NAME_LEN) return -1;
+    if (snap_find(name)) return -2;
+
+    fs_time_flush(); // O snapshot precisa enxergar os acessos pendentes
+
+    Snapshot* snap = (Snapshot*)mem_calloc(MEM_SNAPSHOT, 1, sizeof(Snapshot));
+    if (!snap) return -1;
+
+    strcpy(snap->name, name);
+    snap->epoch = ++snap_epoch;
+    snap->created_at = fs_clock_now();
+
+    snap->older = snap_newest;
+    if (snap_newest) snap_newest->newer = snap;
+    else             snap_oldest = snap;
+    snap_newest = snap;
+    return 0;
+}
+
+int snap_rollback(const char* name){
+    Snapshot* target = snap_find(name);
+    if (!target) return -1;
+
+    fs_time_flush();
+
+    // 1) Reaplica as cópias do mais novo até o alvo
+    for (Snapshot* s = snap_newest; s; s = s->older){
+        SnapEntry* entry = s->entries;
+        while (entry){
+            SnapEntry* next = entry->next;
+            snap_restore_entry(entry);
+            entry = next;
+        }
+        s->entries = NULL;
+        s->entry_count = 0;
+        if (s == target) break;
+    }
+
+    // 2) Só depois libera os nós criados após o alvo (as cópias podiam apontar para eles)
+    for (Snapshot* s = snap_newest; s; s = s->older){
+        snap_free_list(s->created, 1);
+        snap_free_list(s->retired, 0); // Nós removidos voltaram para a árvore
+        s->created = NULL;
+        s->retired = NULL;
+        if (s == target) break;
+    }
+
+    // 3) Snapshots mais novos que o alvo deixam de existir
+    while (snap_newest != target){
+        Snapshot* s = snap_newest;
+        snap_unlink(s);
+        mem_free(MEM_SNAPSHOT, s);
+    }
+
+    // Nova época: todos os nós voltam a precisar de cópia na próxima escrita
+    target->epoch = ++snap_epoch;
+
+    // Os nós voltaram ao estado da época, mas os totais dos diretórios não são copiados
+    fs_usage_rebuild(fs_root);
+    return 0;
+}
+
+int snap_remove(const char* name){
+    Snapshot* snap = snap_find(name);
+    if (!snap) return -1;
+
+    Snapshot* older = snap->older;
+    snap_unlink(snap);
+
+    if (!older){
+        snap_discard(snap);
+        return 0;
+    }
+
+    // Restaura o encadeamento para a fusão
+    snap->older = older;
+    return snap_merge_into_older(snap);
+}
+
+void snap_list(void){
+    if (!snap_oldest){
+        printf("Nenhum snapshot\n");
+        return;
+    }
+
+    for (Snapshot* s = snap_oldest; s; s = s->newer){
+        char when[32];
+        struct tm* tm = localtime(&s->created_at);
+        strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", tm);
+        printf("%-20s %s  %d nos copiados\n", s->name, when, s->entry_count);
+    }
+}
+
+void snap_for_each_fcb(void (*fn)(const FCB* fcb, void* arg), void* arg){
+    for (Snapshot* s = snap_newest; s; s = s->older){
+        for (SnapEntry* e = s->entries; e; e = e->next){
+            if (e->saved_fcb) fn(e->saved_fcb, arg);
+        }
+
+        // Nós removidos continuam donos dos seus blocos até o snapshot sumir
+        for (SnapNodeList* item = s->retired; item; item = item->next){
+            FsWalk walk;
+            fs_walk_begin(&walk, item->node, FS_WALK_PREORDER);
+            for (FsNode* node = fs_walk_next(&walk); node; node = fs_walk_next(&walk)){
+                if (node->fcb) fn(node->fcb, arg);
+            }
+        }
+    }
+}
+
+void snap_shutdown(void){
+    while (snap_oldest){
+        Snapshot* s = snap_oldest;
+        snap_unlink(s);
+        snap_discard(s);
+    }
+    snap_epoch = 0;
+}
@@ -0,0 +1,147 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "thread_pool.h"
+
+
+typedef struct TpTask {
+    TpTaskFn fn;
+    void* arg;
+    struct TpTask* next;
+} TpTask;
+
+struct ThreadPool {
+    pthread_t* threads;
+    int thread_count;
+
+    TpTask* head;            // Fila de tarefas (FIFO)
+    TpTask* tail;
+    int pending;             // Tarefas na fila + em execução
+
+    int stopping;
+    pthread_mutex_t lock;
+    pthread_cond_t  has_work;
+    pthread_cond_t  all_done;
+};
+
+
+int tp_default_threads(void){
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (int)n : 1;
+}
+
+static void* tp_worker(void* arg){
+    ThreadPool* pool = (ThreadPool*)arg;
+
+    for (;;){
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->head && !pool->stopping){
+            pthread_cond_wait(&pool->has_work, &pool->lock);
+        }
+        if (!pool->head && pool->stopping){
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+
+        TpTask* task = pool->head;
+        pool->head = task->next;
+        if (!pool->head) pool->tail = NULL;
+        pthread_mutex_unlock(&pool->lock);
+
+        task->fn(task->arg);
+        free(task);
+
+        // Avisa quem espera quando a última tarefa termina
+        pthread_mutex_lock(&pool->lock);
+        pool->pending--;
+        if (pool->pending == 0){
+            pthread_cond_broadcast(&pool->all_done);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+ThreadPool* tp_create(int threads){
+    if (threads <= 0) threads = tp_default_threads();
+
+    ThreadPool* pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+    if (!pool) return NULL;
+
+    pool->threads = (pthread_t*)calloc((size_t)threads, sizeof(pthread_t));
+    if (!pool->threads){
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->has_work, NULL);
+    pthread_cond_init(&pool->all_done, NULL);
+
+    for (int i = 0; i < threads; i++){
+        if (pthread_create(&pool->threads[i], NULL, tp_worker, pool) != 0){
+            break; // Usa as threads que conseguiram ser criadas
+        }
+        pool->thread_count++;
+    }
+
+    if (pool->thread_count == 0){
+        tp_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+int tp_submit(ThreadPool* pool, TpTaskFn fn, void* arg){
+    TpTask* task = (TpTask*)malloc(sizeof(TpTask));
+    if (!task) return -1;
+
+    task->fn   = fn;
+    task->arg  = arg;
+    task->next = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->tail){
+        pool->tail->next = task;
+    } else {
+        pool->head = task;
+    }
+    pool->tail = task;
+    pool->pending++;
+    pthread_cond_signal(&pool->has_work);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+void tp_wait(ThreadPool* pool){
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0){
+        pthread_cond_wait(&pool->all_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int tp_size(const ThreadPool* pool){
+    return pool ? pool->thread_count : 0;
+}
+
+void tp_destroy(ThreadPool* pool){
+    if (!pool) return;
+
+    tp_wait(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->has_work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->thread_count; i++){
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->has_work);
+    pthread_cond_destroy(&pool->all_done);
+    free(pool->threads);
+    free(pool);
+}
@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "trace.h"
+#include "mem.h"
+
+#define TRACE_LABEL_LEN 30
+
+typedef struct {
+    uint64_t ts_ns;
+    long a;
+    long b;
+    unsigned char kind;
+    char phase;                   // 'B' início, 'E' fim, 'i' instantâneo
+    char label[TRACE_LABEL_LEN];  // Copiado: o texto original pode não existir no dump
+} TraceEvent;
+
+// Buffer circular de uma thread. Só a dona escreve; o dump lê depois de head
+typedef struct {
+    TraceEvent events[TRACE_RING_EVENTS];
+    atomic_ulong head;            // Total de eventos já escritos (só a thread dona muda)
+    atomic_ulong base;            // head no último trace_start: eventos anteriores são de outra sessão
+    atomic_int   in_use;          // 0 quando a thread dona terminou (o buffer pode ser reaproveitado)
+} TraceLane;
+
+typedef struct {
+    const char* name;
+    const char* cat;
+    const char* arg_a;            // NULL: argumento não usado
+    const char* arg_b;
+} TraceKindInfo;
+
+static const TraceKindInfo trace_kinds[TRACE_KIND_COUNT] = {
+    [TRACE_CMD]         = { NULL,           "cmd",   "argc",   NULL     },
+    [TRACE_BLOCK_ALLOC] = { "block_alloc",  "bloco", "bloco",  NULL     },
+    [TRACE_BLOCK_RUN]   = { "block_run",    "bloco", "inicio", "blocos" },
+    [TRACE_BLOCK_FREE]  = { "block_free",   "bloco", "bloco",  NULL     },
+    [TRACE_NODE_CREATE] = { "node_create",  "no",    "dir",    NULL     },
+    [TRACE_NODE_MOVE]   = { "node_move",    "no",    NULL,     NULL     },
+    [TRACE_NODE_FREE]   = { "node_free",    "no",    NULL,     NULL     },
+};
+
+atomic_int trace_on = 0;
+
+static TraceLane*      trace_lanes[TRACE_MAX_LANES];
+static atomic_int      trace_lane_count = 0;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;   // Só para registrar threads
+static pthread_key_t   trace_key;
+static pthread_once_t  trace_key_once = PTHREAD_ONCE_INIT;
+static atomic_long     trace_dropped = 0;
+static uint64_t        trace_epoch_ns = 0;
+static atomic_uint     trace_generation = 0;  // Avança a cada trace_shutdown (buffers liberados)
+
+static _Thread_local TraceLane* trace_lane = NULL;
+static _Thread_local int        trace_lane_failed = 0;
+static _Thread_local unsigned   trace_lane_generation = 0; // Geração de trace_lane/trace_lane_failed
+
+
+static uint64_t trace_now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Quando a thread termina, o buffer fica disponível (com os eventos) para a próxima.
+// Um buffer de antes do último trace_shutdown já foi liberado e não é tocado
+static void trace_release_lane(void* lane){
+    if (trace_lane_generation != atomic_load(&trace_generation)) return;
+    atomic_store(&((TraceLane*)lane)->in_use, 0);
+}
+
+static void trace_make_key(void){
+    pthread_key_create(&trace_key, trace_release_lane);
+}
+
+static TraceLane* trace_acquire_lane(void){
+    pthread_once(&trace_key_once, trace_make_key);
+
+    TraceLane* lane = NULL;
+    pthread_mutex_lock(&trace_lock);
+    int count = atomic_load(&trace_lane_count);
+    for (int i = 0; i < count && !lane; i++){
+        if (!atomic_load(&trace_lanes[i]->in_use)) lane = trace_lanes[i];
+    }
+    if (!lane && count < TRACE_MAX_LANES){
+        lane = (TraceLane*)mem_alloc(MEM_TRACE, sizeof(TraceLane));
+        if (lane){
+            atomic_init(&lane->head, 0);
+            atomic_init(&lane->base, 0);
+            trace_lanes[count] = lane;
+            atomic_store(&trace_lane_count, count + 1);
+        }
+    }
+    if (lane) atomic_store(&lane->in_use, 1);
+    trace_lane_generation = atomic_load(&trace_generation); // O buffer é desta geração
+    pthread_mutex_unlock(&trace_lock);
+
+    if (lane) pthread_setspecific(trace_key, lane);
+    return lane;
+}
+
+void trace_record(TraceKind kind, char phase, const char* label, long a, long b){
+    // Depois de desmontar e montar de novo, o buffer guardado pela thread não existe mais
+    unsigned generation = atomic_load_explicit(&trace_generation, memory_order_acquire);
+    if (trace_lane_generation != generation){
+        trace_lane = NULL;
+        trace_lane_failed = 0;
+        trace_lane_generation = generation;
+    }
+
+    TraceLane* lane = trace_lane;
+    if (!lane){
+        if (trace_lane_failed || !(lane = trace_acquire_lane())){
+            trace_lane_failed = 1;
+            atomic_fetch_add_explicit(&trace_dropped, 1, memory_order_relaxed);
+            return;
+        }
+        trace_lane = lane;
+    }
+
+    unsigned long head = atomic_load_explicit(&lane->head, memory_order_relaxed);
+    TraceEvent* ev = &lane->events[head & (TRACE_RING_EVENTS - 1)];
+    ev->ts_ns = trace_now_ns();
+    ev->a     = a;
+    ev->b     = b;
+    ev->kind  = (unsigned char)kind;
+    ev->phase = phase;
+    if (label){
+        strncpy(ev->label, label, TRACE_LABEL_LEN - 1);
+        ev->label[TRACE_LABEL_LEN - 1] = '\0';
+    } else {
+        ev->label[0] = '\0';
+    }
+
+    // Publica o evento: o dump só lê até head
+    atomic_store_explicit(&lane->head, head + 1, memory_order_release);
+}
+
+// Primeiro evento ainda guardado da sessão atual
+static unsigned long trace_first(const TraceLane* lane, unsigned long head){
+    unsigned long base = atomic_load_explicit(&lane->base, memory_order_relaxed);
+    unsigned long kept = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+    return base > kept ? base : kept;
+}
+
+void trace_start(void){
+    // head continua com a thread dona (que pode estar gravando agora); a sessão nova só
+    // marca onde começa em cada buffer
+    int count = atomic_load(&trace_lane_count);
+    for (int i = 0; i < count; i++){
+        atomic_store(&trace_lanes[i]->base, atomic_load(&trace_lanes[i]->head));
+    }
+    atomic_store(&trace_dropped, 0);
+    trace_epoch_ns = trace_now_ns();
+    atomic_store(&trace_on, 1);
+}
+
+void trace_stop(void){
+    atomic_store(&trace_on, 0);
+}
+
+void trace_counts(long* recorded, long* dropped){
+    long total = 0, lost = atomic_load(&trace_dropped);
+    int count = atomic_load(&trace_lane_count);
+    for (int i = 0; i < count; i++){
+        const TraceLane* lane = trace_lanes[i];
+        unsigned long head  = atomic_load_explicit(&lane->head, memory_order_acquire);
+        unsigned long base  = atomic_load_explicit(&lane->base, memory_order_relaxed);
+        unsigned long first = trace_first(lane, head);
+        lost  += (long)(first - base); // Sobrescritos pelo buffer circular
+        total += (long)(head - first);
+    }
+    if (recorded) *recorded = total;
+    if (dropped)  *dropped  = lost;
+}
+
+// Texto do usuário dentro de uma string JSON
+static void trace_write_json_string(FILE* out, const char* text){
+    fputc('"', out);
+    for (const unsigned char* c = (const unsigned char*)text; *c; c++){
+        if (*c == '"' || *c == '\\')  fprintf(out, "\\%c", *c);
+        else if (*c < 0x20)           fprintf(out, "\\u%04x", *c);
+        else                          fputc(*c, out);
+    }
+    fputc('"', out);
+}
+
+static void trace_write_event(FILE* out, const TraceEvent* ev, int tid){
+    const TraceKindInfo* info = &trace_kinds[ev->kind];
+    double ts_us = (double)(int64_t)(ev->ts_ns - trace_epoch_ns) / 1000.0;
+
+    // Comandos aparecem com o próprio nome; os demais eventos levam o nome no argumento
+    fprintf(out, "{\"name\":");
+    trace_write_json_string(out, info->name ? info->name : ev->label);
+    fprintf(out, ",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d",
+            info->cat, ev->phase, ts_us, tid);
+    if (ev->phase == 'i') fprintf(out, ",\"s\":\"t\"");
+
+    if (ev->phase != 'E'){
+        fprintf(out, ",\"args\":{");
+        int first = 1;
+        if (info->name && ev->label[0]){
+            fprintf(out, "\"nome\":");
+            trace_write_json_string(out, ev->label);
+            first = 0;
+        }
+        if (info->arg_a){
+            fprintf(out, "%s\"%s\":%ld", first ? "" : ",", info->arg_a, ev->a);
+            first = 0;
+        }
+        if (info->arg_b){
+            fprintf(out, "%s\"%s\":%ld", first ? "" : ",", info->arg_b, ev->b);
+        }
+        fputc('}', out);
+    }
+    fputc('}', out);
+}
+
+long trace_dump(const char* path){
+    FILE* out = fopen(path, "w");
+    if (!out) return -1;
+
+    long written = 0;
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    int count = atomic_load(&trace_lane_count);
+    for (int lane_index = 0; lane_index < count; lane_index++){
+        TraceLane* lane = trace_lanes[lane_index];
+        unsigned long head  = atomic_load_explicit(&lane->head, memory_order_acquire);
+        unsigned long first = trace_first(lane, head);
+        int tid = lane_index + 1;
+
+        // Um buffer pode ter servido a várias threads em sequência (pools que terminaram)
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                     "\"args\":{\"name\":\"buffer %d\"}}",
+                lane_index > 0 ? ",\n" : "", tid, tid);
+
+        for (unsigned long i = first; i < head; i++){
+            fprintf(out, ",\n");
+            trace_write_event(out, &lane->events[i & (TRACE_RING_EVENTS - 1)], tid);
+            written++;
+        }
+    }
+
+    fprintf(out, "\n]}\n");
+    if (fclose(out) != 0) return -1;
+    return written;
+}
+
+void trace_shutdown(void){
+    atomic_store(&trace_on, 0);
+
+    pthread_mutex_lock(&trace_lock);
+    int count = atomic_load(&trace_lane_count);
+    for (int i = 0; i < count; i++){
+        mem_free(MEM_TRACE, trace_lanes[i]);
+        trace_lanes[i] = NULL;
+    }
+    atomic_store(&trace_lane_count, 0);
+    // Threads que ainda guardam um buffer o largam na próxima gravação ou ao terminar
+    atomic_fetch_add(&trace_generation, 1);
+    pthread_mutex_unlock(&trace_lock);
+
+    // Thread principal: nada a soltar quando ela terminar
+    pthread_once(&trace_key_once, trace_make_key);
+    pthread_setspecific(trace_key, NULL);
+    trace_lane = NULL;
+    trace_lane_failed = 0;
+    trace_lane_generation = atomic_load(&trace_generation);
+}
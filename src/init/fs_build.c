@@ -0,0 +1,361 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+
+#include "fs.h"
+#include "fs_helpers.h"
+#include "fcb_helpers.h"
+#include "blocks.h"
+#include "thread_pool.h"
+#include "fs_build.h"
+#include "fs_usage.h"
+
+#define BUILD_READ_BATCH 64   // Arquivos lidos por tarefa na fase de leitura
+
+
+// Arquivo descoberto na varredura, aguardando leitura
+typedef struct {
+    FCB*  fcb;
+    char* path;       // Caminho no host
+    int   failed;
+} BuildFile;
+
+typedef struct {
+    ThreadPool* pool;
+
+    pthread_mutex_t lock;   // Protege a lista de arquivos
+    BuildFile* files;
+    size_t file_count;
+    size_t file_cap;
+
+    atomic_int dirs;
+    atomic_int skipped;
+} BuildCtx;
+
+// Tarefa de varredura de um diretório
+typedef struct {
+    BuildCtx* ctx;
+    FsNode* dir;
+    char* path;
+} BuildDirJob;
+
+// Tarefa de leitura de uma fatia de arquivos
+typedef struct {
+    BuildCtx* ctx;
+    size_t first;
+    size_t count;
+} BuildReadJob;
+
+
+static double build_now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static char* build_join(const char* dir, const char* name){
+    size_t a = strlen(dir);
+    size_t b = strlen(name);
+    char* path = (char*)malloc(a + b + 2);
+    if (!path) return NULL;
+
+    memcpy(path, dir, a);
+    path[a] = '/';
+    memcpy(path + a + 1, name, b + 1);
+    return path;
+}
+
+// Acrescenta um lote de arquivos na lista global (uma trava por diretório, não por arquivo)
+static int build_push_files(BuildCtx* ctx, BuildFile* batch, size_t count){
+    if (count == 0) return 0;
+
+    pthread_mutex_lock(&ctx->lock);
+    if (ctx->file_count + count > ctx->file_cap){
+        size_t cap = ctx->file_cap ? ctx->file_cap : 1024;
+        while (cap < ctx->file_count + count) cap *= 2;
+
+        BuildFile* grown = (BuildFile*)realloc(ctx->files, cap * sizeof(BuildFile));
+        if (!grown){
+            pthread_mutex_unlock(&ctx->lock);
+            return -1;
+        }
+        ctx->files = grown;
+        ctx->file_cap = cap;
+    }
+    memcpy(&ctx->files[ctx->file_count], batch, count * sizeof(BuildFile));
+    ctx->file_count += count;
+    pthread_mutex_unlock(&ctx->lock);
+    return 0;
+}
+
+static void build_scan_dir(void* arg);
+
+static void build_submit_dir(BuildCtx* ctx, FsNode* dir, char* path){
+    BuildDirJob* job = (BuildDirJob*)malloc(sizeof(BuildDirJob));
+    if (job){
+        job->ctx  = ctx;
+        job->dir  = dir;
+        job->path = path;
+    }
+    if (!job || tp_submit(ctx->pool, build_scan_dir, job) != 0){
+        free(job);
+        free(path);
+        atomic_fetch_add(&ctx->skipped, 1);
+    }
+}
+
+// Varre um diretório do host. Só esta tarefa mexe na lista de filhos de job->dir,
+// então os nós são encadeados sem trava, guardando o último filho.
+static void build_scan_dir(void* arg){
+    BuildDirJob* job = (BuildDirJob*)arg;
+    BuildCtx* ctx = job->ctx;
+
+    DIR* dir = opendir(job->path);
+    if (!dir){
+        atomic_fetch_add(&ctx->skipped, 1);
+        free(job->path);
+        free(job);
+        return;
+    }
+    int dfd = dirfd(dir);
+
+    FsNode* tail = job->dir->first_child;
+    while (tail && tail->next_sibling) tail = tail->next_sibling;
+
+    BuildFile* batch = NULL;
+    size_t batch_count = 0;
+    size_t batch_cap = 0;
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL){
+        const char* name = entry->d_name;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+
+        struct stat st;
+        if (strlen(name) >= MAX_NAME_LEN ||
+            fstatat(dfd, name, &st, AT_SYMLINK_NOFOLLOW) != 0){
+            atomic_fetch_add(&ctx->skipped, 1);
+            continue;
+        }
+
+        FsNode* node = NULL;
+        if (S_ISDIR(st.st_mode)){
+            char* child_path = build_join(job->path, name);
+            if (!child_path){
+                atomic_fetch_add(&ctx->skipped, 1);
+                continue;
+            }
+            node = fs_create_node(name, NODE_DIR, job->dir);
+            atomic_fetch_add(&ctx->dirs, 1);
+            build_submit_dir(ctx, node, child_path);
+        } else if (S_ISREG(st.st_mode) &&
+                   (size_t)st.st_size <= (size_t)FS_MAX_FILE_BLOCKS * FS_BLOCK_SIZE){
+            if (batch_count == batch_cap){
+                size_t cap = batch_cap ? batch_cap * 2 : 64;
+                BuildFile* grown = (BuildFile*)realloc(batch, cap * sizeof(BuildFile));
+                if (!grown){
+                    atomic_fetch_add(&ctx->skipped, 1);
+                    continue;
+                }
+                batch = grown;
+                batch_cap = cap;
+            }
+
+            char* file_path = build_join(job->path, name);
+            if (!file_path){
+                atomic_fetch_add(&ctx->skipped, 1);
+                continue;
+            }
+
+            node = fs_create_node(name, NODE_FILE, job->dir);
+            node->fcb = create_fcb(name, FILETYPE_BINARY);
+            node->fcb->size = (size_t)st.st_size;
+            node->fcb->modified_at = st.st_mtime;
+
+            batch[batch_count].fcb    = node->fcb;
+            batch[batch_count].path   = file_path;
+            batch[batch_count].failed = 0;
+            batch_count++;
+        } else {
+            atomic_fetch_add(&ctx->skipped, 1); // Links, dispositivos ou arquivo grande demais
+            continue;
+        }
+
+        // Encadeia no fim da lista de filhos
+        if (tail){
+            tail->next_sibling = node;
+        } else {
+            job->dir->first_child = node;
+        }
+        tail = node;
+    }
+    closedir(dir);
+
+    if (build_push_files(ctx, batch, batch_count) != 0){
+        // Sem memória para registrar: os arquivos ficam vazios
+        for (size_t i = 0; i < batch_count; i++){
+            batch[i].fcb->size = 0;
+            free(batch[i].path);
+        }
+        atomic_fetch_add(&ctx->skipped, (int)batch_count);
+    }
+    free(batch);
+    free(job->path);
+    free(job);
+}
+
+// Lê uma fatia de arquivos direto para os blocos já atribuídos.
+// Cada arquivo tem uma faixa própria do disco, então não há disputa entre threads.
+static void build_read_files(void* arg){
+    BuildReadJob* job = (BuildReadJob*)arg;
+    BuildCtx* ctx = job->ctx;
+
+    for (size_t i = job->first; i < job->first + job->count; i++){
+        BuildFile* file = &ctx->files[i];
+        if (file->fcb->size == 0) continue;
+
+        int fd = open(file->path, O_RDONLY);
+        if (fd < 0){
+            file->failed = 1;
+            continue;
+        }
+
+        ssize_t got = blocks_readv_file(file->fcb, fd);
+        close(fd);
+        if (got < 0){
+            file->failed = 1;
+        } else {
+            file->fcb->size = (size_t)got;
+        }
+    }
+    free(job);
+}
+
+int fs_build_from_host(const char* host_dir, FsNode* target, int threads, FsBuildStats* stats){
+    FsBuildStats local;
+    memset(&local, 0, sizeof(local));
+    if (stats) memset(stats, 0, sizeof(*stats));
+
+    if (!host_dir || !target || target->type != NODE_DIR){
+        return -1;
+    }
+    if (target->first_child){
+        fprintf(stderr, "build: O diretorio de destino precisa estar vazio\n");
+        return -1;
+    }
+
+    struct stat st;
+    if (stat(host_dir, &st) != 0 || !S_ISDIR(st.st_mode)){
+        fprintf(stderr, "build: '%s' nao e um diretorio\n", host_dir);
+        return -1;
+    }
+
+    double start = build_now();
+
+    BuildCtx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    pthread_mutex_init(&ctx.lock, NULL);
+    atomic_init(&ctx.dirs, 0);
+    atomic_init(&ctx.skipped, 0);
+
+    ctx.pool = tp_create(threads);
+    if (!ctx.pool){
+        pthread_mutex_destroy(&ctx.lock);
+        return -1;
+    }
+
+    // Fase 1: varredura paralela, um diretório por tarefa
+    char* root_path = strdup(host_dir);
+    if (!root_path){
+        tp_destroy(ctx.pool);
+        pthread_mutex_destroy(&ctx.lock);
+        return -1;
+    }
+    build_submit_dir(&ctx, target, root_path);
+    tp_wait(ctx.pool);
+
+    // Fase 2: dimensiona o disco e reserva uma única faixa contígua para tudo
+    long long needed = 0;
+    for (size_t i = 0; i < ctx.file_count; i++){
+        size_t size = ctx.files[i].fcb->size;
+        if (blocks_inline_fits(size)) continue; // Fica dentro do FCB
+        needed += (long long)((size + FS_BLOCK_SIZE - 1) / FS_BLOCK_SIZE);
+    }
+
+    int result = 0;
+    int first_block = -1;
+    if (needed > 0){
+        first_block = blocks_reserve_run((int)needed);
+        if (first_block < 0 && blocks_resize(blocks_total() + (int)needed) == 0){
+            first_block = blocks_reserve_run((int)needed);
+        }
+        if (first_block < 0){
+            fprintf(stderr, "build: Sem memoria para %lld blocos\n", needed);
+            result = -1;
+        }
+    }
+
+    if (result == 0){
+        int next = first_block;
+        for (size_t i = 0; i < ctx.file_count; i++){
+            FCB* fcb = ctx.files[i].fcb;
+            if (fcb->size == 0) continue;
+            if (blocks_inline_fits(fcb->size)){
+                blocks_reserve_for_file(fcb, fcb->size); // A leitura vai direto para inline_data
+                continue;
+            }
+            blocks_assign_run(fcb, next, fcb->size);
+            next += fcb->block_count;
+        }
+
+        // Fase 3: leitura paralela dos arquivos em fatias
+        for (size_t i = 0; i < ctx.file_count; i += BUILD_READ_BATCH){
+            BuildReadJob* job = (BuildReadJob*)malloc(sizeof(BuildReadJob));
+            if (!job) { result = -1; break; }
+            job->ctx   = &ctx;
+            job->first = i;
+            job->count = (ctx.file_count - i < BUILD_READ_BATCH) ? ctx.file_count - i : BUILD_READ_BATCH;
+            if (tp_submit(ctx.pool, build_read_files, job) != 0){
+                free(job);
+                result = -1;
+                break;
+            }
+        }
+        tp_wait(ctx.pool);
+    }
+    tp_destroy(ctx.pool);
+
+    // Arquivos que não puderam ser lidos ficam vazios e devolvem os blocos
+    for (size_t i = 0; i < ctx.file_count; i++){
+        BuildFile* file = &ctx.files[i];
+        if (file->failed || result != 0){
+            blocks_free_for_file(file->fcb);
+            file->fcb->size = 0;
+            if (file->failed) local.skipped++;
+        }
+        local.bytes  += file->fcb->size;
+        local.blocks += file->fcb->block_count;
+        free(file->path);
+    }
+
+    local.dirs     = atomic_load(&ctx.dirs);
+    local.files    = (int)ctx.file_count;
+    local.skipped += atomic_load(&ctx.skipped);
+    local.seconds  = build_now() - start;
+
+    free(ctx.files);
+    pthread_mutex_destroy(&ctx.lock);
+
+    // Os nós foram encadeados direto pelas threads: os totais dos diretórios saem de uma passada só
+    fs_usage_rebuild(target);
+
+    if (stats) *stats = local;
+    return result;
+}
@@ -1,25 +1,38 @@
-#include <stdio.h>
-#include "fs.h"
-#include "fs_helpers.h"
-#include "blocks.h"
-#include "fs_helpers.h"
-
-
-void fs_init(){
-    blocks_init();
-    printf("Inicializando sistema de arquivos...\n");
-
-    //Cria o diretório raíz
-    fs_root = fs_create_node("/", NODE_DIR, NULL);
-    fs_current_dir = fs_root;
-}
-
-
-// Desliga o sistema de arquivos
-void fs_shutdown(){
-    printf("Desligando sistema de arquivos\n");
-    fs_free_tree(fs_root);
-    fs_root = NULL;
-    fs_current_dir = NULL;
-    blocks_shutdown();
+#include "fs.h"
+#include "fs_helpers.h"
+#include "blocks.h"
+#include "fs_name.h"
+#include "blkio.h"
+#include "delalloc.h"
+#include "snapshot.h"
+#include "fs_time.h"
+#include "trace.h"
+#include "fs_usage.h"
+#include "scrub.h"
+
+
+void fs_init(){
+    blocks_init();
+    fs_clock_tick();
+
+    //Cria o diretório raíz
+    fs_root = fs_create_node("/", NODE_DIR, NULL);
+    fs_current_dir = fs_root;
+}
+
+
+// Desliga o sistema de arquivos
+void fs_shutdown(){
+    scrub_shutdown(); // As threads do scrub leem os blocos até o fim
+    fs_time_flush(); // Grava os acessos pendentes antes de desmontar
+    if (blkio_is_open()) delalloc_flush(); // Sem imagem nada sobrevive: os pendentes só são soltos
+    fs_free_tree(fs_root);
+    fs_root = NULL;
+    fs_current_dir = NULL;
+    snap_shutdown();
+    delalloc_shutdown();
+    blocks_shutdown();
+    trace_shutdown();
+    fs_usage_shutdown();
+    fs_name_shutdown();
 }
\ No newline at end of file
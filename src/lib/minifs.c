@@ -0,0 +1,473 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "fs.h"
+#include "fs_helpers.h"
+#include "fcb_helpers.h"
+#include "permissions.h"
+#include "blocks.h"
+#include "blkio.h"
+#include "delalloc.h"
+#include "snapshot.h"
+#include "fs_time.h"
+#include "fs_usage.h"
+#include "mem.h"
+#include "minifs.h"
+
+
+// Tabela de arquivos abertos: o descritor é a posição na tabela
+typedef struct {
+    FsNode* node;       // Nó resolvido no open (NULL = posição livre)
+    FCB*    fcb;        // FCB do arquivo: mapa de blocos, tamanho e conteúdo
+    size_t  offset;     // Deslocamento usado por mfs_read/mfs_write
+    int     flags;
+    int     stale;      // O nó foi liberado com o descritor aberto
+    FsNode* cursor;     // Diretório: próxima entrada do mfs_readdir
+    int     next_free;  // Próxima posição livre (pilha de livres)
+} MfsFile;
+
+static MfsFile mfs_files[MFS_MAX_OPEN];
+static int mfs_free_head = -1;
+static int mfs_open_count = 0;
+static int mfs_mounted = 0;
+
+
+static void mfs_table_reset(void){
+    memset(mfs_files, 0, sizeof(mfs_files));
+    for (int i = 0; i < MFS_MAX_OPEN; i++){
+        mfs_files[i].next_free = i + 1 < MFS_MAX_OPEN ? i + 1 : -1;
+    }
+    mfs_free_head = 0;
+    mfs_open_count = 0;
+}
+
+int mfs_mount(const char* image){
+    if (mfs_mounted) return -EBUSY;
+
+    fs_init();
+    if (image && blocks_attach_image(image, BLKIO_DEFAULT_QUEUE_DEPTH, 1) != 0){
+        int err = errno ? errno : EIO;
+        fs_shutdown();
+        return -err;
+    }
+    mfs_table_reset();
+    mfs_mounted = 1;
+    return 0;
+}
+
+void mfs_unmount(void){
+    if (!mfs_mounted) return;
+    mfs_table_reset();
+    mfs_mounted = 0;
+    fs_shutdown();
+}
+
+// Descritor aberto e ainda válido
+static MfsFile* mfs_file(int fd){
+    if (fd < 0 || fd >= MFS_MAX_OPEN || !mfs_files[fd].node) return NULL;
+    return &mfs_files[fd];
+}
+
+// Resolve o caminho até o último componente. *node fica NULL se só ele não existir;
+// leaf recebe o nome do último componente (para criar o arquivo)
+static int mfs_lookup(const char* path, FsNode** parent, FsNode** node, char leaf[MAX_NAME_LEN]){
+    if (!mfs_mounted) return -ENODEV;
+    if (!path || !*path) return -ENOENT;
+
+    FsNode* dir = (*path == '/') ? fs_root : fs_current_dir;
+    FsNode* up  = dir->parent;
+    leaf[0] = '\0';
+
+    const char* p = path;
+    while (*p){
+        while (*p == '/') p++;
+        if (!*p) break;
+
+        const char* end = strchr(p, '/');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len >= MAX_NAME_LEN) return -ENAMETOOLONG;
+        if (!dir) return -ENOENT;          // Componente anterior não existe
+        if (dir->type != NODE_DIR) return -ENOTDIR;
+
+        memcpy(leaf, p, len);
+        leaf[len] = '\0';
+        p += len;
+
+        if (strcmp(leaf, ".") == 0) continue;
+        if (strcmp(leaf, "..") == 0){
+            if (dir->parent) dir = dir->parent;
+            up = dir->parent;
+            continue;
+        }
+        up  = dir;
+        dir = fs_find_child(dir, leaf);
+    }
+
+    *parent = up;
+    *node   = dir;
+    return 0;
+}
+
+static void mfs_fill_stat(const FsNode* node, MfsStat* st){
+    memset(st, 0, sizeof(*st));
+    st->is_dir = node->type == NODE_DIR;
+
+    const FCB* fcb = node->fcb;
+    if (!fcb) return;
+    st->size        = fcb->size;
+    st->physical    = blocks_physical_size(fcb);
+    st->blocks      = blocks_allocated(fcb);
+    st->inode       = fcb->inode;
+    st->permissions = fcb->permissions;
+    st->owner       = fcb->owner;
+    st->created_at  = fcb->created_at;
+    st->modified_at = fcb->modified_at;
+    st->accessed_at = fs_time_accessed(node);
+}
+
+// Garante o conteúdo em memória (arquivos importados só têm os blocos)
+static int mfs_load_content(FCB* fcb){
+    if (fcb->content || fcb->size == 0) return 0;
+
+    char* data = (char*)mem_alloc(MEM_CONTENT, fcb->size + 1);
+    if (!data) return -ENOMEM;
+    if (blocks_read_file(fcb, 0, data, fcb->size) != (ssize_t)fcb->size){
+        mem_free(MEM_CONTENT, data);
+        return -EIO;
+    }
+    data[fcb->size] = '\0';
+    fcb->content = data;
+    return 0;
+}
+
+// Sem espaço para a versão nova: aloca de novo a versão que está em fcb->content
+static void mfs_restore(FCB* fcb){
+    if (fcb->size > 0 && delalloc_write(fcb) != 0){
+        // Nem a versão anterior coube: o arquivo fica vazio (como no write da shell)
+        blocks_free_for_file(fcb);
+        mem_free(MEM_CONTENT, fcb->content);
+        fcb->content = NULL;
+        fcb->size = 0;
+    }
+}
+
+// Troca o conteúdo do arquivo e (re)aloca os blocos, como o write da shell.
+// Sem espaço, a versão anterior volta para o arquivo
+static int mfs_store(FCB* fcb, char* data, size_t size){
+    char*  old      = fcb->content;
+    size_t old_size = fcb->size;
+
+    fcb->content = data;
+    fcb->size    = size;
+    if (delalloc_write(fcb) == 0){
+        mem_free(MEM_CONTENT, old);
+        return 0;
+    }
+
+    fcb->content = old;
+    fcb->size    = old_size;
+    mfs_restore(fcb);
+    mem_free(MEM_CONTENT, data);
+    return -ENOSPC;
+}
+
+// Grava [offset, offset + len) direto na cópia em memória, que cresce dobrando de
+// capacidade, e estende a reserva da alocação adiada só pelos blocos que a gravação
+// acrescenta. Inline, compressão e deduplicação recodificam o arquivo inteiro de
+// qualquer forma: nesses casos a versão nova é montada à parte e regravada
+static int mfs_write_content(FCB* fcb, const char* buf, size_t len, size_t offset){
+    size_t size = offset + len > fcb->size ? offset + len : fcb->size;
+
+    size_t capacity = mem_capacity(fcb->content);
+    if (size + 1 > capacity){
+        capacity = capacity * 2 > size + 1 ? capacity * 2 : size + 1;
+        char* grown = (char*)mem_realloc(MEM_CONTENT, fcb->content, capacity);
+        if (!grown) return -ENOMEM;
+        fcb->content = grown;
+    }
+
+    int reserved = delalloc_grow(fcb, size);
+    if (reserved < 0){
+        if (!fcb->delalloc) mfs_restore(fcb); // Os blocos antigos já tinham sido soltos
+        return -ENOSPC;
+    }
+
+    if (reserved > 0){
+        char* data = (char*)mem_alloc(MEM_CONTENT, size + 1);
+        if (!data) return -ENOMEM;
+        memcpy(data, fcb->content, fcb->size);
+        if (offset > fcb->size) memset(data + fcb->size, 0, offset - fcb->size);
+        memcpy(data + offset, buf, len);
+        data[size] = '\0';
+        return mfs_store(fcb, data, size);
+    }
+
+    if (offset > fcb->size) memset(fcb->content + fcb->size, 0, offset - fcb->size);
+    memcpy(fcb->content + offset, buf, len);
+    fcb->content[size] = '\0';
+    fcb->size = size;
+    return 0;
+}
+
+static int mfs_truncate(FsNode* node, size_t size){
+    FCB* fcb = node->fcb;
+    if (fcb->size == size) return 0;
+    if (fs_usage_check(node->parent, fcb->owner, fs_usage_truncate_blocks(fcb, size), 0, NULL) != 0){
+        return -EDQUOT;
+    }
+
+    snap_touch(node);
+    int err = blocks_truncate_file(fcb, size) == 0 ? 0 : -ENOSPC;
+    fs_usage_refresh(node);
+    if (err) return err;
+
+    fs_time_modify(fcb);
+    return 0;
+}
+
+int mfs_open(const char* path, int flags){
+    FsNode* parent = NULL;
+    FsNode* node = NULL;
+    char leaf[MAX_NAME_LEN];
+
+    int err = mfs_lookup(path, &parent, &node, leaf);
+    if (err) return err;
+
+    int mode = flags & MFS_O_ACCMODE;
+    if (mode == MFS_O_ACCMODE) return -EINVAL;
+    int writing = mode != MFS_O_RDONLY;
+    fs_clock_tick();
+
+    if (!node){
+        if (!(flags & MFS_O_CREAT)) return -ENOENT;
+        if (!parent || parent->type != NODE_DIR) return -ENOENT;
+        if (!leaf[0] || strcmp(leaf, ".") == 0 || strcmp(leaf, "..") == 0) return -EINVAL;
+        if (fs_usage_check(parent, fs_current_user_class, 0, 1, NULL) != 0) return -EDQUOT;
+
+        node = fs_create_node(leaf, NODE_FILE, parent);
+        node->fcb = create_fcb(leaf, FILETYPE_BINARY);
+        fs_add_child(parent, node);
+    } else if (node->type == NODE_DIR){
+        if (writing || (flags & (MFS_O_TRUNC | MFS_O_APPEND))) return -EISDIR;
+    } else {
+        if (!node->fcb){
+            snap_touch(node);
+            node->fcb = create_fcb(node->name, FILETYPE_BINARY);
+        }
+        if (mode != MFS_O_WRONLY && !perms_can_read(node->fcb)) return -EACCES;
+        if (writing && !perms_can_write(node->fcb)) return -EACCES;
+        if (flags & MFS_O_TRUNC){
+            if (!writing) return -EACCES;
+            int err = mfs_truncate(node, 0);
+            if (err) return err;
+        }
+    }
+
+    if (mfs_free_head < 0) return -EMFILE;
+    int fd = mfs_free_head;
+    MfsFile* f = &mfs_files[fd];
+    mfs_free_head = f->next_free;
+
+    f->node   = node;
+    f->fcb    = node->fcb;
+    f->offset = 0;
+    f->flags  = flags;
+    f->stale  = 0;
+    f->cursor = node->type == NODE_DIR ? node->first_child : NULL;
+    mfs_open_count++;
+    return fd;
+}
+
+int mfs_close(int fd){
+    MfsFile* f = mfs_file(fd);
+    if (!f) return -EBADF;
+
+    memset(f, 0, sizeof(*f));
+    f->next_free = mfs_free_head;
+    mfs_free_head = fd;
+    mfs_open_count--;
+    return 0;
+}
+
+static ssize_t mfs_read_at(MfsFile* f, char* buf, size_t len, size_t offset){
+    if (f->stale) return -ESTALE;
+    if (f->node->type == NODE_DIR) return -EISDIR;
+    if ((f->flags & MFS_O_ACCMODE) == MFS_O_WRONLY) return -EBADF;
+
+    FCB* fcb = f->fcb;
+    if (offset >= fcb->size || len == 0) return 0;
+    if (len > fcb->size - offset) len = fcb->size - offset;
+
+    ssize_t got = blocks_read_file(fcb, offset, buf, len);
+    if (got < 0){
+        if (!fcb->content) return -EIO; // Bloco corrompido e sem cópia em memória
+        memcpy(buf, fcb->content + offset, len);
+        got = (ssize_t)len;
+    }
+    fs_time_access(f->node);
+    return got;
+}
+
+ssize_t mfs_read(int fd, void* buf, size_t len){
+    MfsFile* f = mfs_file(fd);
+    if (!f) return -EBADF;
+
+    ssize_t got = mfs_read_at(f, (char*)buf, len, f->offset);
+    if (got > 0) f->offset += (size_t)got;
+    return got;
+}
+
+ssize_t mfs_pread(int fd, void* buf, size_t len, size_t offset){
+    MfsFile* f = mfs_file(fd);
+    if (!f) return -EBADF;
+    return mfs_read_at(f, (char*)buf, len, offset);
+}
+
+ssize_t mfs_write(int fd, const void* buf, size_t len){
+    MfsFile* f = mfs_file(fd);
+    if (!f) return -EBADF;
+    if (f->stale) return -ESTALE;
+    if (f->node->type == NODE_DIR) return -EISDIR;
+    if ((f->flags & MFS_O_ACCMODE) == MFS_O_RDONLY) return -EBADF;
+    if (len == 0) return 0;
+
+    FCB* fcb = f->fcb;
+    size_t offset = (f->flags & MFS_O_APPEND) ? fcb->size : f->offset;
+    size_t limit  = blocks_max_file_size();
+    if (offset > limit || len > limit - offset) return -EFBIG;
+
+    long blocks = fs_usage_estimate_blocks(offset + len > fcb->size ? offset + len : fcb->size) -
+                  fs_usage_file_blocks(fcb);
+    if (fs_usage_check(f->node->parent, fcb->owner, blocks, 0, NULL) != 0) return -EDQUOT;
+
+    int err = mfs_load_content(fcb);
+    if (err) return err;
+
+    fs_clock_tick();
+    delalloc_tick();
+    snap_touch(f->node);
+    err = mfs_write_content(fcb, (const char*)buf, len, offset);
+    fs_usage_refresh(f->node);
+    if (err) return err;
+
+    fs_time_modify(fcb);
+    f->offset = offset + len;
+    return (ssize_t)len;
+}
+
+int mfs_ftruncate(int fd, size_t size){
+    MfsFile* f = mfs_file(fd);
+    if (!f) return -EBADF;
+    if (f->stale) return -ESTALE;
+    if (f->node->type == NODE_DIR) return -EISDIR;
+    if ((f->flags & MFS_O_ACCMODE) == MFS_O_RDONLY) return -EBADF;
+    if (size > blocks_max_file_size()) return -EFBIG;
+
+    fs_clock_tick();
+    delalloc_tick();
+    return mfs_truncate(f->node, size);
+}
+
+int mfs_stat(const char* path, MfsStat* st){
+    FsNode* parent = NULL;
+    FsNode* node = NULL;
+    char leaf[MAX_NAME_LEN];
+
+    if (!st) return -EINVAL;
+    int err = mfs_lookup(path, &parent, &node, leaf);
+    if (err) return err;
+    if (!node) return -ENOENT;
+
+    mfs_fill_stat(node, st);
+    return 0;
+}
+
+int mfs_fstat(int fd, MfsStat* st){
+    MfsFile* f = mfs_file(fd);
+    if (!f) return -EBADF;
+    if (!st) return -EINVAL;
+    if (f->stale) return -ESTALE;
+
+    mfs_fill_stat(f->node, st);
+    return 0;
+}
+
+int mfs_readdir(int fd, MfsDirent* entry){
+    MfsFile* f = mfs_file(fd);
+    if (!f) return -EBADF;
+    if (!entry) return -EINVAL;
+    if (f->stale) return -ESTALE;
+    if (f->node->type != NODE_DIR) return -ENOTDIR;
+
+    FsNode* node = f->cursor;
+    if (!node) return 0;
+    f->cursor = node->next_sibling;
+
+    entry->name   = node->name;
+    entry->is_dir = node->type == NODE_DIR;
+    entry->size   = node->fcb ? node->fcb->size : 0;
+    entry->inode  = node->fcb ? node->fcb->inode : 0;
+    return 1;
+}
+
+int mfs_mkdir(const char* path){
+    FsNode* parent = NULL;
+    FsNode* node = NULL;
+    char leaf[MAX_NAME_LEN];
+
+    int err = mfs_lookup(path, &parent, &node, leaf);
+    if (err) return err;
+    if (node) return -EEXIST;
+    if (!parent || parent->type != NODE_DIR) return -ENOENT;
+    if (!leaf[0] || strcmp(leaf, ".") == 0 || strcmp(leaf, "..") == 0) return -EINVAL;
+
+    if (fs_usage_check(parent, FS_USAGE_NO_OWNER, 0, 1, NULL) != 0) return -EDQUOT;
+
+    fs_clock_tick();
+    fs_add_child(parent, fs_create_node(leaf, NODE_DIR, parent));
+    return 0;
+}
+
+int mfs_unlink(const char* path){
+    FsNode* parent = NULL;
+    FsNode* node = NULL;
+    char leaf[MAX_NAME_LEN];
+
+    int err = mfs_lookup(path, &parent, &node, leaf);
+    if (err) return err;
+    if (!node) return -ENOENT;
+    if (node->type == NODE_DIR) return -EISDIR;
+    if (node->fcb && !perms_can_write(node->fcb)) return -EACCES;
+
+    fs_remove_child(node->parent, node);
+    return 0;
+}
+
+void mfs_node_unlinked(const void* node){
+    if (mfs_open_count == 0) return;
+
+    // Leituras de diretório paradas no nó seguem para o próximo irmão
+    const FsNode* gone = (const FsNode*)node;
+    for (int i = 0; i < MFS_MAX_OPEN; i++){
+        if (mfs_files[i].node && mfs_files[i].cursor == gone){
+            mfs_files[i].cursor = gone->next_sibling;
+        }
+    }
+}
+
+void mfs_node_freed(const void* node){
+    if (mfs_open_count == 0) return;
+
+    for (int i = 0; i < MFS_MAX_OPEN; i++){
+        MfsFile* f = &mfs_files[i];
+        if (!f->node) continue;
+        if (f->node == node){
+            f->stale = 1; // O descritor continua ocupado até o mfs_close
+        }
+        if (f->cursor == node){
+            f->cursor = NULL;
+        }
+    }
+}
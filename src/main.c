@@ -1,8 +1,108 @@
-#include "fs.h"
-
-int main(void) {
-    fs_init();
-    fs_shell_loop();
-    fs_shutdown();
-    return 0;
-}
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "fs.h"
+#include "fs_build.h"
+#include "checkpoint.h"
+#include "fs_time.h"
+#include "blocks.h"
+#include "blkio.h"
+
+static void print_usage(const char* prog){
+    printf("Uso: %s [--build <diretorio_host> | --restore <arquivo>] [--threads N] [-o opcoes]\n", prog);
+    printf("          [--image <arquivo>] [--queue-depth N] [--no-uring]\n");
+    printf("  --build <dir>   Popula o sistema de arquivos a partir de um diretorio do host\n");
+    printf("  --restore <arq> Recria o namespace de um arquivo gravado pelo comando checkpoint\n");
+    printf("  --threads N     Threads usadas pelo --build e pelo --restore (padrao: processadores online)\n");
+    printf("  -o opcoes       Opcoes de montagem: strictatime, relatime, noatime, lazytime\n");
+    printf("  --image <arq>   Guarda os blocos em um arquivo de imagem do host\n");
+    printf("  --queue-depth N Requisicoes por lote na imagem (padrao: %d)\n", BLKIO_DEFAULT_QUEUE_DEPTH);
+    printf("  --no-uring      Usa pread/pwrite em threads em vez de io_uring\n");
+}
+
+int main(int argc, char** argv) {
+    const char* build_dir = NULL;
+    const char* restore = NULL;
+    int threads = 0;
+    const char* image = NULL;
+    int queue_depth = BLKIO_DEFAULT_QUEUE_DEPTH;
+    int use_uring = 1;
+
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "--build") == 0 && i + 1 < argc){
+            build_dir = argv[++i];
+        } else if (strcmp(argv[i], "--restore") == 0 && i + 1 < argc){
+            restore = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc){
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc){
+            if (fs_time_set_options(argv[++i]) != 0){
+                printf("Opcao de montagem invalida: '%s'\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--image") == 0 && i + 1 < argc){
+            image = argv[++i];
+        } else if (strcmp(argv[i], "--queue-depth") == 0 && i + 1 < argc){
+            queue_depth = atoi(argv[++i]);
+            if (queue_depth <= 0){
+                printf("Profundidade de fila invalida: '%s'\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--no-uring") == 0){
+            use_uring = 0;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (build_dir && restore){
+        print_usage(argv[0]); // Os dois precisam da raíz vazia
+        return 1;
+    }
+
+    printf("Inicializando sistema de arquivos...\n");
+    fs_init();
+
+    if (image){
+        if (blocks_attach_image(image, queue_depth, use_uring) != 0){
+            printf("Falha ao abrir a imagem '%s': %s\n", image, strerror(errno));
+            printf("Desligando sistema de arquivos\n");
+            fs_shutdown();
+            return 1;
+        }
+        printf("Imagem '%s' (%s, fila %d)\n", blkio_path(), blkio_backend_name(), blkio_queue_depth());
+    }
+
+    if (build_dir){
+        FsBuildStats stats;
+        if (fs_build_from_host(build_dir, fs_root, threads, &stats) != 0){
+            printf("Falha ao construir a partir de '%s'\n", build_dir);
+        }
+        printf("Construido a partir de '%s': %d diretorios, %d arquivos, %d blocos, %zu bytes em %.3f s (ignorados: %d)\n",
+               build_dir, stats.dirs, stats.files, stats.blocks, stats.bytes, stats.seconds, stats.skipped);
+    }
+
+    if (restore){
+        CheckpointStats stats;
+        if (checkpoint_restore(restore, threads, &stats) != 0){
+            if (errno == EBADMSG){
+                printf("Falha ao restaurar '%s': checkpoint invalido ou corrompido\n", restore);
+            } else {
+                printf("Falha ao restaurar '%s': %s\n", restore, strerror(errno));
+            }
+            printf("Desligando sistema de arquivos\n");
+            fs_shutdown();
+            return 1;
+        }
+        printf("Restaurado de '%s': %ld diretorios, %ld arquivos, %ld blocos, %zu bytes em %.3f s\n",
+               restore, stats.dirs, stats.files, stats.blocks, stats.bytes, stats.seconds);
+    }
+
+    fs_shell_loop();
+    printf("Desligando sistema de arquivos\n");
+    fs_shutdown();
+    return 0;
+}